@@ -0,0 +1,134 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include "nms.h"
+
+using namespace helmet;
+
+/**
+ * @brief straightforward NMS as reference, sort everything and test each pair with a division.
+ */
+void referenceNms(const BoxesSoA &boxes, const NmsParams &params, std::vector<int> &keep)
+{
+	std::vector<int> order;
+	for (size_t i = 0; i < boxes.Size(); ++i) {
+		if (boxes.score[i] >= params.score_threshold)order.push_back((int)i);
+	}
+	std::sort(order.begin(), order.end(), [&](int a, int b) {
+		return boxes.score[a] > boxes.score[b] || (boxes.score[a] == boxes.score[b] && a < b);
+	});
+	if (params.pre_top_k > 0 && order.size() > (size_t)params.pre_top_k)order.resize(params.pre_top_k);
+	std::vector<bool> suppressed(order.size(), false);
+	keep.clear();
+	for (size_t k = 0; k < order.size(); ++k) {
+		if (suppressed[k])continue;
+		const int a = order[k];
+		keep.push_back(a);
+		if (params.top_k > 0 && keep.size() >= (size_t)params.top_k)break;
+		const float area_a = (boxes.x2[a] - boxes.x1[a]) * (boxes.y2[a] - boxes.y1[a]);
+		for (size_t j = k + 1; j < order.size(); ++j) {
+			const int b = order[j];
+			if (boxes.cls[a] != boxes.cls[b])continue;
+			const float w = std::max(0.0f, std::min(boxes.x2[a], boxes.x2[b]) - std::max(boxes.x1[a], boxes.x1[b]));
+			const float h = std::max(0.0f, std::min(boxes.y2[a], boxes.y2[b]) - std::max(boxes.y1[a], boxes.y1[b]));
+			const float inter = w * h;
+			const float area_b = (boxes.x2[b] - boxes.x1[b]) * (boxes.y2[b] - boxes.y1[b]);
+			if (inter / (area_a + area_b - inter) > params.iou_threshold)suppressed[j] = true;
+		}
+	}
+}
+
+/**
+ * @brief generate raw YOLOv5 style outputs, boxes are clustered around a few objects like a real detector.
+ * @param num number of anchors.
+ * @param classes number of classes.
+ * @param raw output tensor.
+ */
+void genRaw(int num, int classes, std::vector<float> &raw)
+{
+	std::mt19937 rng(7);
+	std::uniform_real_distribution<float> uni(0.0f, 1.0f);
+	std::normal_distribution<float> jitter(0.0f, 6.0f);
+	const int objects = 40;
+	std::vector<float> cx(objects), cy(objects), w(objects), h(objects);
+	for (int o = 0; o < objects; ++o) {
+		cx[o] = 30.0f + uni(rng) * 550.0f;
+		cy[o] = 30.0f + uni(rng) * 550.0f;
+		w[o] = 20.0f + uni(rng) * 120.0f;
+		h[o] = 20.0f + uni(rng) * 160.0f;
+	}
+	const int stride = 5 + classes;
+	raw.assign((size_t)num * stride, 0.0f);
+	for (int n = 0; n < num; ++n) {
+		float *row = &raw[(size_t)n * stride];
+		const int o = n % objects;
+		row[0] = cx[o] + jitter(rng);
+		row[1] = cy[o] + jitter(rng);
+		row[2] = std::max(4.0f, w[o] + jitter(rng));
+		row[3] = std::max(4.0f, h[o] + jitter(rng));
+		row[4] = uni(rng);
+		for (int c = 0; c < classes; ++c) {
+			row[5 + c] = uni(rng);
+		}
+	}
+}
+
+/**
+ * @example
+ * @param argc number of input params.
+ * @param argv [iterations] [classes] [score threshold] [pre top k], defaults to 100 2 0.25 1000.
+ * @return
+ */
+int main(int argc, char **argv)
+{
+	int iters = argc > 1 ? std::atoi(argv[1]) : 100;
+	int classes = argc > 2 ? std::atoi(argv[2]) : 2;
+	NmsParams params;
+	params.score_threshold = argc > 3 ? (float)std::atof(argv[3]) : 0.25f;
+	params.pre_top_k = argc > 4 ? std::atoi(argv[4]) : 1000;
+	if (iters <= 0 || classes <= 0) {
+		std::cerr << "Invalid arguments." << std::endl;
+		return -1;
+	}
+	std::cout << "Classes: " << classes << ", score threshold: " << params.score_threshold
+			  << ", pre top k: " << params.pre_top_k << ", iterations: " << iters << std::endl;
+
+	HostNms nms;
+	BoxesSoA boxes;
+	std::vector<int> keep, expected;
+	std::vector<float> raw;
+	for (int num : {1000, 10000, 50000}) {
+		genRaw(num, classes, raw);
+		nms.Decode(raw.data(), raw.size(), RawFormat::YOLOV5, classes, params.score_threshold, boxes);
+		nms.Run(boxes, params, keep);
+		referenceNms(boxes, params, expected);
+		if (keep != expected) {
+			std::cerr << "Mismatch with reference at " << num << " boxes: " << keep.size()
+					  << " vs " << expected.size() << std::endl;
+			return -1;
+		}
+
+		auto start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < iters; ++i) {
+			nms.Decode(raw.data(), raw.size(), RawFormat::YOLOV5, classes, params.score_threshold, boxes);
+		}
+		auto decode = std::chrono::high_resolution_clock::now() - start;
+		start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < iters; ++i) {
+			nms.Run(boxes, params, keep);
+		}
+		auto host = std::chrono::high_resolution_clock::now() - start;
+		start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < iters; ++i) {
+			referenceNms(boxes, params, expected);
+		}
+		auto ref = std::chrono::high_resolution_clock::now() - start;
+
+		std::cout << num << " boxes, " << boxes.Size() << " candidates, " << keep.size() << " kept: decode "
+				  << std::chrono::duration<double, std::milli>(decode).count() / iters << "ms, nms "
+				  << std::chrono::duration<double, std::milli>(host).count() / iters << "ms, reference "
+				  << std::chrono::duration<double, std::milli>(ref).count() / iters << "ms" << std::endl;
+	}
+	return 0;
+}
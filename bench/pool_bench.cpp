@@ -0,0 +1,124 @@
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <opencv2/imgproc.hpp>
+#include "yuv_convert.h"
+#include "work_pool.h"
+
+using namespace helmet;
+
+/**
+ * @brief one stream's CPU preprocessing, the fused YUV resize followed by normalize and HWC to CHW.
+ */
+struct StreamWork
+{
+	YUVResizer resizer;
+	cv::Mat resized;
+	std::vector<float> blob;
+
+	explicit StreamWork(const cv::Size &target)
+		: resized(target, CV_8UC3), blob((size_t)target.area() * 3)
+	{
+	}
+
+	void Run(const cv::Mat &nv12, int interp)
+	{
+		resizer.Run(nv12, PixelFormat::NV12, resized, cv::Mat(), interp);
+		const size_t plane = resized.total();
+		const int cols = resized.cols;
+		float *dst = blob.data();
+		WorkPool::Instance().ParallelFor(0, resized.rows, 16, [&](int begin, int end) {
+			for (int y = begin; y < end; ++y) {
+				const unsigned char *src = resized.ptr<unsigned char>(y);
+				size_t k = (size_t)y * cols;
+				for (int x = 0; x < cols; ++x, ++k) {
+					dst[k] = src[3 * x] * 0.00392157f;
+					dst[plane + k] = src[3 * x + 1] * 0.00392157f;
+					dst[2 * plane + k] = src[3 * x + 2] * 0.00392157f;
+				}
+			}
+		});
+	}
+};
+
+/**
+ * @brief run streams concurrently, each registered in the pool as the library does.
+ * @return frames per second of all streams.
+ */
+double throughput(const cv::Mat &nv12, const cv::Size &target, int streams, int iters, int interp)
+{
+	std::vector<std::thread> threads;
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int s = 0; s < streams; ++s) {
+		threads.emplace_back([&] {
+			WorkPoolStream registration;
+			StreamWork work(target);
+			for (int i = 0; i < iters; ++i) {
+				work.Run(nv12, interp);
+			}
+		});
+	}
+	for (auto &t : threads) {
+		t.join();
+	}
+	auto dur = std::chrono::high_resolution_clock::now() - start;
+	return streams * iters / std::chrono::duration<double>(dur).count();
+}
+
+/**
+ * @example
+ * @param argc number of input params.
+ * @param argv [iterations] [streams] [width] [height] [interp], defaults to 200 4 1920 1080 1.
+ * @return
+ */
+int main(int argc, char **argv)
+{
+	int iters = argc > 1 ? std::atoi(argv[1]) : 200;
+	int streams = argc > 2 ? std::atoi(argv[2]) : 4;
+	int width = argc > 3 ? std::atoi(argv[3]) : 1920;
+	int height = argc > 4 ? std::atoi(argv[4]) : 1080;
+	int interp = argc > 5 ? std::atoi(argv[5]) : cv::INTER_LINEAR;
+	const cv::Size target(608, 608);
+
+	cv::Mat bgr(height, width, CV_8UC3);
+	cv::randu(bgr, cv::Scalar::all(0), cv::Scalar::all(255));
+	cv::Mat i420;
+	cv::cvtColor(bgr, i420, cv::COLOR_BGR2YUV_I420);
+	cv::Mat nv12 = i420.clone();
+	const size_t luma = (size_t)width * height;
+	const size_t chroma = luma / 4;
+	for (size_t i = 0; i < chroma; ++i) {
+		nv12.data[luma + 2 * i] = i420.data[luma + i];
+		nv12.data[luma + 2 * i + 1] = i420.data[luma + chroma + i];
+	}
+
+	std::cout << "Input: " << width << "x" << height << " -> " << target.width << "x" << target.height
+			  << ", interp: " << interp << ", iterations: " << iters << ", streams: " << streams
+			  << ", cores: " << std::thread::hardware_concurrency() << std::endl;
+
+	double base_ms = 0.0, base_fps = 0.0;
+	for (unsigned int threads : {1u, 2u, 4u, 8u, 16u}) {
+		WorkPool::Instance().SetThreads(threads);
+		double ms;
+		{
+			WorkPoolStream registration;
+			StreamWork work(target);
+			work.Run(nv12, interp);//warm up caches and allocations.
+			auto start = std::chrono::high_resolution_clock::now();
+			for (int i = 0; i < iters; ++i) {
+				work.Run(nv12, interp);
+			}
+			auto dur = std::chrono::high_resolution_clock::now() - start;
+			ms = std::chrono::duration<double, std::milli>(dur).count() / iters;
+		}
+		double fps = throughput(nv12, target, streams, iters, interp);
+		if (threads == 1) {
+			base_ms = ms;
+			base_fps = fps;
+		}
+		std::cout << "threads " << threads << ": 1 stream " << ms << "ms per frame (" << base_ms / ms << "x), "
+				  << streams << " streams " << fps << " fps (" << fps / base_fps << "x)" << std::endl;
+	}
+	return 0;
+}
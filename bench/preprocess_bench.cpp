@@ -0,0 +1,86 @@
+#include <chrono>
+#include <iostream>
+#include <opencv2/imgproc.hpp>
+#include "yuv_convert.h"
+
+using namespace helmet;
+
+/**
+ * @brief time a preprocessing sequence.
+ * @param name printed name of the sequence.
+ * @param iters number of iterations.
+ * @param func sequence to be timed.
+ * @return average time in ms per frame.
+ */
+template<typename FUNC>
+double timing(const char *name, int iters, FUNC &&func)
+{
+	func();//warm up caches and allocations.
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < iters; ++i) {
+		func();
+	}
+	auto dur = std::chrono::high_resolution_clock::now() - start;
+	double ms = std::chrono::duration<double, std::milli>(dur).count() / iters;
+	std::cout << name << ": " << ms << "ms per frame" << std::endl;
+	return ms;
+}
+
+/**
+ * @example
+ * @param argc number of input params.
+ * @param argv [iterations] [width] [height] [interp], defaults to 200 1920 1080 0.
+ * @return
+ */
+int main(int argc, char **argv)
+{
+	int iters = argc > 1 ? std::atoi(argv[1]) : 200;
+	int width = argc > 2 ? std::atoi(argv[2]) : 1920;
+	int height = argc > 3 ? std::atoi(argv[3]) : 1080;
+	int interp = argc > 4 ? std::atoi(argv[4]) : cv::INTER_NEAREST;
+	const cv::Size target(608, 608);
+
+	cv::Mat bgr(height, width, CV_8UC3);
+	cv::randu(bgr, cv::Scalar::all(0), cv::Scalar::all(255));
+	cv::Mat i420;
+	cv::cvtColor(bgr, i420, cv::COLOR_BGR2YUV_I420);
+	///@note build NV12 from I420 by interleaving the chroma planes.
+	cv::Mat nv12 = i420.clone();
+	const size_t luma = (size_t)width * height;
+	const size_t chroma = luma / 4;
+	for (size_t i = 0; i < chroma; ++i) {
+		nv12.data[luma + 2 * i] = i420.data[luma + i];
+		nv12.data[luma + 2 * i + 1] = i420.data[luma + chroma + i];
+	}
+
+	std::cout << "Input: " << width << "x" << height << " -> " << target.width << "x" << target.height
+			  << ", interp: " << interp << ", iterations: " << iters << std::endl;
+
+	cv::Mat rgb, rgb_f, resized;
+	double base = timing("BGR->RGB->float->resize", iters, [&] {
+		cv::cvtColor(bgr, rgb, cv::COLOR_BGR2RGB);
+		rgb.convertTo(rgb_f, CV_32FC3);
+		cv::resize(rgb_f, resized, target, 0, 0, interp);
+	});
+
+	cv::Mat cvt, small, small_f;
+	timing("NV12->BGR->resize->float", iters, [&] {
+		cv::cvtColor(nv12, cvt, cv::COLOR_YUV2BGR_NV12);
+		cv::resize(cvt, small, target, 0, 0, interp);
+		small.convertTo(small_f, CV_32FC3);
+	});
+
+	YUVResizer resizer;
+	cv::Mat fused(target, CV_8UC3), fused_f;
+	double nv12_ms = timing("NV12 fused resize->float", iters, [&] {
+		resizer.Run(nv12, PixelFormat::NV12, fused, cv::Mat(), interp);
+		fused.convertTo(fused_f, CV_32FC3);
+	});
+	double i420_ms = timing("I420 fused resize->float", iters, [&] {
+		resizer.Run(i420, PixelFormat::I420, fused, cv::Mat(), interp);
+		fused.convertTo(fused_f, CV_32FC3);
+	});
+
+	std::cout << "Speedup NV12: " << base / nv12_ms << "x, I420: " << base / i420_ms << "x" << std::endl;
+	return 0;
+}
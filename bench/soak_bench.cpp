@@ -0,0 +1,250 @@
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/videoio.hpp>
+#include "model.h"
+#include "latency_stats.h"
+
+using namespace helmet;
+
+/**
+ * @brief source of frames for one stream, either synthetic moving boxes or a looped video file.
+ */
+class FrameSource final
+{
+public:
+	/**
+	 * @brief constructor.
+	 * @param file video file to be looped, empty to generate synthetic frames.
+	 * @param size frame size of synthetic frames.
+	 * @param seed seed of box positions and velocities, different per stream.
+	 */
+	FrameSource(const std::string &file, const cv::Size &size, int seed)
+	{
+		if (!file.empty()) {
+			m_cap.open(file);
+			if (!m_cap.isOpened()) {
+				std::cerr << "Cannot open video file: " << file << ", using synthetic frames." << std::endl;
+			}
+		}
+		m_background.create(size, CV_8UC3);
+		cv::RNG rng(seed);
+		rng.fill(m_background, cv::RNG::UNIFORM, cv::Scalar::all(60), cv::Scalar::all(120));
+		for (auto &box : m_boxes) {
+			box.rect = cv::Rect(rng.uniform(0, size.width - 120), rng.uniform(0, size.height - 240), 120, 240);
+			box.vx = rng.uniform(-12, 13);
+			box.vy = rng.uniform(-6, 7);
+			box.color = cv::Scalar(rng.uniform(0, 256), rng.uniform(0, 256), rng.uniform(0, 256));
+		}
+	}
+
+	/**
+	 * @brief produce the next frame.
+	 * @param frame output frame, reused between calls.
+	 * @return false if no frame can be produced.
+	 */
+	bool Next(cv::Mat &frame)
+	{
+		if (m_cap.isOpened()) {
+			if (m_cap.read(frame))return true;
+			///@note end of file, rewind and loop.
+			m_cap.set(cv::CAP_PROP_POS_FRAMES, 0);
+			return m_cap.read(frame);
+		}
+		m_background.copyTo(frame);
+		for (auto &box : m_boxes) {
+			box.rect.x += box.vx;
+			box.rect.y += box.vy;
+			if (box.rect.x < 0 || box.rect.x + box.rect.width > frame.cols) {
+				box.vx = -box.vx;
+				box.rect.x += 2 * box.vx;
+			}
+			if (box.rect.y < 0 || box.rect.y + box.rect.height > frame.rows) {
+				box.vy = -box.vy;
+				box.rect.y += 2 * box.vy;
+			}
+			cv::rectangle(frame, box.rect, box.color, -1);
+		}
+		return true;
+	}
+
+	/**
+	 * @brief skip one frame, i.e. a frame dropped because processing is late.
+	 */
+	void Skip()
+	{
+		if (m_cap.isOpened() && !m_cap.grab()) {
+			m_cap.set(cv::CAP_PROP_POS_FRAMES, 0);
+		}
+	}
+
+private:
+	struct MovingBox
+	{
+		cv::Rect rect;
+		int vx = 0;
+		int vy = 0;
+		cv::Scalar color;
+	};
+	cv::VideoCapture m_cap;
+	cv::Mat m_background;
+	MovingBox m_boxes[6];
+};
+
+/**
+ * @brief results of one stream.
+ */
+struct StreamResult
+{
+	uint64_t processed = 0;
+	uint64_t dropped = 0;///< frames whose deadline passed before they could be processed.
+	double seconds = 0.0;
+	LatencyHistogram latency;///< from the frame's capture deadline to the end of Process_Algorithm.
+};
+
+/**
+ * @brief run one stream at real time pace, frames are dropped if processing falls behind, like a live camera.
+ * @param model allocated model.
+ * @param source frame source.
+ * @param fps frame rate of the source.
+ * @param start common start time of all streams.
+ * @param end time to stop.
+ * @param result output results.
+ */
+void runStream(cvModel *model, FrameSource *source, double fps,
+			   std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end,
+			   StreamResult *result)
+{
+	const auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+		std::chrono::duration<double>(1.0 / fps));
+	cv::Mat frame;
+	int64_t index = 0;
+	///@note the streams are allocated on the main thread, each stream thread pins itself.
+	BindThread_Algorithm(model);
+	std::this_thread::sleep_until(start);
+	while (true) {
+		auto now = std::chrono::steady_clock::now();
+		if (now >= end)break;
+		auto deadline = start + index * period;
+		if (now < deadline) {
+			std::this_thread::sleep_until(deadline);
+		}
+		else {
+			///@note only the latest due frame is processed, the older ones are dropped.
+			int64_t due = (now - start) / period;
+			for (; index < due; ++index) {
+				source->Skip();
+				result->dropped++;
+			}
+			deadline = start + index * period;
+		}
+		if (!source->Next(frame))break;
+		Process_Algorithm(model, frame);
+		auto done = std::chrono::steady_clock::now();
+		result->latency.Record(std::chrono::duration_cast<std::chrono::microseconds>(done - deadline).count());
+		result->processed++;
+		index++;
+	}
+	result->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * @example
+ * @param argc number of input params.
+ * @param argv [streams] [fps] [seconds] [video file or "-" for synthetic] [json output] [width] [height], <!--
+ * --> defaults to 4 25 60 - soak_bench.json 1920 1080.
+ * @note set BACKEND: "mock" in the config file to run without a GPU, MOCK_LATENCY_MS then stands for the engine.
+ * @return
+ */
+int main(int argc, char **argv)
+{
+	int streams = argc > 1 ? std::atoi(argv[1]) : 4;
+	double fps = argc > 2 ? std::atof(argv[2]) : 25.0;
+	double seconds = argc > 3 ? std::atof(argv[3]) : 60.0;
+	std::string file = argc > 4 ? argv[4] : "-";
+	std::string output = argc > 5 ? argv[5] : "soak_bench.json";
+	int width = argc > 6 ? std::atoi(argv[6]) : 1920;
+	int height = argc > 7 ? std::atoi(argv[7]) : 1080;
+	if (file == "-")file.clear();
+	if (streams <= 0 || fps <= 0.0 || seconds <= 0.0) {
+		std::cerr << "Invalid arguments." << std::endl;
+		return -1;
+	}
+
+	std::cout << "Streams: " << streams << ", fps: " << fps << ", seconds: " << seconds
+			  << ", source: " << (file.empty() ? "synthetic" : file) << std::endl;
+
+	///@note models are allocated up front, so engine loading is not counted into the run.
+	std::vector<SharedRef<FrameSource>> sources(streams);
+	std::vector<cvModel *> models(streams, nullptr);
+	std::vector<StreamResult> results(streams);
+	for (int i = 0; i < streams; ++i) {
+		sources[i] = createSharedRef<FrameSource>(file, cv::Size(width, height), i + 1);
+		cv::Mat first;
+		if (!sources[i]->Next(first)) {
+			std::cerr << "Cannot read the first frame of stream " << i << std::endl;
+			return -1;
+		}
+		models[i] = Allocate_Algorithm(first, IA_TYPE_PEOPLEHELME_DETECTION, 0);
+		SetPara_Algorithm(models[i], IA_TYPE_PEOPLEHELME_DETECTION);
+		UpdateParams_Algorithm(models[i]);
+		///@note streams are prepared concurrently, the warm up builds CUDA contexts and caches.
+		Prepare_Algorithm(models[i], -1);
+	}
+	for (int i = 0; i < streams; ++i) {
+		while (IsReady_Algorithm(models[i]) == READY_PREPARING) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+		if (IsReady_Algorithm(models[i]) != READY_OK) {
+			std::cerr << "Stream " << i << " failed to prepare." << std::endl;
+			return -1;
+		}
+	}
+
+	auto start = std::chrono::steady_clock::now() + std::chrono::milliseconds(100);
+	auto end = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+		std::chrono::duration<double>(seconds));
+	std::vector<std::thread> threads(streams);
+	for (int i = 0; i < streams; ++i) {
+		threads[i] = std::thread(runStream, models[i], sources[i].get(), fps, start, end, &results[i]);
+	}
+	for (auto &t : threads) {
+		t.join();
+	}
+
+	std::ostringstream json;
+	double total_fps = 0.0;
+	uint64_t total_dropped = 0;
+	json << "{\"streams\":" << streams << ",\"target_fps\":" << fps << ",\"seconds\":" << seconds
+		 << ",\"source\":\"" << (file.empty() ? "synthetic" : file) << "\",\"results\":[";
+	for (int i = 0; i < streams; ++i) {
+		const auto &r = results[i];
+		double sustained = r.seconds > 0.0 ? r.processed / r.seconds : 0.0;
+		total_fps += sustained;
+		total_dropped += r.dropped;
+		if (i > 0)json << ",";
+		json << "{\"stream\":" << i
+			 << ",\"processed\":" << r.processed
+			 << ",\"dropped\":" << r.dropped
+			 << ",\"fps\":" << sustained
+			 << ",\"p50_ms\":" << r.latency.Percentile(0.5) / 1000.0
+			 << ",\"p99_ms\":" << r.latency.Percentile(0.99) / 1000.0
+			 << ",\"max_ms\":" << r.latency.Max() / 1000.0 << "}";
+	}
+	json << "],\"total_fps\":" << total_fps << ",\"total_dropped\":" << total_dropped << "}";
+
+	std::cout << json.str() << std::endl;
+	if (!output.empty()) {
+		std::ofstream out(output, std::ios::out | std::ios::trunc);
+		if (out)out << json.str() << std::endl;
+		else std::cerr << "Cannot write results to: " << output << std::endl;
+	}
+
+	for (auto *model : models) {
+		Destroy_Algorithm(model);
+	}
+	return 0;
+}
@@ -7,6 +7,27 @@ set(LIB_SRC
         ${PROJECT_SOURCE_DIR}/src/trt_deployresult.cpp
         ${PROJECT_SOURCE_DIR}/src/postprocessor.cpp
         ${PROJECT_SOURCE_DIR}/src/model.cpp
+        ${PROJECT_SOURCE_DIR}/src/video_writer.cpp
+        ${PROJECT_SOURCE_DIR}/src/clip_recorder.cpp
+        ${PROJECT_SOURCE_DIR}/src/live_source.cpp
+        ${PROJECT_SOURCE_DIR}/src/video_reader.cpp
+        ${PROJECT_SOURCE_DIR}/src/yuv_convert.cpp
+        ${PROJECT_SOURCE_DIR}/src/latency_stats.cpp
+        ${PROJECT_SOURCE_DIR}/src/trace.cpp
+        ${PROJECT_SOURCE_DIR}/src/mock_deploy.cpp
+        ${PROJECT_SOURCE_DIR}/src/log.cpp
+        ${PROJECT_SOURCE_DIR}/src/resource_cache.cpp
+        ${PROJECT_SOURCE_DIR}/src/nms.cpp
+        ${PROJECT_SOURCE_DIR}/src/tensor_pack.cpp
+        ${PROJECT_SOURCE_DIR}/src/tensor_pack.cu
+        ${PROJECT_SOURCE_DIR}/src/tensor_binding.cpp
+        ${PROJECT_SOURCE_DIR}/src/temporal_ring.cpp
+        ${PROJECT_SOURCE_DIR}/src/work_pool.cpp
+        ${PROJECT_SOURCE_DIR}/src/placement.cpp
+        ${PROJECT_SOURCE_DIR}/src/alarm_engine.cpp
+        ${PROJECT_SOURCE_DIR}/src/score_smoother.cpp
+        ${PROJECT_SOURCE_DIR}/src/evidence.cpp
+        ${PROJECT_SOURCE_DIR}/src/async_runner.cpp
         )
 
 set(LIB_HEADER
@@ -21,6 +42,27 @@ set(LIB_HEADER
         ${PROJECT_SOURCE_DIR}/src/trt_deployresult.h
         ${PROJECT_SOURCE_DIR}/src/postprocessor.h
         ${PROJECT_SOURCE_DIR}/src/model.h
+        ${PROJECT_SOURCE_DIR}/src/video_writer.h
+        ${PROJECT_SOURCE_DIR}/src/clip_recorder.h
+        ${PROJECT_SOURCE_DIR}/src/live_source.h
+        ${PROJECT_SOURCE_DIR}/src/video_reader.h
+        ${PROJECT_SOURCE_DIR}/src/yuv_convert.h
+        ${PROJECT_SOURCE_DIR}/src/latency_stats.h
+        ${PROJECT_SOURCE_DIR}/src/trace.h
+        ${PROJECT_SOURCE_DIR}/src/mock_deploy.h
+        ${PROJECT_SOURCE_DIR}/src/log.h
+        ${PROJECT_SOURCE_DIR}/src/resource_cache.h
+        ${PROJECT_SOURCE_DIR}/src/config_snapshot.h
+        ${PROJECT_SOURCE_DIR}/src/nms.h
+        ${PROJECT_SOURCE_DIR}/src/tensor_pack.h
+        ${PROJECT_SOURCE_DIR}/src/tensor_binding.h
+        ${PROJECT_SOURCE_DIR}/src/temporal_ring.h
+        ${PROJECT_SOURCE_DIR}/src/work_pool.h
+        ${PROJECT_SOURCE_DIR}/src/placement.h
+        ${PROJECT_SOURCE_DIR}/src/alarm_engine.h
+        ${PROJECT_SOURCE_DIR}/src/score_smoother.h
+        ${PROJECT_SOURCE_DIR}/src/evidence.h
+        ${PROJECT_SOURCE_DIR}/src/async_runner.h
         )
 
 set(LIB_MAIN
@@ -28,3 +70,20 @@ set(LIB_MAIN
         )
 
 
+
+set(LIB_BENCH
+        ${PROJECT_SOURCE_DIR}/bench/preprocess_bench.cpp
+        ${PROJECT_SOURCE_DIR}/bench/soak_bench.cpp
+        ${PROJECT_SOURCE_DIR}/bench/nms_bench.cpp
+        ${PROJECT_SOURCE_DIR}/bench/pool_bench.cpp
+        )
+
+set(LIB_TEST
+        ${PROJECT_SOURCE_DIR}/test/main_test.cpp
+        ${PROJECT_SOURCE_DIR}/test/score_smoother_test.cpp
+        ${PROJECT_SOURCE_DIR}/test/alarm_engine_test.cpp
+        ${PROJECT_SOURCE_DIR}/test/nms_test.cpp
+        ${PROJECT_SOURCE_DIR}/test/placement_test.cpp
+        ${PROJECT_SOURCE_DIR}/test/work_pool_test.cpp
+        ${PROJECT_SOURCE_DIR}/test/config_snapshot_test.cpp
+        )
@@ -9,7 +9,8 @@ set(CMAKE_POSITION_INDEPENDENT_CODE ON)
 set(CMAKE_INCLUDE_CURRENT_DIR ON)
 
 #define options for custom build targets.
-option(GEN_TEST "Build fight test program." ON)
+option(GEN_TEST "Build test program, run by ctest with the mock backend." ON)
+option(GEN_BENCH "Build benchmark programs." OFF)
 option(PREPROCESS_GPU "Use GPU version of preprocessing pipeline" ON)
 set(MODEL_INPUT_NAME "im_shape image scale_factor" CACHE STRING "Input layer name for tensorrt deploy.")
 set(MODEL_OUTPUT_NAMES "multiclass_nms3_0.tmp_0 multiclass_nms3_0.tmp_2" CACHE STRING "Output layer names for tensorrt deploy, seperated with comma or colon")
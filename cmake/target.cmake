@@ -6,3 +6,24 @@ add_executable(${DEPLOY_MAIN_NAME} ${LIB_HEADER} ${LIB_MAIN})
 target_link_libraries(${DEPLOY_MAIN_NAME} PUBLIC ${DEP_LIBS} ${DEPLOY_LIB_NAME})
 
 
+
+if (GEN_BENCH)
+    foreach (bench_src ${LIB_BENCH})
+        get_filename_component(bench_name ${bench_src} NAME_WE)
+        add_executable(${bench_name} ${bench_src})
+        target_include_directories(${bench_name} PRIVATE ${PROJECT_SOURCE_DIR}/src)
+        target_link_libraries(${bench_name} PUBLIC ${DEP_LIBS} ${DEPLOY_LIB_NAME})
+    endforeach ()
+endif ()
+
+if (GEN_TEST)
+    enable_testing()
+    foreach (test_src ${LIB_TEST})
+        get_filename_component(test_name ${test_src} NAME_WE)
+        add_executable(${test_name} ${test_src})
+        target_include_directories(${test_name} PRIVATE ${PROJECT_SOURCE_DIR}/src)
+        target_link_libraries(${test_name} PUBLIC ${DEP_LIBS} ${DEPLOY_LIB_NAME})
+        add_test(NAME ${test_name} COMMAND ${test_name} ${PROJECT_SOURCE_DIR}/config/helmet_detection.yaml
+                WORKING_DIRECTORY ${CMAKE_CURRENT_BINARY_DIR})
+    endforeach ()
+endif ()
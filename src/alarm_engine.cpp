@@ -0,0 +1,151 @@
+#include <algorithm>
+#include <cctype>
+#include "alarm_engine.h"
+
+namespace helmet
+{
+
+bool parseAlarmMode(const std::string &name, AlarmMode &mode)
+{
+	std::string lower(name);
+	std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+	if (lower == "count") {
+		mode = AlarmMode::COUNT;
+		return true;
+	}
+	if (lower == "time") {
+		mode = AlarmMode::TIME;
+		return true;
+	}
+	return false;
+}
+
+int gridCell(int x, int y, int width, int height, int cols, int rows)
+{
+	if (width <= 0 || height <= 0 || cols <= 0 || rows <= 0)return 0;
+	const int cx = std::min(std::max(x, 0) * cols / width, cols - 1);
+	const int cy = std::min(std::max(y, 0) * rows / height, rows - 1);
+	return cy * cols + cx;
+}
+
+AlarmWindow::AlarmWindow(size_t capacity)
+	: m_ring(std::max<size_t>(1, capacity))
+{
+}
+
+void AlarmWindow::Add(int64_t time_us, bool positive)
+{
+	if (m_total == (int)m_ring.size()) {
+		if (m_ring[m_head].positive)m_positives--;
+		m_head = (m_head + 1) % m_ring.size();
+		m_total--;
+	}
+	auto &e = m_ring[(m_head + m_total) % m_ring.size()];
+	e.time = time_us;
+	e.positive = positive;
+	m_total++;
+	if (positive)m_positives++;
+}
+
+void AlarmWindow::Expire(int64_t now_us, int64_t window_us)
+{
+	while (m_total > 0 && now_us - m_ring[m_head].time > window_us) {
+		if (m_ring[m_head].positive)m_positives--;
+		m_head = (m_head + 1) % m_ring.size();
+		m_total--;
+	}
+}
+
+int AlarmWindow::Total() const
+{
+	return m_total;
+}
+
+int AlarmWindow::Positives() const
+{
+	return m_positives;
+}
+
+float AlarmWindow::Ratio() const
+{
+	return m_total > 0 ? (float)m_positives / (float)m_total : 0.0f;
+}
+
+void AlarmEngine::Configure(const AlarmParams &params, int cols, int rows, size_t capacity)
+{
+	m_params = params;
+	m_cols = std::max(1, cols);
+	m_rows = std::max(1, rows);
+	m_regions.clear();
+	m_regions.reserve((size_t)m_cols * m_rows);
+	for (int i = 0; i < m_cols * m_rows; ++i) {
+		m_regions.push_back(Region{AlarmWindow(capacity)});
+	}
+}
+
+void AlarmEngine::SetParams(const AlarmParams &params)
+{
+	m_params = params;
+}
+
+int AlarmEngine::CellOf(int x, int y, int width, int height) const
+{
+	return gridCell(x, y, width, height, m_cols, m_rows);
+}
+
+void AlarmEngine::Begin()
+{
+	for (auto &r : m_regions) {
+		r.marked = false;
+	}
+}
+
+void AlarmEngine::Mark(int cell)
+{
+	if (cell >= 0 && cell < (int)m_regions.size())m_regions[cell].marked = true;
+}
+
+void AlarmEngine::Commit(int64_t time_us)
+{
+	for (auto &r : m_regions) {
+		r.window.Add(time_us, r.marked);
+	}
+}
+
+bool AlarmEngine::Evaluate(int64_t now_us)
+{
+	bool alarm = false;
+	for (auto &r : m_regions) {
+		r.window.Expire(now_us, m_params.window_us);
+		const float ratio = r.window.Ratio();
+		if (!r.active) {
+			r.active = r.window.Total() >= m_params.min_evidence && ratio >= m_params.on_ratio;
+		}
+		else if (ratio <= m_params.off_ratio) {
+			r.active = false;
+		}
+		if (r.active && (!r.alarmed || now_us - r.last_alarm >= m_params.cooldown_us)) {
+			r.last_alarm = now_us;
+			r.alarmed = true;
+			alarm = true;
+		}
+	}
+	return alarm;
+}
+
+size_t AlarmEngine::Cells() const
+{
+	return m_regions.size();
+}
+
+bool AlarmEngine::Active(int cell) const
+{
+	return cell >= 0 && cell < (int)m_regions.size() && m_regions[cell].active;
+}
+
+float AlarmEngine::Ratio(int cell) const
+{
+	return cell >= 0 && cell < (int)m_regions.size() ? m_regions[cell].window.Ratio() : 0.0f;
+}
+
+}
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace helmet
+{
+/**
+ * @brief how the alarm is raised from detections.
+ */
+enum class AlarmMode
+{
+	COUNT = 0,///< legacy per frame counter, see ALARM_COUNT, depends on fps and sampling.
+	TIME = 1 ///< sliding time window over timestamped inferences, see AlarmEngine.
+};
+
+/**
+ * @brief parse "count" or "time", case insensitive.
+ * @return true if parsed.
+ */
+extern bool parseAlarmMode(const std::string &name, AlarmMode &mode);
+
+/**
+ * @brief get the grid cell of a point.
+ * @param x point in frame coordinates.
+ * @param y point in frame coordinates.
+ * @param width frame width.
+ * @param height frame height.
+ * @param cols cells across the frame.
+ * @param rows cells down the frame.
+ * @return cell index in row major order, clamped to the grid.
+ */
+extern int gridCell(int x, int y, int width, int height, int cols, int rows);
+
+struct AlarmParams
+{
+	int64_t window_us = 2000000;///< evidence older than this is forgotten.
+	float on_ratio = 0.6f;///< positive share of the window to switch a region on.
+	float off_ratio = 0.3f;///< positive share to switch it off again, below on_ratio.
+	int min_evidence = 3;///< inferences needed in the window before a region can switch on.
+	int64_t cooldown_us = 10000000;///< minimal time between two alarms of the same region.
+};
+
+/**
+ * @brief positive share of the inferences within a sliding time window.
+ * @details a ring of fixed capacity holds the inference times and flags, the counts are kept incrementally, <!--
+ * --> so adding and expiring evidence is O(1) amortized and nothing is allocated after construction. <!--
+ * --> If the ring is full the oldest evidence is forgotten early.
+ */
+class AlarmWindow final
+{
+public:
+	explicit AlarmWindow(size_t capacity = 64);
+
+	/**
+	 * @brief add the evidence of one inference.
+	 * @param time_us time of the inference.
+	 * @param positive true if the region had a target.
+	 */
+	void Add(int64_t time_us, bool positive);
+
+	/**
+	 * @brief forget evidence older than the window.
+	 * @param now_us current time.
+	 * @param window_us window length.
+	 */
+	void Expire(int64_t now_us, int64_t window_us);
+
+	int Total() const;
+	int Positives() const;
+	float Ratio() const;
+
+private:
+	struct Evidence
+	{
+		int64_t time = 0;
+		bool positive = false;
+	};
+	std::vector<Evidence> m_ring;
+	size_t m_head = 0;///< oldest evidence.
+	int m_total = 0;
+	int m_positives = 0;
+};
+
+/**
+ * @brief time based alarm, independent of frame rate, sampling interval and number of boxes.
+ * @details the frame is split into a grid of regions, each with its own window, on/off hysteresis and <!--
+ * --> cooldown. Every fresh inference adds one piece of evidence per region, reused results of skipped <!--
+ * --> frames add nothing, so changing the inference cadence only changes how many samples the window holds. <!--
+ * --> A region switches on once at least min_evidence inferences are in the window and the positive share <!--
+ * --> reaches on_ratio, and off when it drops to off_ratio. An active region raises the alarm when it <!--
+ * --> switches on and again every cooldown while it stays on.
+ * @example:
+ * @code
+ * 	AlarmEngine engine;
+ * 	engine.Configure(params, 2, 2, 64);
+ * 	engine.Begin();
+ * 	engine.Mark(engine.CellOf(cx, cy, width, height));
+ * 	engine.Commit(result_time);
+ * 	int alarm = engine.Evaluate(now) ? 1 : 0;
+ * @endcode
+ */
+class AlarmEngine final
+{
+public:
+	/**
+	 * @brief set parameters and regions, the state is reset.
+	 * @param params window, hysteresis and cooldown.
+	 * @param cols regions across the frame.
+	 * @param rows regions down the frame.
+	 * @param capacity evidence kept per region.
+	 */
+	void Configure(const AlarmParams &params, int cols, int rows, size_t capacity);
+
+	/**
+	 * @brief update the thresholds without resetting the state.
+	 */
+	void SetParams(const AlarmParams &params);
+
+	/**
+	 * @brief get the region of a point.
+	 * @param x point in frame coordinates.
+	 * @param y point in frame coordinates.
+	 * @param width frame width.
+	 * @param height frame height.
+	 * @return region index, clamped to the grid.
+	 */
+	int CellOf(int x, int y, int width, int height) const;
+
+	/**
+	 * @brief start collecting the positive regions of a fresh inference.
+	 */
+	void Begin();
+
+	/**
+	 * @brief mark a region positive in the current inference.
+	 */
+	void Mark(int cell);
+
+	/**
+	 * @brief add the collected inference as evidence to every region.
+	 * @param time_us time of the inference.
+	 */
+	void Commit(int64_t time_us);
+
+	/**
+	 * @brief advance to the current time, update the hysteresis and raise alarms.
+	 * @param now_us current time.
+	 * @return true if any region raises an alarm now.
+	 */
+	bool Evaluate(int64_t now_us);
+
+	size_t Cells() const;
+
+	/**
+	 * @brief check whether a region is switched on.
+	 */
+	bool Active(int cell) const;
+
+	/**
+	 * @brief get the positive share of a region's window.
+	 */
+	float Ratio(int cell) const;
+
+private:
+	struct Region
+	{
+		AlarmWindow window;
+		bool marked = false;
+		bool active = false;
+		int64_t last_alarm = 0;
+		bool alarmed = false;///< last_alarm is valid.
+	};
+	AlarmParams m_params;
+	int m_cols = 1;
+	int m_rows = 1;
+	std::vector<Region> m_regions;
+};
+
+}
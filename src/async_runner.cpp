@@ -0,0 +1,154 @@
+#include <chrono>
+#include "async_runner.h"
+#include "trace.h"
+
+namespace helmet
+{
+
+AsyncRunner::AsyncRunner(cvModel *model, Process process, AsyncCallback_Algorithm callback, void *user_data,
+						 int max_in_flight, int flags, Setup setup)
+	: m_model(model), m_process(std::move(process)), m_setup(std::move(setup)), m_callback(callback), m_user_data(user_data),
+	  m_max_in_flight((size_t)std::max(1, max_in_flight)), m_annotate((flags & ASYNC_ANNOTATE) != 0),
+	  m_drop_oldest((flags & ASYNC_DROP_OLDEST) != 0)
+{
+	m_thread = std::thread(&AsyncRunner::Loop, this);
+}
+
+AsyncRunner::~AsyncRunner()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mtx);
+		m_stop = true;
+	}
+	m_wake.notify_all();
+	if (m_thread.joinable())m_thread.join();
+}
+
+long AsyncRunner::Submit(const cv::Mat &frame)
+{
+	std::unique_lock<std::mutex> lock(m_mtx);
+	const long ticket = m_next_ticket++;
+	m_stats.submitted++;
+	if (m_in_flight >= m_max_in_flight) {
+		if (!m_drop_oldest || m_jobs.empty()) {
+			///@note reported by the worker, in flight is kept until then so Flush() waits for the report.
+			m_dropped.push_back(ticket);
+			m_in_flight++;
+			lock.unlock();
+			m_wake.notify_one();
+			return ticket;
+		}
+		///@note the oldest queued frame is replaced, its buffer is reused by the new one.
+		auto oldest = std::move(m_jobs.front());
+		m_jobs.pop_front();
+		m_dropped.push_back(oldest.ticket);
+		m_free.push_back(std::move(oldest.frame));
+	}
+	Job job;
+	job.ticket = ticket;
+	if (!m_free.empty()) {
+		job.frame = std::move(m_free.back());
+		m_free.pop_back();
+	}
+	m_in_flight++;
+	///@note copied under the lock, the buffer must not be handed to the worker half written.
+	frame.copyTo(job.frame);
+	m_jobs.push_back(std::move(job));
+	lock.unlock();
+	m_wake.notify_one();
+	return ticket;
+}
+
+bool AsyncRunner::Flush(int timeout_ms)
+{
+	std::unique_lock<std::mutex> lock(m_mtx);
+	auto idle = [this] { return m_in_flight == 0; };
+	if (timeout_ms < 0) {
+		m_idle.wait(lock, idle);
+		return true;
+	}
+	return m_idle.wait_for(lock, std::chrono::milliseconds(timeout_ms), idle);
+}
+
+AsyncRunner::Stats AsyncRunner::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(m_mtx);
+	auto stats = m_stats;
+	stats.in_flight = m_in_flight;
+	return stats;
+}
+
+void AsyncRunner::Notify(long ticket, int status)
+{
+	cvAsyncResult result{};
+	result.ticket = ticket;
+	result.status = status;
+	result.user_data = m_user_data;
+	m_callback(m_model, &result);
+}
+
+void AsyncRunner::Finish(cv::Mat &&frame, bool done)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mtx);
+		if (!frame.empty())m_free.push_back(std::move(frame));
+		m_in_flight--;
+		if (done)m_stats.completed++;
+		else m_stats.dropped++;
+		if (m_in_flight > 0)return;
+	}
+	m_idle.notify_all();
+}
+
+void AsyncRunner::Loop()
+{
+	Tracer::Instance().SetThreadName("async");
+	if (m_setup)m_setup();
+	std::deque<long> dropped;
+	while (true) {
+		Job job;
+		bool has_job = false;
+		bool stop = false;
+		{
+			std::unique_lock<std::mutex> lock(m_mtx);
+			m_wake.wait(lock, [this] { return m_stop || !m_jobs.empty() || !m_dropped.empty(); });
+			dropped.swap(m_dropped);
+			stop = m_stop;
+			if (!stop && !m_jobs.empty()) {
+				job = std::move(m_jobs.front());
+				m_jobs.pop_front();
+				has_job = true;
+			}
+		}
+		for (auto ticket : dropped) {
+			Notify(ticket, ASYNC_DROPPED);
+			Finish(cv::Mat(), false);
+		}
+		dropped.clear();
+		if (stop)break;
+		if (!has_job)continue;
+
+		cvAsyncResult result{};
+		result.ticket = job.ticket;
+		result.status = ASYNC_DONE;
+		result.user_data = m_user_data;
+		m_process(job.frame, m_annotate, result.alarm, m_dets);
+		result.num_dets = (int)m_dets.size();
+		result.dets = m_dets.data();
+		result.frame = m_annotate ? &job.frame : nullptr;
+		m_callback(m_model, &result);
+		Finish(std::move(job.frame), true);
+	}
+	///@note queued frames are reported as cancelled, the host may be waiting for every ticket.
+	std::deque<Job> jobs;
+	{
+		std::lock_guard<std::mutex> lock(m_mtx);
+		jobs.swap(m_jobs);
+	}
+	for (auto &job : jobs) {
+		Notify(job.ticket, ASYNC_CANCELLED);
+		Finish(std::move(job.frame), false);
+	}
+}
+
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <opencv2/core/mat.hpp>
+#include "model.h"
+
+namespace helmet
+{
+/**
+ * @brief asynchronous frame processing of one stream on a thread owned by the library.
+ * @details Submit() copies the frame into a pooled buffer and returns a ticket at once, so the capture thread <!--
+ * --> only pays the copy. The worker processes frames in submission order and reports every ticket exactly <!--
+ * --> once through the callback, either processed, dropped when the in flight limit is hit, or cancelled at <!--
+ * --> shutdown. Drops are reported on the worker as well, the callback never runs on the submitting thread.
+ * @note the frame buffers are reused, at most max_in_flight of them are allocated.
+ * @example:
+ * @code
+ * 	AsyncRunner runner(pModel, process, callback, user_data, 4, ASYNC_DROP_OLDEST, setup);
+ * 	long ticket = runner.Submit(frame);
+ * 	runner.Flush(-1);
+ * @endcode
+ */
+class AsyncRunner final
+{
+public:
+	/**
+	 * @brief process one frame.
+	 * @param frame frame owned by the runner, drawn onto if annotate is true.
+	 * @param annotate draw the results.
+	 * @param alarm output alarm.
+	 * @param dets output detections.
+	 */
+	using Process = std::function<void(cv::Mat &frame, bool annotate, int &alarm, std::vector<cv_Detection> &dets)>;
+
+	/**
+	 * @brief prepare the worker thread before the first frame, e.g. select the GPU and pin the thread.
+	 */
+	using Setup = std::function<void()>;
+
+	struct Stats
+	{
+		uint64_t submitted = 0;
+		uint64_t completed = 0;///< processed, i.e. reported as ASYNC_DONE.
+		uint64_t dropped = 0;///< reported as ASYNC_DROPPED or ASYNC_CANCELLED.
+		size_t in_flight = 0;///< queued and being processed.
+	};
+
+public:
+	AsyncRunner(cvModel *model, Process process, AsyncCallback_Algorithm callback, void *user_data,
+				int max_in_flight, int flags, Setup setup = nullptr);
+
+	/**
+	 * @brief finish the frame being processed, cancel the queued ones and join the worker.
+	 */
+	~AsyncRunner();
+
+	AsyncRunner(const AsyncRunner &) = delete;
+	AsyncRunner &operator=(const AsyncRunner &) = delete;
+
+	/**
+	 * @brief queue a frame.
+	 * @param frame input frame, copied.
+	 * @return ticket of the frame, the same as delivered by the callback.
+	 */
+	long Submit(const cv::Mat &frame);
+
+	/**
+	 * @brief wait until every submitted frame is reported.
+	 * @param timeout_ms timeout, negative to wait forever.
+	 * @return true if nothing is in flight.
+	 */
+	bool Flush(int timeout_ms);
+
+	Stats GetStats() const;
+
+private:
+	struct Job
+	{
+		long ticket = 0;
+		cv::Mat frame;
+	};
+
+	/**
+	 * @brief worker main loop.
+	 */
+	void Loop();
+
+	/**
+	 * @brief invoke the callback for a ticket not processed.
+	 */
+	void Notify(long ticket, int status);
+
+	/**
+	 * @brief give a frame buffer back and count the ticket as reported, m_mtx must not be held.
+	 */
+	void Finish(cv::Mat &&frame, bool done);
+
+private:
+	cvModel *m_model = nullptr;
+	Process m_process;
+	Setup m_setup;
+	AsyncCallback_Algorithm m_callback = nullptr;
+	void *m_user_data = nullptr;
+	size_t m_max_in_flight = 1;
+	bool m_annotate = false;
+	bool m_drop_oldest = false;
+
+	mutable std::mutex m_mtx;
+	std::condition_variable m_wake;///< worker waits for jobs or drops.
+	std::condition_variable m_idle;///< Flush() waits for in flight to be zero.
+	std::deque<Job> m_jobs;
+	std::deque<long> m_dropped;///< tickets to be reported as dropped.
+	std::vector<cv::Mat> m_free;///< frame buffers to be reused.
+	size_t m_in_flight = 0;
+	long m_next_ticket = 0;
+	Stats m_stats;
+	bool m_stop = false;
+	std::vector<cv_Detection> m_dets;///< detections of the current frame, used by the worker only.
+	std::thread m_thread;
+};
+
+}
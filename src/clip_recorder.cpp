@@ -0,0 +1,251 @@
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+#include "clip_recorder.h"
+#include "log.h"
+#include "placement.h"
+#include "trace.h"
+
+namespace helmet
+{
+
+ClipRecorder::ClipRecorder(const Options &options)
+	: m_options(options)
+{
+	m_options.capacity = std::max<size_t>(1, m_options.capacity);
+	m_options.scale = std::min(std::max(m_options.scale, 0.05f), 1.0f);
+	m_free.reserve(m_options.capacity);
+}
+
+ClipRecorder::~ClipRecorder()
+{
+	Release();
+}
+
+bool ClipRecorder::Open(const std::string &prefix, double fps)
+{
+	Release();
+	std::error_code ec;
+	std::filesystem::create_directories(m_options.dir, ec);
+	if (ec) {
+		logStream(LogLevel::ERROR) << "Cannot create clip directory " << m_options.dir << ": " << ec.message() << std::endl;
+		return false;
+	}
+	m_prefix = prefix;
+	m_fps = fps > 0 ? fps : 25.0;
+	m_queued = 0;
+	m_dropped = 0;
+	m_compressed = 0;
+	m_clips = 0;
+	m_clip_frames = 0;
+	m_bytes_written = 0;
+	m_pre_roll_bytes = 0;
+	m_stop = false;
+	m_opened = true;
+	m_thread = std::thread(&ClipRecorder::Loop, this);
+	return true;
+}
+
+bool ClipRecorder::IsOpened() const
+{
+	return m_opened;
+}
+
+bool ClipRecorder::Write(const cv::Mat &frame, int64_t time_us, bool alarm)
+{
+	if (!m_opened || frame.empty())return false;
+	cv::Mat buf;
+	{
+		std::lock_guard<std::mutex> lock(m_mtx);
+		if (m_free.empty()) {
+			if (m_queue.size() >= m_options.capacity) {
+				///@note alarm frames are never the ones dropped while the queue holds others.
+				auto it = std::find_if(m_queue.begin(), m_queue.end(), [](const Raw &r) { return !r.alarm; });
+				if (!alarm || it == m_queue.end()) {
+					m_dropped++;
+					return false;
+				}
+				buf = std::move(it->img);
+				m_queue.erase(it);
+				m_dropped++;
+			}
+		}
+		else {
+			buf = std::move(m_free.back());
+			m_free.pop_back();
+		}
+	}
+	///@note the copy is done outside the lock, copyTo() will not reallocate if size and type are unchanged.
+	frame.copyTo(buf);
+	{
+		std::lock_guard<std::mutex> lock(m_mtx);
+		m_queue.push_back(Raw{std::move(buf), time_us, alarm});
+	}
+	m_queued++;
+	m_not_empty.notify_one();
+	return true;
+}
+
+void ClipRecorder::Recycle(Encoded &&frame)
+{
+	frame.bytes.clear();
+	m_spare.push_back(std::move(frame.bytes));
+}
+
+void ClipRecorder::Keep(Encoded &&frame)
+{
+	m_ring_size += frame.bytes.size();
+	m_ring.push_back(std::move(frame));
+	const int64_t newest = m_ring.back().time;
+	const int64_t pre_roll = (int64_t)m_options.pre_roll_ms * 1000;
+	while (!m_ring.empty() && (newest - m_ring.front().time > pre_roll || m_ring_size > m_options.max_bytes)) {
+		m_ring_size -= m_ring.front().bytes.size();
+		Recycle(std::move(m_ring.front()));
+		m_ring.pop_front();
+	}
+	m_pre_roll_bytes = m_ring_size;
+}
+
+bool ClipRecorder::StartClip()
+{
+	const auto now = std::chrono::duration_cast<std::chrono::milliseconds>(
+		std::chrono::system_clock::now().time_since_epoch()).count();
+	m_clip_file = m_options.dir + "/" + m_prefix + "_" + std::to_string(now) + ".mjpeg";
+	m_clip = fopen(m_clip_file.c_str(), "wb");
+	if (!m_clip) {
+		logStream(LogLevel::ERROR) << "Cannot open clip file: " << m_clip_file << std::endl;
+		return false;
+	}
+	m_clips++;
+	m_clip_times.clear();
+	for (auto &frame : m_ring) {
+		Append(frame);
+		Recycle(std::move(frame));
+	}
+	m_ring.clear();
+	m_ring_size = 0;
+	m_pre_roll_bytes = 0;
+	return true;
+}
+
+void ClipRecorder::Append(const Encoded &frame)
+{
+	if (fwrite(frame.bytes.data(), 1, frame.bytes.size(), m_clip) != frame.bytes.size()) {
+		logStream(LogLevel::WARNING) << "Cannot write clip file: " << m_clip_file << std::endl;
+		return;
+	}
+	m_clip_times.push_back(frame.time);
+	m_clip_frames++;
+	m_bytes_written += frame.bytes.size();
+}
+
+void ClipRecorder::FinishClip()
+{
+	if (!m_clip)return;
+	fclose(m_clip);
+	m_clip = nullptr;
+	std::ofstream meta(m_clip_file + ".json");
+	meta << "{\"file\":\"" << std::filesystem::path(m_clip_file).filename().string() << "\",\"fps\":" << m_fps
+		 << ",\"frames\":" << m_clip_times.size() << ",\"time_us\":[";
+	for (size_t i = 0; i < m_clip_times.size(); ++i) {
+		meta << (i ? "," : "") << m_clip_times[i];
+	}
+	meta << "]}\n";
+	logStream(LogLevel::INFO) << "Clip written: " << m_clip_file << " with " << m_clip_times.size() << " frames" << std::endl;
+}
+
+void ClipRecorder::Loop()
+{
+	Tracer::Instance().SetThreadName("clip");
+	const std::vector<int> params = {cv::IMWRITE_JPEG_QUALITY, m_options.quality};
+	while (true) {
+		Raw raw;
+		{
+			std::unique_lock<std::mutex> lock(m_mtx);
+			m_not_empty.wait(lock, [this] { return m_stop || !m_queue.empty(); });
+			if (m_queue.empty())break;
+			raw = std::move(m_queue.front());
+			m_queue.pop_front();
+		}
+		Encoded frame;
+		frame.time = raw.time;
+		if (!m_spare.empty()) {
+			frame.bytes = std::move(m_spare.back());
+			m_spare.pop_back();
+		}
+		bool ok;
+		if (m_options.scale < 1.0f) {
+			cv::resize(raw.img, m_scaled, cv::Size(), m_options.scale, m_options.scale, cv::INTER_AREA);
+			ok = cv::imencode(".jpg", m_scaled, frame.bytes, params);
+		}
+		else {
+			ok = cv::imencode(".jpg", raw.img, frame.bytes, params);
+		}
+		{
+			std::lock_guard<std::mutex> lock(m_mtx);
+			m_free.push_back(std::move(raw.img));
+		}
+		if (!ok) {
+			Recycle(std::move(frame));
+			continue;
+		}
+		m_compressed++;
+
+		if (raw.alarm) {
+			if (!m_clip)StartClip();
+			m_clip_until = raw.time + (int64_t)m_options.post_roll_ms * 1000;
+		}
+		if (!m_clip) {
+			Keep(std::move(frame));
+			continue;
+		}
+		Append(frame);
+		Recycle(std::move(frame));
+		if (raw.time >= m_clip_until)FinishClip();
+	}
+	FinishClip();
+	for (auto &frame : m_ring) {
+		Recycle(std::move(frame));
+	}
+	m_ring.clear();
+	m_ring_size = 0;
+	m_pre_roll_bytes = 0;
+}
+
+void ClipRecorder::Release()
+{
+	if (!m_opened)return;
+	{
+		std::lock_guard<std::mutex> lock(m_mtx);
+		m_stop = true;
+	}
+	m_not_empty.notify_all();
+	if (m_thread.joinable()) {
+		m_thread.join();
+	}
+	m_opened = false;
+}
+
+ClipRecorder::Stats ClipRecorder::GetStats() const
+{
+	Stats stats;
+	stats.queued = m_queued;
+	stats.dropped = m_dropped;
+	stats.compressed = m_compressed;
+	stats.clips = m_clips;
+	stats.clip_frames = m_clip_frames;
+	stats.bytes_written = m_bytes_written;
+	stats.pre_roll_bytes = m_pre_roll_bytes;
+	return stats;
+}
+
+bool ClipRecorder::SetAffinity(const std::vector<int> &cpus)
+{
+	if (!m_opened || !m_thread.joinable())return false;
+	return pinThread(m_thread.native_handle(), cpus);
+}
+
+}
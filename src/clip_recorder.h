@@ -0,0 +1,184 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <opencv2/core/mat.hpp>
+#include "util.h"
+
+namespace helmet
+{
+/**
+ * @brief event clip recorder, only the footage around alarms is stored.
+ * @details frames are copied into buffers from a fixed pool and compressed to JPEG on a background thread. <!--
+ * --> The compressed frames are kept in a pre-roll ring bounded by time and bytes, older ones are discarded <!--
+ * --> without ever being written. An alarm starts a clip with the whole ring, frames keep being appended until <!--
+ * --> the post-roll has passed since the latest alarm, so a clip covers pre-roll, the event and post-roll. <!--
+ * --> Clips are written as motion JPEG, i.e. concatenated JPEG frames "<prefix>_<time>.mjpeg" playable by <!--
+ * --> ffplay or VLC, with a JSON sidecar holding the frame times, so nothing is encoded twice.
+ * @note Write() is expected to be called from a single producer thread.
+ * @example:
+ * @code
+ * 	ClipRecorder recorder(options);
+ * 	recorder.Open("camera0", 25.0);
+ * 	while (...) {
+ * 		Process_Algorithm(model, img);
+ * 		recorder.Write(img, time_us, model->alarm != 0);
+ * 	}
+ * 	recorder.Release();
+ * @endcode
+ */
+class ClipRecorder final
+{
+public:
+	struct Options
+	{
+		std::string dir = ".";///< output directory, created if missing.
+		int pre_roll_ms = 5000;///< footage kept before an alarm.
+		int post_roll_ms = 5000;///< footage kept after the latest alarm.
+		size_t max_bytes = 64u << 20;///< memory bound of the pre-roll ring, the oldest frames are discarded first.
+		int quality = 80;///< JPEG quality.
+		float scale = 1.0f;///< frames are resized by this factor before compression, at most 1.
+		size_t capacity = 8;///< frames waiting for compression, also the size of buffer pool.
+	};
+
+	/**
+	 * @brief counters of the recorder, all values are accumulated since Open().
+	 */
+	struct Stats
+	{
+		uint64_t queued = 0;///< frames accepted into the queue.
+		uint64_t dropped = 0;///< frames discarded since no buffer was free.
+		uint64_t compressed = 0;///< frames compressed into the pre-roll ring or a clip.
+		uint64_t clips = 0;///< clips started.
+		uint64_t clip_frames = 0;///< frames written into clips.
+		uint64_t bytes_written = 0;///< bytes written into clips.
+		size_t pre_roll_bytes = 0;///< bytes held by the pre-roll ring now.
+	};
+
+public:
+	explicit ClipRecorder(const Options &options);
+
+	/**
+	 * @brief flush the pending frames, close the current clip and join the encoder thread.
+	 */
+	~ClipRecorder();
+
+	ClipRecorder(const ClipRecorder &) = delete;
+	ClipRecorder &operator=(const ClipRecorder &) = delete;
+
+	/**
+	 * @brief start the encoder thread.
+	 * @param prefix file name prefix of the clips, e.g. the stream name.
+	 * @param fps frame rate stored in the clip metadata.
+	 * @return true if opened.
+	 */
+	bool Open(const std::string &prefix, double fps);
+
+	bool IsOpened() const;
+
+	/**
+	 * @brief queue one frame, never blocks on the encoder.
+	 * @param frame frame to be kept, it is copied so the caller can reuse it immediately.
+	 * @param time_us time of the frame, e.g. its position in the video, used for pre-roll and post-roll.
+	 * @param alarm true if the frame raised an alarm.
+	 * @return false if the frame is dropped.
+	 */
+	bool Write(const cv::Mat &frame, int64_t time_us, bool alarm);
+
+	/**
+	 * @brief compress all pending frames, close the current clip and stop the encoder thread.
+	 */
+	void Release();
+
+	Stats GetStats() const;
+
+	/**
+	 * @brief pin the encoder thread.
+	 * @param cpus CPU ids.
+	 * @return true if pinned, false if not opened or pinning failed.
+	 */
+	bool SetAffinity(const std::vector<int> &cpus);
+
+private:
+	struct Raw
+	{
+		cv::Mat img;
+		int64_t time = 0;
+		bool alarm = false;
+	};
+
+	struct Encoded
+	{
+		std::vector<unsigned char> bytes;
+		int64_t time = 0;
+	};
+
+	/**
+	 * @brief encoder thread main loop.
+	 */
+	void Loop();
+
+	/**
+	 * @brief keep a compressed frame in the pre-roll ring and discard what falls out of it.
+	 */
+	void Keep(Encoded &&frame);
+
+	/**
+	 * @brief open a new clip and move the pre-roll ring into it.
+	 * @return false if the file cannot be opened.
+	 */
+	bool StartClip();
+
+	/**
+	 * @brief write a compressed frame into the current clip.
+	 */
+	void Append(const Encoded &frame);
+
+	/**
+	 * @brief close the current clip and write its metadata.
+	 */
+	void FinishClip();
+
+	/**
+	 * @brief give a byte buffer back for reuse.
+	 */
+	void Recycle(Encoded &&frame);
+
+private:
+	Options m_options;
+	std::string m_prefix;
+	double m_fps = 25.0;
+	std::thread m_thread;
+	mutable std::mutex m_mtx;
+	std::condition_variable m_not_empty;
+	std::deque<Raw> m_queue;///< frames waiting for compression.
+	std::vector<cv::Mat> m_free;///< recycled frame buffers.
+	bool m_stop = false;
+	bool m_opened = false;
+
+	///@note the members below are used by the encoder thread only.
+	std::deque<Encoded> m_ring;///< pre-roll, oldest first.
+	size_t m_ring_size = 0;///< bytes in m_ring.
+	std::vector<std::vector<unsigned char>> m_spare;///< recycled byte buffers.
+	cv::Mat m_scaled;
+	FILE *m_clip = nullptr;
+	std::string m_clip_file;
+	std::vector<int64_t> m_clip_times;///< frame times of the current clip.
+	int64_t m_clip_until = 0;///< the current clip ends with the first frame from this time on.
+
+	std::atomic<uint64_t> m_queued = 0;
+	std::atomic<uint64_t> m_dropped = 0;
+	std::atomic<uint64_t> m_compressed = 0;
+	std::atomic<uint64_t> m_clips = 0;
+	std::atomic<uint64_t> m_clip_frames = 0;
+	std::atomic<uint64_t> m_bytes_written = 0;
+	std::atomic<size_t> m_pre_roll_bytes = 0;
+};
+
+}
@@ -2,75 +2,106 @@
 #include "config.h"
 #include "macro.h"
 #include "util.h"
+#include "log.h"
 
 namespace helmet
 {
 template<typename ARR>
 void print_array(const ARR& arr,const char* msg){
 	int num = arr.size();
+	auto log = logStream(LogLevel::INFO);
 	if(num==0){
-		std::cout<<msg<<": NULL.\n";
+		log<<msg<<": NULL.";
 		return;
 	}
-	std::cout<<msg<<": {";
+	log<<msg<<": {";
 
 	for(int i=0;i<num;i++){
-		std::cout<<arr[i];
+		log<<arr[i];
 		if(i<num-1){
-			std::cout<<",";
+			log<<",";
 		}
 	}
-	std::cout<<"}.\n";
+	log<<"}.";
 }
 
 template<>
 void print_array(const std::vector<unsigned char>& arr,const char* msg){
 	int num = arr.size();
+	auto log = logStream(LogLevel::INFO);
 	if(num==0){
-		std::cout<<msg<<": NULL.\n";
+		log<<msg<<": NULL.";
 		return;
 	}
-	std::cout<<msg<<": {";
+	log<<msg<<": {";
 
 	for(int i=0;i<num;i++){
-		std::cout<<(int)arr[i];
+		log<<(int)arr[i];
 		if(i<num-1){
-			std::cout<<",";
+			log<<",";
 		}
 	}
-	std::cout<<"}.\n";
+	log<<"}.";
 }
 
 template<>
 void print_array(const std::vector<std::string>& arr,const char* msg){
 	int num = arr.size();
+	auto log = logStream(LogLevel::INFO);
 	if(num==0){
-		std::cout<<msg<<": NULL.\n";
+		log<<msg<<": NULL.";
 		return;
 	}
-	std::cout<<msg<<": {";
+	log<<msg<<": {";
 
 	for(int i=0;i<num;i++){
-		std::cout<<"\""<<arr[i]<<"\"";
+		log<<"\""<<arr[i]<<"\"";
 		if(i<num-1){
-			std::cout<<",";
+			log<<",";
 		}
 	}
-	std::cout<<"}.\n";
+	log<<"}.";
 }
 
 template<>
 void print_array(const int& arr,const char* msg){
-	std::cout<<msg<<": "<<arr<<std::endl;
+	logStream(LogLevel::INFO)<<msg<<": "<<arr;
 }
 
 void Config::LoadConfigFile(int argc, char **argv, const std::string &file)
 {
 	if (init)return;
 	init = true;
-	std::cout << "Start parsing the config file for Helmet Detection" << std::endl;
+	YAML::Node config;
+//	config = YAML::LoadFile(file);
+	std::ifstream ai_model(file, std::ios::in);
+	const bool loaded = (bool)ai_model;
+	if (loaded) {
+		std::stringstream m_str;
+		m_str << ai_model.rdbuf();
+		ai_model.close();
+		config = YAML::Load(m_str.str());
+	}
+	///@note logging options are applied first, so they also filter the messages of parsing.
+	if (config["PIPELINE"].IsDefined()) {
+		auto model_node = config["PIPELINE"];
+		if (model_node["LOG_LEVEL"].IsDefined()) {
+			LOG_LEVEL = model_node["LOG_LEVEL"].as<std::string>();
+		}
+		if (model_node["LOG_RATE_LIMIT"].IsDefined()) {
+			LOG_RATE_LIMIT = model_node["LOG_RATE_LIMIT"].as<unsigned int>();
+		}
+	}
+	LogLevel level = LogLevel::INFO;
+	if (!parseLogLevel(LOG_LEVEL, level)) {
+		logStream(LogLevel::ERROR) << "Unknown log level: " << LOG_LEVEL << ", using INFO." << std::endl;
+	}
+	AsyncLogger::Instance().SetLevel(level);
+	AsyncLogger::Instance().SetRateLimit(LOG_RATE_LIMIT);
+
+	logStream(LogLevel::INFO) << "Start parsing the config file for Helmet Detection" << std::endl;
 	MODEL_NAME = DEPLOY_MODEL;
-	std::cout << "Read from cmake config with model name: " << DEPLOY_MODEL << std::endl;
+	logStream(LogLevel::INFO) << "Read from cmake config with model name: " << DEPLOY_MODEL << std::endl;
 	INPUT_NAME = parseNames(MODEL_INPUT_NAME, ' ');
 	print_array(INPUT_NAME,"Read from cmake config with inputs");
 	OUTPUT_NAMES.clear();
@@ -78,29 +109,22 @@ void Config::LoadConfigFile(int argc, char **argv, const std::string &file)
 	print_array(OUTPUT_NAMES,"Read from cmake config with outputs");
 
 	if (!checkFileExist(file)) {
-		std::cerr << "Config file non exists! Aborting..." << std::endl;
+		logStream(LogLevel::ERROR) << "Config file non exists! Aborting..." << std::endl;
 	}
-
-	YAML::Node config;
-//	config = YAML::LoadFile(file);
-	std::ifstream ai_model(file, std::ios::in);
-	if (!ai_model) {
+	if (!loaded) {
 		return;
 	}
-	std::stringstream m_str;
-	m_str << ai_model.rdbuf();
-	ai_model.close();
-	config = YAML::Load(m_str.str());
+	logStream(LogLevel::INFO) << "Read from YAML with log level: " << LOG_LEVEL << ", rate limit: " << LOG_RATE_LIMIT << std::endl;
 
 	if (config["MODEL"].IsDefined()) {
 		auto model_node = config["MODEL"];
 		if (model_node["MODEL_NAME"].IsDefined()) {
 			MODEL_NAME = model_node["MODEL_NAME"].as<std::string>();
-			std::cout << "Read from YAML with model name: " << MODEL_NAME << std::endl;
+			logStream(LogLevel::INFO) << "Read from YAML with model name: " << MODEL_NAME << std::endl;
 		}
 		if (model_node["BACKBONE"].IsDefined()) {
 			BACKBONE = model_node["BACKBONE"].as<std::string>();
-			std::cout << "Read from YAML with backbone: " << BACKBONE << std::endl;
+			logStream(LogLevel::INFO) << "Read from YAML with backbone: " << BACKBONE << std::endl;
 		}
 		if (model_node["INPUT_NAME"].IsDefined()) {
 			INPUT_NAME.clear();
@@ -112,20 +136,66 @@ void Config::LoadConfigFile(int argc, char **argv, const std::string &file)
 			OUTPUT_NAMES = model_node["OUTPUT_NAMES"].as<std::vector<std::string>>();
 			print_array(OUTPUT_NAMES,"Read from YAML with outputs");
 		}
+		if (model_node["OUTPUT_SHAPES"].IsDefined()) {
+			OUTPUT_SHAPES = model_node["OUTPUT_SHAPES"].as<std::vector<std::vector<int>>>();
+			for (const auto &shape : OUTPUT_SHAPES) {
+				print_array(shape,"Read from YAML with output shape");
+			}
+		}
+		if (model_node["OPT_PROFILE"].IsDefined()) {
+			OPT_PROFILE = model_node["OPT_PROFILE"].as<int>();
+			logStream(LogLevel::INFO) << "Read from YAML with optimization profile: " << OPT_PROFILE << std::endl;
+		}
+		if (model_node["BACKEND"].IsDefined()) {
+			BACKEND = model_node["BACKEND"].as<std::string>();
+			logStream(LogLevel::INFO) << "Read from YAML with backend: " << BACKEND << std::endl;
+		}
+		if (model_node["MOCK_DETS"].IsDefined()) {
+			MOCK_DETS = model_node["MOCK_DETS"].as<std::vector<float>>();
+			print_array(MOCK_DETS,"Read from YAML with mock detections");
+		}
+		if (model_node["MOCK_PATTERN"].IsDefined()) {
+			MOCK_PATTERN = model_node["MOCK_PATTERN"].as<std::string>();
+			logStream(LogLevel::INFO) << "Read from YAML with mock pattern: " << MOCK_PATTERN << std::endl;
+		}
+		if (model_node["MOCK_LATENCY_MS"].IsDefined()) {
+			MOCK_LATENCY_MS = model_node["MOCK_LATENCY_MS"].as<float>();
+			logStream(LogLevel::INFO) << "Read from YAML with mock latency: " << MOCK_LATENCY_MS << std::endl;
+		}
+		if (model_node["INPUT_DTYPE"].IsDefined()) {
+			INPUT_DTYPE = model_node["INPUT_DTYPE"].as<std::string>();
+			logStream(LogLevel::INFO) << "Read from YAML with input dtype: " << INPUT_DTYPE << std::endl;
+		}
 	}
 	else {
-		std::cerr << "Please set MODEL, " << std::endl;
+		logStream(LogLevel::ERROR) << "Please set MODEL, " << std::endl;
 	}
 
 	if (config["DATA"].IsDefined()) {
 		auto model_node = config["DATA"];
 		if (model_node["VIDEO_NAME"].IsDefined()) {
 			VIDEO_FILE = model_node["VIDEO_NAME"].as<std::string>();
-			std::cout << "Read from YAML with videos: " << VIDEO_FILE << std::endl;
+			logStream(LogLevel::INFO) << "Read from YAML with videos: " << VIDEO_FILE << std::endl;
 		}
 		if (model_node["RTSP_SITE"].IsDefined()) {
 			RTSP_SITE = model_node["RTSP_SITE"].as<std::string>();
-			std::cout << "Read from YAML with backbone: " << RTSP_SITE << std::endl;
+			logStream(LogLevel::INFO) << "Read from YAML with rtsp site: " << RTSP_SITE << std::endl;
+		}
+		if (model_node["SOURCE"].IsDefined()) {
+			SOURCE = model_node["SOURCE"].as<std::string>();
+			logStream(LogLevel::INFO) << "Read from YAML with source: " << SOURCE << std::endl;
+		}
+		if (model_node["RECONNECT_MIN_MS"].IsDefined()) {
+			RECONNECT_MIN_MS = model_node["RECONNECT_MIN_MS"].as<int>();
+			logStream(LogLevel::INFO) << "Read from YAML with reconnect min ms: " << RECONNECT_MIN_MS << std::endl;
+		}
+		if (model_node["RECONNECT_MAX_MS"].IsDefined()) {
+			RECONNECT_MAX_MS = model_node["RECONNECT_MAX_MS"].as<int>();
+			logStream(LogLevel::INFO) << "Read from YAML with reconnect max ms: " << RECONNECT_MAX_MS << std::endl;
+		}
+		if (model_node["RECONNECT_RETRIES"].IsDefined()) {
+			RECONNECT_RETRIES = model_node["RECONNECT_RETRIES"].as<int>();
+			logStream(LogLevel::INFO) << "Read from YAML with reconnect retries: " << RECONNECT_RETRIES << std::endl;
 		}
 		if (model_node["INPUT_SHAPE"].IsDefined()) {
 			INPUT_SHAPE = model_node["INPUT_SHAPE"].as<std::vector<int>>();
@@ -133,54 +203,142 @@ void Config::LoadConfigFile(int argc, char **argv, const std::string &file)
 		}
 	}
 	else {
-		std::cerr << "Please set DATA..." << std::endl;
+		logStream(LogLevel::ERROR) << "Please set DATA..." << std::endl;
 	}
 
 	if (config["PIPELINE"].IsDefined()) {
 		auto model_node = config["PIPELINE"];
 		if (model_node["STRIDE"].IsDefined()) {
 			STRIDE = model_node["STRIDE"].as<unsigned int>();
-			std::cout << "Read from YAML with stride: " << STRIDE << std::endl;
+			logStream(LogLevel::INFO) << "Read from YAML with stride: " << STRIDE << std::endl;
 		}
 		if (model_node["INTERP"].IsDefined()) {
 			INTERP = model_node["INTERP"].as<unsigned int>();
-			std::cout << "Read from YAML with interpolation: " << INTERP << std::endl;
+			logStream(LogLevel::INFO) << "Read from YAML with interpolation: " << INTERP << std::endl;
 		}
 		if (model_node["SAMPLE_INTERVAL"].IsDefined()) {
 			SAMPLE_INTERVAL = model_node["SAMPLE_INTERVAL"].as<unsigned int>();
-			std::cout << "Read from YAML with sample interval: " << SAMPLE_INTERVAL << std::endl;
+			logStream(LogLevel::INFO) << "Read from YAML with sample interval: " << SAMPLE_INTERVAL << std::endl;
 		}
 		if (model_node["TRIGGER_LEN"].IsDefined()) {
 			TRIGGER_LEN = model_node["TRIGGER_LEN"].as<unsigned int>();
-			std::cout << "Read from YAML with trigger length: " << TRIGGER_LEN << std::endl;
+			logStream(LogLevel::INFO) << "Read from YAML with trigger length: " << TRIGGER_LEN << std::endl;
+		}
+		if (model_node["TRIGGER_STRIDE"].IsDefined()) {
+			TRIGGER_STRIDE = model_node["TRIGGER_STRIDE"].as<unsigned int>();
+			logStream(LogLevel::INFO) << "Read from YAML with trigger stride: " << TRIGGER_STRIDE << std::endl;
 		}
 		if (model_node["BATCH_SIZE"].IsDefined()) {
 			BATCH_SIZE = model_node["BATCH_SIZE"].as<unsigned int>();
-			std::cout << "Read from YAML with batch size: " << BATCH_SIZE << std::endl;
+			logStream(LogLevel::INFO) << "Read from YAML with batch size: " << BATCH_SIZE << std::endl;
 		}
 		if (model_node["THRESHOLD"].IsDefined()) {
 			THRESHOLD = model_node["THRESHOLD"].as<float>();
-			std::cout << "Read from YAML with threshold: " << THRESHOLD << std::endl;
+			logStream(LogLevel::INFO) << "Read from YAML with threshold: " << THRESHOLD << std::endl;
 		}
 		if (model_node["SCORE_THRESHOLD"].IsDefined()) {
 			SCORE_THRESHOLD = model_node["SCORE_THRESHOLD"].as<float>();
-			std::cout << "Read from YAML with score threshold: " << SCORE_THRESHOLD << std::endl;
+			logStream(LogLevel::INFO) << "Read from YAML with score threshold: " << SCORE_THRESHOLD << std::endl;
 		}
 		if (model_node["TARGET_CLASS"].IsDefined()) {
 			TARGET_CLASS = model_node["TARGET_CLASS"].as<unsigned int>();
-			std::cout << "Read from YAML with target class: " << TARGET_CLASS << std::endl;
+			logStream(LogLevel::INFO) << "Read from YAML with target class: " << TARGET_CLASS << std::endl;
 		}
 		if (model_node["ENABLE_SCALE"].IsDefined()) {
 			ENABLE_SCALE = model_node["ENABLE_SCALE"].as<bool>();
-			std::cout << "Read from YAML with enable scale: " << ENABLE_SCALE << std::endl;
+			logStream(LogLevel::INFO) << "Read from YAML with enable scale: " << ENABLE_SCALE << std::endl;
 		}
 		if (model_node["KEEP_RATIO"].IsDefined()) {
 			KEEP_RATIO = model_node["KEEP_RATIO"].as<bool>();
-			std::cout << "Read from YAML with keep ratio option: " << KEEP_RATIO << std::endl;
+			logStream(LogLevel::INFO) << "Read from YAML with keep ratio option: " << KEEP_RATIO << std::endl;
 		}
 		if (model_node["TIMING"].IsDefined()) {
 			TIMING = model_node["TIMING"].as<bool>();
-			std::cout << "Read from YAML with timing: " << TIMING << std::endl;
+			logStream(LogLevel::INFO) << "Read from YAML with timing: " << TIMING << std::endl;
+		}
+		if (model_node["TIMING_FILE"].IsDefined()) {
+			TIMING_FILE = model_node["TIMING_FILE"].as<std::string>();
+			logStream(LogLevel::INFO) << "Read from YAML with timing file: " << TIMING_FILE << std::endl;
+		}
+		if (model_node["TRACE"].IsDefined()) {
+			TRACE = model_node["TRACE"].as<bool>();
+			logStream(LogLevel::INFO) << "Read from YAML with trace: " << TRACE << std::endl;
+		}
+		if (model_node["TRACE_FILE"].IsDefined()) {
+			TRACE_FILE = model_node["TRACE_FILE"].as<std::string>();
+			logStream(LogLevel::INFO) << "Read from YAML with trace file: " << TRACE_FILE << std::endl;
+		}
+		if (model_node["TRACE_SAMPLING"].IsDefined()) {
+			TRACE_SAMPLING = model_node["TRACE_SAMPLING"].as<int>();
+			logStream(LogLevel::INFO) << "Read from YAML with trace sampling: " << TRACE_SAMPLING << std::endl;
+		}
+		if (model_node["TRACE_BUFFER_SIZE"].IsDefined()) {
+			TRACE_BUFFER_SIZE = model_node["TRACE_BUFFER_SIZE"].as<unsigned int>();
+			logStream(LogLevel::INFO) << "Read from YAML with trace buffer size: " << TRACE_BUFFER_SIZE << std::endl;
+		}
+		if (model_node["WARMUP_NUM"].IsDefined()) {
+			WARMUP_NUM = model_node["WARMUP_NUM"].as<int>();
+			logStream(LogLevel::INFO) << "Read from YAML with warm up number: " << WARMUP_NUM << std::endl;
+		}
+		if (model_node["PASS_THROUGH"].IsDefined()) {
+			PASS_THROUGH = model_node["PASS_THROUGH"].as<bool>();
+			logStream(LogLevel::INFO) << "Read from YAML with pass through: " << PASS_THROUGH << std::endl;
+		}
+		if (model_node["PLAN_CACHE_SIZE"].IsDefined()) {
+			PLAN_CACHE_SIZE = model_node["PLAN_CACHE_SIZE"].as<unsigned int>();
+			logStream(LogLevel::INFO) << "Read from YAML with plan cache size: " << PLAN_CACHE_SIZE << std::endl;
+		}
+		if (model_node["CPU_THREADS"].IsDefined()) {
+			CPU_THREADS = model_node["CPU_THREADS"].as<unsigned int>();
+			logStream(LogLevel::INFO) << "Read from YAML with cpu threads: " << CPU_THREADS << std::endl;
+		}
+		if (model_node["PLACEMENT"].IsDefined()) {
+			PLACEMENT = model_node["PLACEMENT"].as<std::string>();
+			logStream(LogLevel::INFO) << "Read from YAML with placement: " << PLACEMENT << std::endl;
+		}
+		if (model_node["PLACEMENT_SMT"].IsDefined()) {
+			PLACEMENT_SMT = model_node["PLACEMENT_SMT"].as<bool>();
+			logStream(LogLevel::INFO) << "Read from YAML with placement smt: " << PLACEMENT_SMT << std::endl;
+		}
+		if (model_node["PLACEMENT_GPU_LOCAL"].IsDefined()) {
+			PLACEMENT_GPU_LOCAL = model_node["PLACEMENT_GPU_LOCAL"].as<bool>();
+			logStream(LogLevel::INFO) << "Read from YAML with placement gpu local: " << PLACEMENT_GPU_LOCAL << std::endl;
+		}
+		if (model_node["PLACEMENT_BIND_MEMORY"].IsDefined()) {
+			PLACEMENT_BIND_MEMORY = model_node["PLACEMENT_BIND_MEMORY"].as<bool>();
+			logStream(LogLevel::INFO) << "Read from YAML with placement bind memory: " << PLACEMENT_BIND_MEMORY << std::endl;
+		}
+		if (model_node["PLACEMENT_RESERVED_CPUS"].IsDefined()) {
+			PLACEMENT_RESERVED_CPUS = model_node["PLACEMENT_RESERVED_CPUS"].as<std::vector<int>>();
+			print_array(PLACEMENT_RESERVED_CPUS, "Read from YAML with placement reserved cpus");
+		}
+		if (model_node["ASYNC_IN_FLIGHT"].IsDefined()) {
+			ASYNC_IN_FLIGHT = model_node["ASYNC_IN_FLIGHT"].as<int>();
+			logStream(LogLevel::INFO) << "Read from YAML with async in flight: " << ASYNC_IN_FLIGHT << std::endl;
+		}
+		if (model_node["EVIDENCE"].IsDefined()) {
+			EVIDENCE = model_node["EVIDENCE"].as<bool>();
+			logStream(LogLevel::INFO) << "Read from YAML with evidence: " << EVIDENCE << std::endl;
+		}
+		if (model_node["EVIDENCE_DIR"].IsDefined()) {
+			EVIDENCE_DIR = model_node["EVIDENCE_DIR"].as<std::string>();
+			logStream(LogLevel::INFO) << "Read from YAML with evidence dir: " << EVIDENCE_DIR << std::endl;
+		}
+		if (model_node["EVIDENCE_CROP"].IsDefined()) {
+			EVIDENCE_CROP = model_node["EVIDENCE_CROP"].as<bool>();
+			logStream(LogLevel::INFO) << "Read from YAML with evidence crop: " << EVIDENCE_CROP << std::endl;
+		}
+		if (model_node["EVIDENCE_MARGIN"].IsDefined()) {
+			EVIDENCE_MARGIN = model_node["EVIDENCE_MARGIN"].as<float>();
+			logStream(LogLevel::INFO) << "Read from YAML with evidence margin: " << EVIDENCE_MARGIN << std::endl;
+		}
+		if (model_node["EVIDENCE_QUALITY"].IsDefined()) {
+			EVIDENCE_QUALITY = model_node["EVIDENCE_QUALITY"].as<int>();
+			logStream(LogLevel::INFO) << "Read from YAML with evidence quality: " << EVIDENCE_QUALITY << std::endl;
+		}
+		if (model_node["EVIDENCE_QUEUE"].IsDefined()) {
+			EVIDENCE_QUEUE = model_node["EVIDENCE_QUEUE"].as<unsigned int>();
+			logStream(LogLevel::INFO) << "Read from YAML with evidence queue: " << EVIDENCE_QUEUE << std::endl;
 		}
 		if (model_node["TARGET_SIZE"].IsDefined()) {
 			TARGET_SIZE = model_node["TARGET_SIZE"].as<std::vector<int>>();
@@ -192,7 +350,7 @@ void Config::LoadConfigFile(int argc, char **argv, const std::string &file)
 		}
 		if (model_node["SHORT_SIZE"].IsDefined()) {
 			SHORT_SIZE = model_node["SHORT_SIZE"].as<unsigned int>();
-			std::cout << "Read from YAML with short size: " << SHORT_SIZE << std::endl;
+			logStream(LogLevel::INFO) << "Read from YAML with short size: " << SHORT_SIZE << std::endl;
 		}
 		if (model_node["PIPELINE_TYPE"].IsDefined()) {
 			PIPELINE_TYPE = model_node["PIPELINE_TYPE"].as<std::vector<std::string>>();
@@ -213,14 +371,14 @@ void Config::LoadConfigFile(int argc, char **argv, const std::string &file)
 
 	}
 	else {
-		std::cerr << "Please set PIPELINE, " << std::endl;
+		logStream(LogLevel::ERROR) << "Please set PIPELINE, " << std::endl;
 	}
 
 	if (config["POSTPROCESS"].IsDefined()) {
 		auto model_node = config["POSTPROCESS"];
 		if (model_node["POST_MODE"].IsDefined()) {
 			POST_MODE = model_node["POST_MODE"].as<int>();
-			std::cout << "Read from YAML with post mode: " << POST_MODE << std::endl;
+			logStream(LogLevel::INFO) << "Read from YAML with post mode: " << POST_MODE << std::endl;
 		}
 		if (model_node["TEXT_COLOR"].IsDefined()) {
 			TEXT_COLOR = model_node["TEXT_COLOR"].as<std::vector<unsigned char>>();
@@ -244,34 +402,82 @@ void Config::LoadConfigFile(int argc, char **argv, const std::string &file)
 		}
 		if (model_node["TEXT_LINE_WIDTH"].IsDefined()) {
 			TEXT_LINE_WIDTH = model_node["TEXT_LINE_WIDTH"].as<float>();
-			std::cout << "Read from YAML with text line width: " << TEXT_LINE_WIDTH << std::endl;
+			logStream(LogLevel::INFO) << "Read from YAML with text line width: " << TEXT_LINE_WIDTH << std::endl;
 		}
 		if (model_node["BOX_LINE_WIDTH"].IsDefined()) {
 			BOX_LINE_WIDTH = model_node["BOX_LINE_WIDTH"].as<int>();
-			std::cout << "Read from YAML with box line width: " << BOX_LINE_WIDTH << std::endl;
+			logStream(LogLevel::INFO) << "Read from YAML with box line width: " << BOX_LINE_WIDTH << std::endl;
 		}
 		if (model_node["TEXT_FONT_SIZE"].IsDefined()) {
 			TEXT_FONT_SIZE = model_node["TEXT_FONT_SIZE"].as<float>();
-			std::cout << "Read from YAML with text font size: " << TEXT_FONT_SIZE << std::endl;
+			logStream(LogLevel::INFO) << "Read from YAML with text font size: " << TEXT_FONT_SIZE << std::endl;
 		}
 		if (model_node["TEXT_OFF_X"].IsDefined()) {
 			TEXT_OFF_X = model_node["TEXT_OFF_X"].as<int>();
 			if (TEXT_OFF_X < 0) {
 				TEXT_OFF_X = INPUT_SHAPE.back() / 2 - 5;
 			}
-			std::cout << "Read from YAML with text pos offset x: " << TEXT_OFF_X << std::endl;
+			logStream(LogLevel::INFO) << "Read from YAML with text pos offset x: " << TEXT_OFF_X << std::endl;
 		}
 		if (model_node["TEXT_OFF_Y"].IsDefined()) {
 			TEXT_OFF_Y = model_node["TEXT_OFF_Y"].as<int>();
-			std::cout << "Read from YAML with text pos offset y: " << TEXT_OFF_Y << std::endl;
+			logStream(LogLevel::INFO) << "Read from YAML with text pos offset y: " << TEXT_OFF_Y << std::endl;
 		}
 		if (model_node["ALARM_COUNT"].IsDefined()) {
 			ALARM_COUNT = model_node["ALARM_COUNT"].as<int>();
-			std::cout << "Read from YAML with ALARM_COUNT: " << ALARM_COUNT << std::endl;
+			logStream(LogLevel::INFO) << "Read from YAML with ALARM_COUNT: " << ALARM_COUNT << std::endl;
+		}
+		if (model_node["ALARM_MODE"].IsDefined()) {
+			ALARM_MODE = model_node["ALARM_MODE"].as<std::string>();
+			logStream(LogLevel::INFO) << "Read from YAML with ALARM_MODE: " << ALARM_MODE << std::endl;
+		}
+		if (model_node["ALARM_WINDOW_MS"].IsDefined()) {
+			ALARM_WINDOW_MS = model_node["ALARM_WINDOW_MS"].as<int>();
+			logStream(LogLevel::INFO) << "Read from YAML with ALARM_WINDOW_MS: " << ALARM_WINDOW_MS << std::endl;
+		}
+		if (model_node["ALARM_ON_RATIO"].IsDefined()) {
+			ALARM_ON_RATIO = model_node["ALARM_ON_RATIO"].as<float>();
+			logStream(LogLevel::INFO) << "Read from YAML with ALARM_ON_RATIO: " << ALARM_ON_RATIO << std::endl;
+		}
+		if (model_node["ALARM_OFF_RATIO"].IsDefined()) {
+			ALARM_OFF_RATIO = model_node["ALARM_OFF_RATIO"].as<float>();
+			logStream(LogLevel::INFO) << "Read from YAML with ALARM_OFF_RATIO: " << ALARM_OFF_RATIO << std::endl;
+		}
+		if (model_node["ALARM_MIN_EVIDENCE"].IsDefined()) {
+			ALARM_MIN_EVIDENCE = model_node["ALARM_MIN_EVIDENCE"].as<int>();
+			logStream(LogLevel::INFO) << "Read from YAML with ALARM_MIN_EVIDENCE: " << ALARM_MIN_EVIDENCE << std::endl;
+		}
+		if (model_node["ALARM_COOLDOWN_MS"].IsDefined()) {
+			ALARM_COOLDOWN_MS = model_node["ALARM_COOLDOWN_MS"].as<int>();
+			logStream(LogLevel::INFO) << "Read from YAML with ALARM_COOLDOWN_MS: " << ALARM_COOLDOWN_MS << std::endl;
+		}
+		if (model_node["ALARM_GRID"].IsDefined()) {
+			ALARM_GRID = model_node["ALARM_GRID"].as<std::vector<int>>();
+			print_array(ALARM_GRID, "Read from YAML with ALARM_GRID");
+		}
+		if (model_node["ALARM_WINDOW_CAPACITY"].IsDefined()) {
+			ALARM_WINDOW_CAPACITY = model_node["ALARM_WINDOW_CAPACITY"].as<int>();
+			logStream(LogLevel::INFO) << "Read from YAML with ALARM_WINDOW_CAPACITY: " << ALARM_WINDOW_CAPACITY << std::endl;
+		}
+		if (model_node["SMOOTH_METHOD"].IsDefined()) {
+			SMOOTH_METHOD = model_node["SMOOTH_METHOD"].as<std::string>();
+			logStream(LogLevel::INFO) << "Read from YAML with SMOOTH_METHOD: " << SMOOTH_METHOD << std::endl;
+		}
+		if (model_node["SMOOTH_TAU_MS"].IsDefined()) {
+			SMOOTH_TAU_MS = model_node["SMOOTH_TAU_MS"].as<int>();
+			logStream(LogLevel::INFO) << "Read from YAML with SMOOTH_TAU_MS: " << SMOOTH_TAU_MS << std::endl;
+		}
+		if (model_node["SMOOTH_WINDOW"].IsDefined()) {
+			SMOOTH_WINDOW = model_node["SMOOTH_WINDOW"].as<int>();
+			logStream(LogLevel::INFO) << "Read from YAML with SMOOTH_WINDOW: " << SMOOTH_WINDOW << std::endl;
+		}
+		if (model_node["SMOOTH_THRESHOLD"].IsDefined()) {
+			SMOOTH_THRESHOLD = model_node["SMOOTH_THRESHOLD"].as<float>();
+			logStream(LogLevel::INFO) << "Read from YAML with SMOOTH_THRESHOLD: " << SMOOTH_THRESHOLD << std::endl;
 		}
 		if (model_node["POSTPROCESS_NAME"].IsDefined()) {
 			POSTPROCESS_NAME = model_node["POSTPROCESS_NAME"].as<std::string>();
-			std::cout << "Read from YAML with post process name: " << POSTPROCESS_NAME << std::endl;
+			logStream(LogLevel::INFO) << "Read from YAML with post process name: " << POSTPROCESS_NAME << std::endl;
 		}
 		if (model_node["POST_TEXT"].IsDefined()) {
 			POST_TEXT = model_node["POST_TEXT"].as<std::vector<std::string>>();
@@ -280,11 +486,35 @@ void Config::LoadConfigFile(int argc, char **argv, const std::string &file)
 		}
 		if (model_node["POST_TEXT_FONT_FILE"].IsDefined()) {
 			POST_TEXT_FONT_FILE = model_node["POST_TEXT_FONT_FILE"].as<std::string>();
-			std::cout << "Read from YAML with post text fonts: "<<POST_TEXT_FONT_FILE<<std::endl;
+			logStream(LogLevel::INFO) << "Read from YAML with post text fonts: "<<POST_TEXT_FONT_FILE<<std::endl;
+		}
+		if (model_node["NMS_MODE"].IsDefined()) {
+			NMS_MODE = model_node["NMS_MODE"].as<std::string>();
+			logStream(LogLevel::INFO) << "Read from YAML with nms mode: " << NMS_MODE << std::endl;
+		}
+		if (model_node["RAW_FORMAT"].IsDefined()) {
+			RAW_FORMAT = model_node["RAW_FORMAT"].as<std::string>();
+			logStream(LogLevel::INFO) << "Read from YAML with raw format: " << RAW_FORMAT << std::endl;
+		}
+		if (model_node["NUM_CLASSES"].IsDefined()) {
+			NUM_CLASSES = model_node["NUM_CLASSES"].as<int>();
+			logStream(LogLevel::INFO) << "Read from YAML with number of classes: " << NUM_CLASSES << std::endl;
+		}
+		if (model_node["IOU_THRESHOLD"].IsDefined()) {
+			IOU_THRESHOLD = model_node["IOU_THRESHOLD"].as<float>();
+			logStream(LogLevel::INFO) << "Read from YAML with iou threshold: " << IOU_THRESHOLD << std::endl;
+		}
+		if (model_node["NMS_PRE_TOP_K"].IsDefined()) {
+			NMS_PRE_TOP_K = model_node["NMS_PRE_TOP_K"].as<int>();
+			logStream(LogLevel::INFO) << "Read from YAML with nms pre top k: " << NMS_PRE_TOP_K << std::endl;
+		}
+		if (model_node["NMS_TOP_K"].IsDefined()) {
+			NMS_TOP_K = model_node["NMS_TOP_K"].as<int>();
+			logStream(LogLevel::INFO) << "Read from YAML with nms top k: " << NMS_TOP_K << std::endl;
 		}
 	}
 	else {
-		std::cerr << "Please set MODEL, " << std::endl;
+		logStream(LogLevel::ERROR) << "Please set MODEL, " << std::endl;
 	}
 
 	if (argc < 2)return;
@@ -313,18 +543,18 @@ void Config::LoadConfigFile(int argc, char **argv, const std::string &file)
 	}
 	if (!ModelName.empty()) {
 		MODEL_NAME = ModelName;
-		std::cout<<"Read from cmd with model file: "<<MODEL_NAME<<std::endl;
+		logStream(LogLevel::INFO)<<"Read from cmd with model file: "<<MODEL_NAME<<std::endl;
 	}
 
 	if (!helmet::checkFileExist(MODEL_NAME)) {
-		std::cout << MODEL_NAME << std::endl;
-		std::cerr << "Model does not exists!" << std::endl;
-		std::cerr << "Please check the model path..." << std::endl;
+		logStream(LogLevel::INFO) << MODEL_NAME << std::endl;
+		logStream(LogLevel::ERROR) << "Model does not exists!" << std::endl;
+		logStream(LogLevel::ERROR) << "Please check the model path..." << std::endl;
 	}
 
 	if (!VideoFile.empty()) {
 		VIDEO_FILE = VideoFile;
-		std::cout<<"Read from cmd with video file: "<<VIDEO_FILE<<std::endl;
+		logStream(LogLevel::INFO)<<"Read from cmd with video file: "<<VIDEO_FILE<<std::endl;
 	}
 }
 
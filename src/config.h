@@ -28,14 +28,26 @@ public:
 	std::string BACKBONE = "ResNet50";
 	std::string VIDEO_FILE;
 	std::string RTSP_SITE = "/url/to/rtsp/site";
+	std::string SOURCE = "file";
+	int RECONNECT_MIN_MS = 500;
+	int RECONNECT_MAX_MS = 10000;
+	int RECONNECT_RETRIES = -1;
 	std::vector<int> INPUT_SHAPE = {1, 8, 3, 320, 320};
 	std::vector<std::string> INPUT_NAME = {"im_shape", "image", "scale_factor"};
 	std::vector<std::string> OUTPUT_NAMES = {"dets", "num_dets"};
+	std::vector<std::vector<int>> OUTPUT_SHAPES = {{1, 100, 6}, {1}};///< mock backend, and bounds of data dependent TensorRT outputs.
+	int OPT_PROFILE = 0;///< optimization profile of the engine, its largest batch and resolution are allocated.
+	std::string BACKEND = "tensorrt";///< "tensorrt" or "mock".
+	std::vector<float> MOCK_DETS = {};///< scripted detections, [class, score, x_min, y_min, x_max, y_max] each.
+	std::string MOCK_PATTERN = "1";///< cycled per inference, '1' emits MOCK_DETS and '0' emits nothing.
+	float MOCK_LATENCY_MS = 0.0f;///< fake compute latency of mock backend.
+	std::string INPUT_DTYPE = "auto";///< "auto", "float32", "float16" or "uint8", element type of image input.
 
 	unsigned int STRIDE = 2;
 	unsigned int INTERP = 0;
 	unsigned int SAMPLE_INTERVAL = 1;
-	unsigned int TRIGGER_LEN = 1;
+	unsigned int TRIGGER_LEN = 1;///< sampled frames per inference call, > 1 feeds them as one clip.
+	unsigned int TRIGGER_STRIDE = 1;///< new frames between two clips, consecutive clips overlap by the rest.
 	unsigned int BATCH_SIZE = 1;
 	float THRESHOLD = 0.8f;
 	float SCORE_THRESHOLD = 0.6f;
@@ -52,6 +64,29 @@ public:
 	bool ENABLE_SCALE = true;
 	bool KEEP_RATIO = true;
 	bool TIMING = true;
+	std::string TIMING_FILE = "";
+	bool TRACE = false;
+	std::string TRACE_FILE = "";
+	int TRACE_SAMPLING = 1;
+	unsigned int TRACE_BUFFER_SIZE = 16384;
+	std::string LOG_LEVEL = "INFO";
+	unsigned int LOG_RATE_LIMIT = 0;
+	int WARMUP_NUM = 3;
+	bool PASS_THROUGH = true;
+	unsigned int PLAN_CACHE_SIZE = 4;
+	unsigned int CPU_THREADS = 0;
+	std::string PLACEMENT = "none";
+	bool PLACEMENT_SMT = true;
+	bool PLACEMENT_GPU_LOCAL = true;
+	bool PLACEMENT_BIND_MEMORY = true;
+	std::vector<int> PLACEMENT_RESERVED_CPUS = {};
+	int ASYNC_IN_FLIGHT = 4;
+	bool EVIDENCE = false;
+	std::string EVIDENCE_DIR = "./evidence";
+	bool EVIDENCE_CROP = false;
+	float EVIDENCE_MARGIN = 0.25f;
+	int EVIDENCE_QUALITY = 90;
+	unsigned int EVIDENCE_QUEUE = 8;
 	int POST_MODE = 0;
 	std::vector<unsigned char> TEXT_COLOR = {0, 0, 255};
 	std::vector<unsigned char> BOX_COLOR = {0, 0, 255};
@@ -63,9 +98,27 @@ public:
 	int TEXT_OFF_X = 450;
 	int TEXT_OFF_Y = 50;
 	int ALARM_COUNT = 5;
+	std::string ALARM_MODE = "count";
+	int ALARM_WINDOW_MS = 2000;
+	float ALARM_ON_RATIO = 0.6f;
+	float ALARM_OFF_RATIO = 0.3f;
+	int ALARM_MIN_EVIDENCE = 3;
+	int ALARM_COOLDOWN_MS = 10000;
+	std::vector<int> ALARM_GRID = {1, 1};
+	int ALARM_WINDOW_CAPACITY = 64;
+	std::string SMOOTH_METHOD = "none";
+	int SMOOTH_TAU_MS = 600;
+	int SMOOTH_WINDOW = 8;
+	float SMOOTH_THRESHOLD = 0.5f;
 	std::string POSTPROCESS_NAME = "HelmetDetectionPost";
 	std::vector<std::string> POST_TEXT = {"未佩戴安全帽", "佩戴安全帽"};
 	std::string POST_TEXT_FONT_FILE = "";
+	std::string NMS_MODE = "model";
+	std::string RAW_FORMAT = "yolov5";
+	int NUM_CLASSES = 2;
+	float IOU_THRESHOLD = 0.45f;
+	int NMS_PRE_TOP_K = 1000;
+	int NMS_TOP_K = 100;
 	bool init = false;
 };
 }
\ No newline at end of file
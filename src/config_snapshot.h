@@ -0,0 +1,180 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <opencv2/core/mat.hpp>
+#include "config.h"
+#include "util.h"
+
+namespace helmet
+{
+/**
+ * @brief parameters of one instance which can be changed at runtime.
+ * @details a snapshot is immutable once published, a change is made by copying the current snapshot, <!--
+ * --> modifying the copy and publishing it as a new version.
+ */
+struct RuntimeParams
+{
+	uint64_t version = 0;///< increased by every publish.
+	float SCORE_THRESHOLD = 0.6f;
+	int ALARM_COUNT = 5;
+	int SAMPLE_DATA = 3;///< sampling interval, one in every SAMPLE_DATA frames is inferred.
+	int TARGET_H = 0;///< network input height, within the optimization profile of the engine.
+	int TARGET_W = 0;///< network input width.
+	std::vector<int> pointNum;///< number of points of each ROI polygon, empty for full frame.
+	std::vector<cv::Point> points;///< ROI polygon points.
+	cv::Mat roi_img;///< CV_8UC3 ROI mask at frame size.
+	cv::Mat roi_small;///< CV_8UC1 ROI mask at train size, empty for full frame.
+
+	/**
+	 * @brief initialize the runtime parameters from config.
+	 */
+	explicit RuntimeParams(const Config &config)
+	{
+		SCORE_THRESHOLD = config.SCORE_THRESHOLD;
+		ALARM_COUNT = config.ALARM_COUNT;
+		SAMPLE_DATA = config.SAMPLE_DATA;
+		TARGET_H = config.TARGET_SIZE[config.TARGET_SIZE.size() - 2];
+		TARGET_W = config.TARGET_SIZE[config.TARGET_SIZE.size() - 1];
+	}
+};
+
+/**
+ * @brief RCU style cell holding an immutable snapshot, readers never lock.
+ * @details readers register in an atomic counter, then load the snapshot pointer; writers swap the pointer <!--
+ * --> under a writer only mutex and retire the old snapshot. Retired snapshots are reclaimed once the reader <!--
+ * --> count is observed zero after the swap, since any reader starting later can only load the new pointer. <!--
+ * --> Reclamation is deferred to later publishes and the destructor, thus writers never wait for readers.
+ * @note a reader must not keep the snapshot pointer after its ReadGuard is destroyed.
+ * @example:
+ * @code
+ * 	RcuCell<RuntimeParams> cell(createUniqueRef<RuntimeParams>(*config));
+ * 	{
+ * 		RcuCell<RuntimeParams>::ReadGuard snap(cell);
+ * 		if (score > snap->SCORE_THRESHOLD) ...
+ * 	}
+ * 	cell.Update([](RuntimeParams &next) { next.SCORE_THRESHOLD = 0.7f; });
+ * @endcode
+ */
+template<typename T>
+class RcuCell final
+{
+public:
+	explicit RcuCell(UniqueRef<T> initial)
+	{
+		m_current.store(initial.release(), std::memory_order_release);
+	}
+
+	~RcuCell()
+	{
+		delete m_current.load(std::memory_order_acquire);
+		for (auto *p : m_retired) {
+			delete p;
+		}
+	}
+
+	RcuCell(const RcuCell &) = delete;
+	RcuCell &operator=(const RcuCell &) = delete;
+
+	/**
+	 * @brief RAII read side critical section.
+	 */
+	class ReadGuard final
+	{
+	public:
+		explicit ReadGuard(const RcuCell &cell)
+			: m_cell(cell)
+		{
+			m_cell.m_readers.fetch_add(1, std::memory_order_seq_cst);
+			m_ptr = m_cell.m_current.load(std::memory_order_seq_cst);
+		}
+		~ReadGuard()
+		{
+			m_cell.m_readers.fetch_sub(1, std::memory_order_release);
+		}
+		ReadGuard(const ReadGuard &) = delete;
+		ReadGuard &operator=(const ReadGuard &) = delete;
+
+		const T *operator->() const
+		{
+			return m_ptr;
+		}
+		const T &operator*() const
+		{
+			return *m_ptr;
+		}
+		const T *get() const
+		{
+			return m_ptr;
+		}
+	private:
+		const RcuCell &m_cell;
+		const T *m_ptr = nullptr;
+	};
+
+	/**
+	 * @brief copy the current snapshot for modification.
+	 * @return private copy owned by the caller.
+	 */
+	UniqueRef<T> Copy() const
+	{
+		ReadGuard guard(*this);
+		return createUniqueRef<T>(*guard);
+	}
+
+	/**
+	 * @brief publish a new snapshot, the old one is reclaimed later.
+	 * @param next new snapshot.
+	 */
+	void Publish(UniqueRef<T> next)
+	{
+		std::lock_guard<std::mutex> lock(m_writer);
+		Swap(std::move(next));
+	}
+
+	/**
+	 * @brief copy, modify and publish atomically with respect to other writers.
+	 * @param modify callable taking T&, applied to a copy of the current snapshot.
+	 */
+	template<typename FUNC>
+	void Update(FUNC &&modify)
+	{
+		std::lock_guard<std::mutex> lock(m_writer);
+		///@note the current snapshot can only be replaced by writers, so no read guard is needed here.
+		auto next = createUniqueRef<T>(*m_current.load(std::memory_order_acquire));
+		modify(*next);
+		Swap(std::move(next));
+	}
+
+private:
+	/**
+	 * @brief swap in a new snapshot and retire the old one, m_writer must be held.
+	 */
+	void Swap(UniqueRef<T> next)
+	{
+		T *old = m_current.exchange(next.release(), std::memory_order_seq_cst);
+		m_retired.push_back(old);
+		Reclaim();
+	}
+
+	/**
+	 * @brief free the retired snapshots if no reader is active, m_writer must be held.
+	 */
+	void Reclaim()
+	{
+		if (m_readers.load(std::memory_order_seq_cst) != 0)return;
+		for (auto *p : m_retired) {
+			delete p;
+		}
+		m_retired.clear();
+	}
+
+private:
+	std::atomic<T *> m_current = nullptr;
+	mutable std::atomic<int> m_readers = 0;
+	std::mutex m_writer;
+	std::vector<T *> m_retired;///< swapped out snapshots waiting for reclamation.
+};
+
+}
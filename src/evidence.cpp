@@ -0,0 +1,204 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <opencv2/imgcodecs.hpp>
+#include "evidence.h"
+#include "log.h"
+#include "trace.h"
+#include "util.h"
+
+namespace helmet
+{
+
+std::mutex EvidenceWriter::s_mtx;
+bool EvidenceWriter::s_configured = false;
+EvidenceOptions EvidenceWriter::s_options;
+
+bool EvidenceWriter::Configure(const EvidenceOptions &options)
+{
+	std::lock_guard<std::mutex> lock(s_mtx);
+	if (s_configured)return false;
+	s_options = options;
+	s_configured = true;
+	return true;
+}
+
+EvidenceWriter &EvidenceWriter::Instance()
+{
+	static EvidenceWriter writer;
+	return writer;
+}
+
+EvidenceWriter::EvidenceWriter()
+{
+	{
+		std::lock_guard<std::mutex> lock(s_mtx);
+		///@note later Configure() calls are ignored once the writer exists.
+		s_configured = true;
+		m_options = s_options;
+	}
+	m_options.capacity = std::max<size_t>(1, m_options.capacity);
+	m_free.resize(m_options.capacity);
+	std::error_code ec;
+	std::filesystem::create_directories(m_options.dir, ec);
+	if (ec) {
+		logStream(LogLevel::ERROR) << "Cannot create evidence directory " << m_options.dir << ": " << ec.message() << std::endl;
+	}
+	m_thread = std::thread(&EvidenceWriter::Loop, this);
+}
+
+EvidenceWriter::~EvidenceWriter()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mtx);
+		m_stop = true;
+	}
+	m_not_empty.notify_all();
+	if (m_thread.joinable())m_thread.join();
+}
+
+cv::Rect EvidenceWriter::Area(const cv::Size &frame, const std::vector<cv_Detection> &dets) const
+{
+	const cv::Rect full(0, 0, frame.width, frame.height);
+	if (!m_options.crop || dets.empty())return full;
+	int x0 = dets[0].x_min, y0 = dets[0].y_min, x1 = dets[0].x_max, y1 = dets[0].y_max;
+	for (const auto &d : dets) {
+		x0 = std::min(x0, d.x_min);
+		y0 = std::min(y0, d.y_min);
+		x1 = std::max(x1, d.x_max);
+		y1 = std::max(y1, d.y_max);
+	}
+	const int dx = (int)((float)(x1 - x0) * m_options.margin);
+	const int dy = (int)((float)(y1 - y0) * m_options.margin);
+	const cv::Rect area = cv::Rect(x0 - dx, y0 - dy, x1 - x0 + 2 * dx, y1 - y0 + 2 * dy) & full;
+	return area.empty() ? full : area;
+}
+
+bool EvidenceWriter::Capture(const cv::Mat &frame, int stream, int64_t frame_index, const std::vector<cv_Detection> &dets)
+{
+	if (frame.empty())return false;
+	Job job;
+	{
+		std::lock_guard<std::mutex> lock(m_mtx);
+		if (m_free.empty()) {
+			m_dropped++;
+			return false;
+		}
+		job = std::move(m_free.back());
+		m_free.pop_back();
+		m_busy++;
+	}
+	job.area = Area(frame.size(), dets);
+	///@note the buffer only grows, a crop is copied into its corner so it is never reallocated for a smaller one.
+	if (job.buffer.type() != frame.type() || job.buffer.cols < frame.cols || job.buffer.rows < frame.rows) {
+		job.buffer.create(frame.size(), frame.type());
+	}
+	frame(job.area).copyTo(job.buffer(cv::Rect(0, 0, job.area.width, job.area.height)));
+	job.stream = stream;
+	job.frame = frame_index;
+	job.time_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+		std::chrono::system_clock::now().time_since_epoch()).count();
+	job.dets.assign(dets.begin(), dets.end());
+	{
+		std::lock_guard<std::mutex> lock(m_mtx);
+		m_queue.push_back(std::move(job));
+	}
+	m_captured++;
+	m_not_empty.notify_one();
+	return true;
+}
+
+bool EvidenceWriter::Write(const Job &job)
+{
+	const std::string stem = m_options.dir + "/" + std::to_string(job.stream) + "_" + std::to_string(job.frame) + "_" +
+		std::to_string(job.time_ms);
+	const cv::Mat snapshot = job.buffer(cv::Rect(0, 0, job.area.width, job.area.height));
+	if (!cv::imencode(".jpg", snapshot, m_jpeg, {cv::IMWRITE_JPEG_QUALITY, m_options.quality}))return false;
+	FILE *fp = fopen((stem + ".jpg").c_str(), "wb");
+	if (!fp)return false;
+	const bool ok = fwrite(m_jpeg.data(), 1, m_jpeg.size(), fp) == m_jpeg.size();
+	fclose(fp);
+	if (!ok)return false;
+
+	std::ofstream meta(stem + ".json");
+	meta << "{\"stream\":" << job.stream << ",\"frame\":" << job.frame << ",\"time_ms\":" << job.time_ms
+		 << ",\"area\":[" << job.area.x << "," << job.area.y << "," << job.area.width << "," << job.area.height
+		 << "],\"detections\":[";
+	for (size_t i = 0; i < job.dets.size(); ++i) {
+		const auto &d = job.dets[i];
+		meta << (i ? "," : "") << "{\"class_id\":" << d.class_id << ",\"score\":" << d.score << ",\"box\":["
+			 << d.x_min << "," << d.y_min << "," << d.x_max << "," << d.y_max << "]}";
+	}
+	meta << "]}\n";
+	return (bool)meta;
+}
+
+void EvidenceWriter::Loop()
+{
+	Tracer::Instance().SetThreadName("evidence");
+	while (true) {
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock(m_mtx);
+			m_not_empty.wait(lock, [this] { return m_stop || !m_queue.empty(); });
+			///@note queued snapshots are still written at shutdown, they are the evidence of raised alarms.
+			if (m_queue.empty())break;
+			job = std::move(m_queue.front());
+			m_queue.pop_front();
+		}
+		const int64_t start = steadyMicros();
+		if (Write(job)) {
+			m_written++;
+		}
+		else {
+			m_failed++;
+			logStream(LogLevel::WARNING) << "Cannot write evidence of stream " << job.stream << " frame " << job.frame
+										 << " to " << m_options.dir << std::endl;
+		}
+		m_latency.Record((uint64_t)(steadyMicros() - start));
+		{
+			std::lock_guard<std::mutex> lock(m_mtx);
+			m_free.push_back(std::move(job));
+			m_busy--;
+			if (m_busy > 0)continue;
+		}
+		m_idle.notify_all();
+	}
+}
+
+bool EvidenceWriter::Flush(int timeout_ms)
+{
+	std::unique_lock<std::mutex> lock(m_mtx);
+	auto idle = [this] { return m_busy == 0; };
+	if (timeout_ms < 0) {
+		m_idle.wait(lock, idle);
+		return true;
+	}
+	return m_idle.wait_for(lock, std::chrono::milliseconds(timeout_ms), idle);
+}
+
+EvidenceWriter::Stats EvidenceWriter::GetStats() const
+{
+	Stats stats;
+	stats.captured = m_captured;
+	stats.written = m_written;
+	stats.dropped = m_dropped;
+	stats.failed = m_failed;
+	std::lock_guard<std::mutex> lock(m_mtx);
+	stats.depth = m_busy;
+	return stats;
+}
+
+const LatencyHistogram &EvidenceWriter::Latency() const
+{
+	return m_latency;
+}
+
+const EvidenceOptions &EvidenceWriter::Options() const
+{
+	return m_options;
+}
+
+}
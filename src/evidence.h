@@ -0,0 +1,146 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <opencv2/core/mat.hpp>
+#include "latency_stats.h"
+#include "model.h"
+
+namespace helmet
+{
+struct EvidenceOptions
+{
+	std::string dir = "./evidence";///< output directory, created if missing.
+	bool crop = false;///< keep only the area around the detections instead of the whole frame.
+	float margin = 0.25f;///< crop only, the area is grown by this share of its size on every side.
+	int quality = 90;///< JPEG quality.
+	size_t capacity = 8;///< snapshots waiting for encoding, also the size of buffer pool.
+};
+
+/**
+ * @brief alarm evidence, JPEG snapshots written to disk by a background encoder.
+ * @details Capture() copies the frame, or the crop around the detections, into a buffer taken from a fixed pool <!--
+ * --> and returns, the encoder thread compresses it and writes "<stream>_<frame>_<time>.jpg" with a JSON sidecar <!--
+ * --> holding the detections. If every buffer is in use the snapshot is dropped and counted, so an alarm burst <!--
+ * --> never stalls the processing threads. The buffers are allocated at frame size once and then reused.
+ * @note shared by all streams of the process, the first Configure() decides the options.
+ * @example:
+ * @code
+ * 	EvidenceWriter::Configure(options);
+ * 	if (alarm)EvidenceWriter::Instance().Capture(frame, stream_id, frame_index, dets);
+ * 	auto stats = EvidenceWriter::Instance().GetStats();
+ * @endcode
+ */
+class EvidenceWriter final
+{
+public:
+	struct Stats
+	{
+		uint64_t captured = 0;///< snapshots accepted into the queue.
+		uint64_t written = 0;///< snapshots encoded and written.
+		uint64_t dropped = 0;///< snapshots discarded since no buffer was free.
+		uint64_t failed = 0;///< snapshots which could not be encoded or written.
+		size_t depth = 0;///< snapshots waiting or being encoded.
+	};
+
+public:
+	/**
+	 * @brief set the options before the writer is created.
+	 * @return false if the writer already exists, the options are ignored then.
+	 */
+	static bool Configure(const EvidenceOptions &options);
+
+	static EvidenceWriter &Instance();
+
+	/**
+	 * @brief encode the queued snapshots and join the encoder thread.
+	 */
+	~EvidenceWriter();
+
+	EvidenceWriter(const EvidenceWriter &) = delete;
+	EvidenceWriter &operator=(const EvidenceWriter &) = delete;
+
+	/**
+	 * @brief queue a snapshot, never blocks on the encoder.
+	 * @param frame BGR frame, copied.
+	 * @param stream stream id used in the file name.
+	 * @param frame_index index of the frame in its stream.
+	 * @param dets detections which raised the alarm, in frame coordinates.
+	 * @return false if dropped.
+	 */
+	bool Capture(const cv::Mat &frame, int stream, int64_t frame_index, const std::vector<cv_Detection> &dets);
+
+	/**
+	 * @brief wait until every queued snapshot is written.
+	 * @param timeout_ms timeout, negative to wait forever.
+	 * @return true if nothing is pending.
+	 */
+	bool Flush(int timeout_ms);
+
+	Stats GetStats() const;
+
+	/**
+	 * @brief get the encode and write latency of the snapshots.
+	 */
+	const LatencyHistogram &Latency() const;
+
+	const EvidenceOptions &Options() const;
+
+private:
+	EvidenceWriter();
+
+	struct Job
+	{
+		cv::Mat buffer;///< frame sized, the snapshot is its top left corner.
+		cv::Rect area;///< area of the frame kept.
+		int stream = 0;
+		int64_t frame = 0;
+		int64_t time_ms = 0;///< wall clock time of the capture.
+		std::vector<cv_Detection> dets;
+	};
+
+	/**
+	 * @brief get the area of the frame to be kept.
+	 */
+	cv::Rect Area(const cv::Size &frame, const std::vector<cv_Detection> &dets) const;
+
+	/**
+	 * @brief encode and write one snapshot.
+	 * @return false if failed.
+	 */
+	bool Write(const Job &job);
+
+	/**
+	 * @brief encoder thread main loop.
+	 */
+	void Loop();
+
+private:
+	static std::mutex s_mtx;
+	static bool s_configured;
+	static EvidenceOptions s_options;
+
+	EvidenceOptions m_options;
+	mutable std::mutex m_mtx;
+	std::condition_variable m_not_empty;
+	std::condition_variable m_idle;
+	std::deque<Job> m_queue;
+	std::vector<Job> m_free;///< recycled jobs, their buffers and detection vectors are reused.
+	size_t m_busy = 0;///< jobs taken from the pool and not given back yet.
+	bool m_stop = false;
+	std::vector<unsigned char> m_jpeg;///< used by the encoder thread only.
+	LatencyHistogram m_latency;
+
+	std::atomic<uint64_t> m_captured = 0;
+	std::atomic<uint64_t> m_written = 0;
+	std::atomic<uint64_t> m_dropped = 0;
+	std::atomic<uint64_t> m_failed = 0;
+	std::thread m_thread;
+};
+
+}
@@ -0,0 +1,200 @@
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include "latency_stats.h"
+
+namespace helmet
+{
+
+const char *stageName(Stage stage)
+{
+	static const char *names[] = {"decode", "roi_mask", "preprocess", "infer",
+								  "decode_results", "draw", "encode"};
+	auto idx = (int)stage;
+	if (idx < 0 || idx >= (int)Stage::NUM)return "unknown";
+	return names[idx];
+}
+
+LatencyHistogram::LatencyHistogram()
+{
+	for (auto &i : m_buckets) {
+		i.store(0, std::memory_order_relaxed);
+	}
+}
+
+int LatencyHistogram::BucketIndex(uint64_t us)
+{
+	if (us < SUB_COUNT)return (int)us;
+	int e = 63 - __builtin_clzll(us);
+	if (e >= MAX_EXP)return BUCKETS - 1;
+	int sub = (int)(us >> (e - SUB_BITS)) & (SUB_COUNT - 1);
+	return (e - SUB_BITS + 1) * SUB_COUNT + sub;
+}
+
+void LatencyHistogram::BucketRange(int idx, uint64_t &lower, uint64_t &width)
+{
+	int group = idx / SUB_COUNT;
+	int sub = idx % SUB_COUNT;
+	if (group == 0) {
+		lower = sub;
+		width = 1;
+		return;
+	}
+	int shift = group - 1;
+	lower = (uint64_t)(SUB_COUNT + sub) << shift;
+	width = (uint64_t)1 << shift;
+}
+
+void LatencyHistogram::Record(uint64_t us)
+{
+	m_buckets[BucketIndex(us)].fetch_add(1, std::memory_order_relaxed);
+	m_count.fetch_add(1, std::memory_order_relaxed);
+	m_sum.fetch_add(us, std::memory_order_relaxed);
+	auto prev = m_max.load(std::memory_order_relaxed);
+	while (us > prev && !m_max.compare_exchange_weak(prev, us, std::memory_order_relaxed));
+}
+
+double LatencyHistogram::Percentile(double q) const
+{
+	auto total = Count();
+	if (total == 0)return 0.0;
+	q = std::min(std::max(q, 0.0), 1.0);
+	auto rank = (uint64_t)std::ceil(q * (double)total);
+	if (rank == 0)rank = 1;
+	uint64_t acc = 0;
+	for (int i = 0; i < BUCKETS; ++i) {
+		acc += m_buckets[i].load(std::memory_order_relaxed);
+		if (acc >= rank) {
+			uint64_t lower, width;
+			BucketRange(i, lower, width);
+			///@note report the bucket middle, never beyond the observed maximum.
+			double mid = (double)lower + (double)(width - 1) / 2.0;
+			return std::min(mid, (double)Max());
+		}
+	}
+	return (double)Max();
+}
+
+uint64_t LatencyHistogram::Count() const
+{
+	return m_count.load(std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::Max() const
+{
+	return m_max.load(std::memory_order_relaxed);
+}
+
+double LatencyHistogram::Mean() const
+{
+	auto total = Count();
+	if (total == 0)return 0.0;
+	return (double)m_sum.load(std::memory_order_relaxed) / (double)total;
+}
+
+LatencyRegistry &LatencyRegistry::Instance()
+{
+	static LatencyRegistry registry;
+	return registry;
+}
+
+LatencyRegistry::~LatencyRegistry()
+{
+	if (m_dump_file.empty())return;
+	std::ofstream out(m_dump_file, std::ios::out | std::ios::trunc);
+	if (!out) {
+		std::cerr << "Cannot write latency statistics to: " << m_dump_file << std::endl;
+		return;
+	}
+	DumpJson(out);
+}
+
+StreamContext &LatencyRegistry::Current()
+{
+	static thread_local StreamContext current;
+	return current;
+}
+
+SharedRef<StreamLatency> LatencyRegistry::Acquire(const void *key, bool enabled)
+{
+	std::lock_guard<std::mutex> lock(m_mtx);
+	auto it = m_active.find(key);
+	if (it != m_active.end())return it->second;
+	auto stream = createSharedRef<StreamLatency>();
+	stream->id = m_next_id++;
+	stream->enabled = enabled;
+	m_all.push_back(stream);
+	m_active[key] = stream;
+	return stream;
+}
+
+SharedRef<StreamLatency> LatencyRegistry::Find(const void *key)
+{
+	std::lock_guard<std::mutex> lock(m_mtx);
+	auto it = m_active.find(key);
+	if (it != m_active.end())return it->second;
+	return nullptr;
+}
+
+void LatencyRegistry::Release(const void *key)
+{
+	std::lock_guard<std::mutex> lock(m_mtx);
+	auto it = m_active.find(key);
+	if (it == m_active.end())return;
+	auto stream = it->second;
+	m_active.erase(it);
+	m_all.erase(std::remove(m_all.begin(), m_all.end(), stream), m_all.end());
+	///@note only the summary is kept for the exit dump, the histograms are freed with the stream.
+	if (!m_dump_file.empty() && stream->enabled) {
+		std::ostringstream os;
+		WriteStream(os, *stream);
+		m_retired.push_back(os.str());
+	}
+}
+
+void LatencyRegistry::SetDumpFile(const std::string &file)
+{
+	std::lock_guard<std::mutex> lock(m_mtx);
+	m_dump_file = file;
+}
+
+void LatencyRegistry::WriteStream(std::ostream &os, const StreamLatency &stream)
+{
+	os << "{\"id\":" << stream.id << ",\"stages\":{";
+	for (int i = 0; i < (int)Stage::NUM; ++i) {
+		const auto &h = stream.stages[i];
+		if (i > 0)os << ",";
+		os << "\"" << stageName((Stage)i) << "\":{"
+		   << "\"count\":" << h.Count()
+		   << ",\"mean_us\":" << h.Mean()
+		   << ",\"max_us\":" << h.Max()
+		   << ",\"p50_us\":" << h.Percentile(0.5)
+		   << ",\"p90_us\":" << h.Percentile(0.9)
+		   << ",\"p99_us\":" << h.Percentile(0.99)
+		   << ",\"p999_us\":" << h.Percentile(0.999) << "}";
+	}
+	os << "}}";
+}
+
+void LatencyRegistry::DumpJson(std::ostream &os) const
+{
+	std::lock_guard<std::mutex> lock(m_mtx);
+	os << "{\"streams\":[";
+	bool first = true;
+	for (const auto &retired : m_retired) {
+		if (!first)os << ",";
+		first = false;
+		os << retired;
+	}
+	for (const auto &stream : m_all) {
+		if (!stream->enabled)continue;
+		if (!first)os << ",";
+		first = false;
+		WriteStream(os, *stream);
+	}
+	os << "]}" << std::endl;
+}
+
+}
@@ -0,0 +1,257 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "util.h"
+#include "trace.h"
+
+namespace helmet
+{
+/**
+ * @brief pipeline stages being timed, the order is the same as EStage in model.h.
+ */
+enum class Stage
+{
+	DECODE = 0,///< grab and retrieve a frame from source.
+	ROI_MASK = 1,///< masking out the area outside ROI.
+	PREPROCESS = 2,///< upload, colour conversion, resize and normalization.
+	INFER = 3,///< inference including copies to and from device.
+	DECODE_RESULTS = 4,///< decoding model outputs into boxes and alarm.
+	DRAW = 5,///< drawing boxes, text and ROI.
+	ENCODE = 6,///< encoding the output frame.
+	NUM = 7
+};
+
+/**
+ * @brief get printable name of a stage.
+ * @param stage pipeline stage.
+ * @return stage name in lower case.
+ */
+extern const char *stageName(Stage stage);
+
+/**
+ * @brief lock free latency histogram with log-linear buckets.
+ * @details values below 2^SUB_BITS us are counted exactly, above that each power of two range is split <!--
+ * --> into 2^SUB_BITS linear sub buckets, giving a relative error below 1/2^SUB_BITS over the whole range.
+ * @note Record() only does relaxed atomic increments, it can be called from any thread.
+ */
+class LatencyHistogram final
+{
+public:
+	static constexpr int SUB_BITS = 4;
+	static constexpr int SUB_COUNT = 1 << SUB_BITS;
+	static constexpr int MAX_EXP = 40;///< values from 2^MAX_EXP us on are clamped into the last bucket.
+	static constexpr int BUCKETS = (MAX_EXP - SUB_BITS + 1) * SUB_COUNT;
+
+public:
+	LatencyHistogram();
+
+	/**
+	 * @brief record one sample.
+	 * @param us latency in microseconds.
+	 */
+	void Record(uint64_t us);
+
+	/**
+	 * @brief get the latency at given quantile.
+	 * @param q quantile in [0, 1], e.g. 0.99 for p99.
+	 * @return latency in microseconds, 0 if nothing is recorded.
+	 */
+	double Percentile(double q) const;
+
+	uint64_t Count() const;
+	uint64_t Max() const;
+	double Mean() const;
+
+	/**
+	 * @brief map a value to its bucket.
+	 * @param us latency in microseconds.
+	 * @return bucket index.
+	 */
+	static int BucketIndex(uint64_t us);
+
+	/**
+	 * @brief get the value range of a bucket.
+	 * @param idx bucket index.
+	 * @param lower lower bound, inclusive.
+	 * @param width bucket width.
+	 */
+	static void BucketRange(int idx, uint64_t &lower, uint64_t &width);
+
+private:
+	std::atomic<uint64_t> m_buckets[BUCKETS];
+	std::atomic<uint64_t> m_count = 0;
+	std::atomic<uint64_t> m_sum = 0;
+	std::atomic<uint64_t> m_max = 0;
+};
+
+/**
+ * @brief latency histograms of every stage for one stream.
+ */
+struct StreamLatency
+{
+	int id = 0;///< stream id, in order of allocation.
+	bool enabled = true;///< record histograms, i.e. TIMING is on.
+	LatencyHistogram stages[(int)Stage::NUM];
+
+	/**
+	 * @brief record one sample of given stage.
+	 */
+	void Record(Stage stage, uint64_t us)
+	{
+		stages[(int)stage].Record(us);
+	}
+};
+
+/**
+ * @brief the stream and frame being processed on current thread.
+ */
+struct StreamContext
+{
+	StreamLatency *stream = nullptr;
+	int64_t frame = -1;
+};
+
+/**
+ * @brief process wide registry of per stream latency statistics.
+ * @details streams are registered with an opaque key, i.e. the cvModel pointer. The statistics are kept after <!--
+ * --> the stream is released and dumped as JSON at exit if a dump file is set.
+ */
+class LatencyRegistry final
+{
+public:
+	static LatencyRegistry &Instance();
+
+	/**
+	 * @brief dump statistics if a dump file is set.
+	 */
+	~LatencyRegistry();
+
+	/**
+	 * @brief get or create the statistics of a stream.
+	 * @param key opaque stream key.
+	 * @param enabled record histograms of this stream, the stream id is still used by tracing if not.
+	 * @return stream statistics.
+	 */
+	SharedRef<StreamLatency> Acquire(const void *key, bool enabled = true);
+
+	/**
+	 * @brief find the statistics of a stream.
+	 * @param key opaque stream key.
+	 * @return stream statistics, nullptr if the stream is not registered.
+	 */
+	SharedRef<StreamLatency> Find(const void *key);
+
+	/**
+	 * @brief unregister a stream, so streams created and destroyed over time do not pile up.
+	 * @details if a dump file is set, the summary of the stream is kept for the exit dump.
+	 * @param key opaque stream key.
+	 */
+	void Release(const void *key);
+
+	/**
+	 * @brief set the file the statistics are dumped to at exit.
+	 * @param file JSON file, empty to disable dumping.
+	 */
+	void SetDumpFile(const std::string &file);
+
+	/**
+	 * @brief write statistics of all enabled streams as JSON.
+	 * @param os output stream.
+	 */
+	void DumpJson(std::ostream &os) const;
+
+	/**
+	 * @brief the stream and frame recorded by StageTimer on current thread.
+	 * @return reference to thread local context.
+	 */
+	static StreamContext &Current();
+
+private:
+	LatencyRegistry() = default;
+
+	/**
+	 * @brief write the JSON summary of one stream.
+	 */
+	static void WriteStream(std::ostream &os, const StreamLatency &stream);
+
+private:
+	mutable std::mutex m_mtx;
+	std::unordered_map<const void *, SharedRef<StreamLatency>> m_active;
+	std::vector<SharedRef<StreamLatency>> m_all;///< registered streams in creation order, dumped at exit.
+	std::vector<std::string> m_retired;///< JSON summaries of released streams, dumped before m_all.
+	std::string m_dump_file;
+	int m_next_id = 0;///< ids are not reused, released streams are not confused with later ones.
+};
+
+/**
+ * @brief RAII helper binding a stream and frame to current thread.
+ */
+class StreamScope final
+{
+public:
+	explicit StreamScope(StreamLatency *stream, int64_t frame = -1)
+	{
+		auto &ctx = LatencyRegistry::Current();
+		m_prev = ctx;
+		ctx.stream = stream;
+		ctx.frame = frame;
+	}
+	~StreamScope()
+	{
+		LatencyRegistry::Current() = m_prev;
+	}
+private:
+	StreamContext m_prev;
+};
+
+/**
+ * @brief RAII timer recording a stage into the stream bound to current thread, and into the tracer if the frame <!--
+ * --> is sampled.
+ * @note if TIMING and tracing are off, only a thread local load and a relaxed atomic load are paid.
+ * @example:
+ * @code
+ * 	{
+ * 		StageTimer timer(Stage::PREPROCESS);
+ * 		m_preprocessor->Run(temp, blob, m_thread_stream);
+ * 	}
+ * @endcode
+ */
+class StageTimer final
+{
+public:
+	explicit StageTimer(Stage stage)
+	{
+		const auto &ctx = LatencyRegistry::Current();
+		if (!ctx.stream)return;
+		m_record = ctx.stream->enabled;
+		m_trace = Tracer::Instance().Sampled(ctx.frame);
+		if (m_record || m_trace) {
+			m_stream = ctx.stream;
+			m_frame = ctx.frame;
+			m_stage = stage;
+			m_start = Tracer::Instance().Now();
+		}
+	}
+	~StageTimer()
+	{
+		if (!m_stream)return;
+		auto dur = Tracer::Instance().Now() - m_start;
+		if (m_record)m_stream->Record(m_stage, dur);
+		if (m_trace)Tracer::Instance().Record(stageName(m_stage), m_start, dur, m_stream->id, m_frame);
+	}
+private:
+	StreamLatency *m_stream = nullptr;
+	int64_t m_frame = -1;
+	bool m_record = false;
+	bool m_trace = false;
+	Stage m_stage = Stage::DECODE;
+	uint64_t m_start = 0;
+};
+
+}
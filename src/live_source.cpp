@@ -0,0 +1,278 @@
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include "live_source.h"
+#include "log.h"
+#include "placement.h"
+#include "trace.h"
+
+namespace helmet
+{
+
+bool parseSourceKind(const std::string &name, SourceKind &kind)
+{
+	std::string lower(name);
+	std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+	if (lower == "file") {
+		kind = SourceKind::FILE;
+		return true;
+	}
+	if (lower == "loop") {
+		kind = SourceKind::LOOP;
+		return true;
+	}
+	if (lower == "rtsp") {
+		kind = SourceKind::RTSP;
+		return true;
+	}
+	return false;
+}
+
+LiveSource::Options sourceOptions(const Config &config)
+{
+	LiveSource::Options options;
+	if (!parseSourceKind(config.SOURCE, options.kind)) {
+		logStream(LogLevel::WARNING) << "Unknown source: " << config.SOURCE << ", using file." << std::endl;
+	}
+	options.uri = options.kind == SourceKind::RTSP ? config.RTSP_SITE : config.VIDEO_FILE;
+	options.reconnect_min_ms = std::max(1, config.RECONNECT_MIN_MS);
+	options.reconnect_max_ms = std::max(options.reconnect_min_ms, config.RECONNECT_MAX_MS);
+	options.max_retries = config.RECONNECT_RETRIES;
+	return options;
+}
+
+LiveSource::~LiveSource()
+{
+	Release();
+}
+
+bool LiveSource::Open(const Options &options)
+{
+	Release();
+	m_options = options;
+	if (m_options.uri.empty()) {
+		logStream(LogLevel::ERROR) << "Empty source uri." << std::endl;
+		return false;
+	}
+	m_captured = 0;
+	m_delivered = 0;
+	m_skipped = 0;
+	m_reconnects = 0;
+	m_failures = 0;
+	m_loops = 0;
+	m_stop = false;
+	m_eof = false;
+	m_full = false;
+	///@note a live source may come up later, it is connected by the capture thread with backoff.
+	if (m_options.kind != SourceKind::RTSP && !Connect()) {
+		logStream(LogLevel::ERROR) << "Cannot open source: " << m_options.uri << std::endl;
+		return false;
+	}
+	m_opened = true;
+	m_thread = std::thread(&LiveSource::Loop, this);
+	return true;
+}
+
+bool LiveSource::IsOpened() const
+{
+	return m_opened;
+}
+
+bool LiveSource::Connect()
+{
+	m_cap.release();
+	if (!m_cap.open(m_options.uri) || !m_cap.isOpened())return false;
+	m_fps = m_cap.get(cv::CAP_PROP_FPS);
+	m_width = m_cap.get(cv::CAP_PROP_FRAME_WIDTH);
+	m_height = m_cap.get(cv::CAP_PROP_FRAME_HEIGHT);
+	return true;
+}
+
+bool LiveSource::Backoff(int &delay_ms)
+{
+	std::unique_lock<std::mutex> lock(m_mtx);
+	m_changed.wait_for(lock, std::chrono::milliseconds(delay_ms), [this] { return m_stop; });
+	delay_ms = std::min(delay_ms * 2, m_options.reconnect_max_ms);
+	return !m_stop;
+}
+
+bool LiveSource::Pace(int64_t due_us)
+{
+	const auto due = std::chrono::steady_clock::time_point(std::chrono::microseconds(due_us));
+	std::unique_lock<std::mutex> lock(m_mtx);
+	m_changed.wait_until(lock, due, [this] { return m_stop; });
+	return !m_stop;
+}
+
+void LiveSource::Loop()
+{
+	Tracer::Instance().SetThreadName("capture");
+	const bool live = m_options.kind != SourceKind::FILE;
+	bool connected = m_options.kind != SourceKind::RTSP;
+	int delay_ms = m_options.reconnect_min_ms;
+	int failures = 0;///< in a row.
+	int64_t index = 0;
+	int64_t start_us = -1;///< LOOP only, time of frame 0 of the pacing clock.
+	int64_t paced = 0;///< LOOP only, frames paced since start_us.
+	cv::Mat back;
+	while (true) {
+		{
+			std::lock_guard<std::mutex> lock(m_mtx);
+			if (m_stop)break;
+		}
+		if (!connected) {
+			if (Connect()) {
+				connected = true;
+				if (failures > 0) {
+					m_reconnects++;
+					logStream(LogLevel::INFO) << "Reconnected to " << m_options.uri << " after " << failures
+											  << " failures" << std::endl;
+				}
+				failures = 0;
+				delay_ms = m_options.reconnect_min_ms;
+				continue;
+			}
+			m_failures++;
+			failures++;
+			if (m_options.max_retries >= 0 && failures > m_options.max_retries) {
+				logStream(LogLevel::ERROR) << "Giving up source " << m_options.uri << " after " << failures
+										   << " failures" << std::endl;
+				break;
+			}
+			if (!Backoff(delay_ms))break;
+			continue;
+		}
+		if (m_options.kind == SourceKind::LOOP) {
+			const double fps = m_fps > 0 ? m_fps.load() : 25.0;
+			const int64_t period = (int64_t)(1e6 / fps);
+			const int64_t now = steadyMicros();
+			///@note the clock is restarted after a stall, frames are not burst out to catch up.
+			if (start_us < 0 || now - (start_us + paced * period) > 1000000) {
+				start_us = now;
+				paced = 0;
+			}
+			if (!Pace(start_us + paced * period))break;
+			paced++;
+		}
+		bool ok;
+		{
+			StreamScope scope(m_stats.load(), index);
+			StageTimer timer(Stage::DECODE);
+			ok = m_cap.read(back) && !back.empty();
+		}
+		if (!ok) {
+			if (m_options.kind == SourceKind::FILE)break;
+			connected = false;
+			if (m_options.kind == SourceKind::LOOP) {
+				///@note rewound by reopening, which works for every backend, not counted as a failure.
+				m_loops++;
+				continue;
+			}
+			m_failures++;
+			failures++;
+			logStream(LogLevel::WARNING) << "Lost source " << m_options.uri << ", reconnecting." << std::endl;
+			m_cap.release();
+			if (!Backoff(delay_ms))break;
+			continue;
+		}
+		m_captured++;
+		{
+			std::unique_lock<std::mutex> lock(m_mtx);
+			if (!live) {
+				m_changed.wait(lock, [this] { return m_stop || !m_full; });
+				if (m_stop)break;
+			}
+			if (m_full)m_skipped++;
+			std::swap(m_mailbox.img, back);
+			m_mailbox.index = index;
+			m_mailbox.capture_us = steadyMicros();
+			m_full = true;
+		}
+		index++;
+		m_not_empty.notify_one();
+	}
+	m_cap.release();
+	{
+		std::lock_guard<std::mutex> lock(m_mtx);
+		m_eof = true;
+	}
+	m_not_empty.notify_all();
+}
+
+bool LiveSource::Read(Frame &frame, int timeout_ms)
+{
+	if (!m_opened)return false;
+	std::unique_lock<std::mutex> lock(m_mtx);
+	auto ready = [this] { return m_full || m_eof; };
+	if (timeout_ms < 0) {
+		m_not_empty.wait(lock, ready);
+	}
+	else if (!m_not_empty.wait_for(lock, std::chrono::milliseconds(timeout_ms), ready)) {
+		return false;
+	}
+	if (!m_full)return false;
+	std::swap(frame.img, m_mailbox.img);
+	frame.index = m_mailbox.index;
+	frame.capture_us = m_mailbox.capture_us;
+	m_full = false;
+	lock.unlock();
+	m_delivered++;
+	m_changed.notify_all();
+	return true;
+}
+
+double LiveSource::Get(int prop) const
+{
+	switch (prop) {
+	case cv::CAP_PROP_FPS:
+		return m_fps;
+	case cv::CAP_PROP_FRAME_WIDTH:
+		return m_width;
+	case cv::CAP_PROP_FRAME_HEIGHT:
+		return m_height;
+	default:
+		return 0.0;
+	}
+}
+
+void LiveSource::Release()
+{
+	if (!m_opened)return;
+	{
+		std::lock_guard<std::mutex> lock(m_mtx);
+		m_stop = true;
+	}
+	m_changed.notify_all();
+	m_not_empty.notify_all();
+	if (m_thread.joinable()) {
+		m_thread.join();
+	}
+	m_full = false;
+	m_opened = false;
+}
+
+LiveSource::Stats LiveSource::GetStats() const
+{
+	Stats stats;
+	stats.captured = m_captured;
+	stats.delivered = m_delivered;
+	stats.skipped = m_skipped;
+	stats.reconnects = m_reconnects;
+	stats.failures = m_failures;
+	stats.loops = m_loops;
+	return stats;
+}
+
+void LiveSource::SetLatencyStats(const SharedRef<StreamLatency> &stats)
+{
+	m_stats_ref = stats;
+	m_stats = stats.get();
+}
+
+bool LiveSource::SetAffinity(const std::vector<int> &cpus)
+{
+	if (!m_opened || !m_thread.joinable())return false;
+	return pinThread(m_thread.native_handle(), cpus);
+}
+
+}
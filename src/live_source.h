@@ -0,0 +1,194 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <opencv2/videoio.hpp>
+#include "config.h"
+#include "latency_stats.h"
+#include "util.h"
+
+namespace helmet
+{
+/**
+ * @brief kind of a frame source.
+ */
+enum class SourceKind
+{
+	FILE = 0,///< video file read as fast as consumed, no frame is skipped, ends at the end of file.
+	LOOP = 1,///< video file paced at its frame rate and looped, a local stand-in for a live camera.
+	RTSP = 2 ///< live stream, reconnected with backoff if it fails.
+};
+
+/**
+ * @brief parse "file", "loop" or "rtsp", case insensitive.
+ * @return true if parsed.
+ */
+extern bool parseSourceKind(const std::string &name, SourceKind &kind);
+
+/**
+ * @brief frame source with a capture thread and a latest-frame-wins mailbox.
+ * @details the capture thread decodes into a back buffer and swaps it into a single slot mailbox. For live <!--
+ * --> kinds a frame not read before the next one arrives is overwritten and counted as skipped, so the <!--
+ * --> consumer always gets the newest frame and the end-to-end latency stays bounded by one frame plus <!--
+ * --> processing instead of growing with a queue when analysis falls behind. For FILE the capture thread <!--
+ * --> waits for the consumer instead. A failed open or read of a live kind is retried with exponential <!--
+ * --> backoff from reconnect_min_ms to reconnect_max_ms. Buffers are swapped, never allocated per frame.
+ * @note Read() is expected to be called from a single consumer thread.
+ * @example:
+ * @code
+ * 	LiveSource source;
+ * 	source.Open(sourceOptions(*config));
+ * 	LiveSource::Frame frame;
+ * 	while (source.Read(frame, 1000)) {
+ * 		Process_Algorithm(model, frame.img);
+ * 	}
+ * 	auto stats = source.GetStats();
+ * @endcode
+ */
+class LiveSource final
+{
+public:
+	struct Options
+	{
+		SourceKind kind = SourceKind::FILE;
+		std::string uri;///< file name or rtsp url.
+		int reconnect_min_ms = 500;///< first delay after a failure.
+		int reconnect_max_ms = 10000;///< the delay doubles up to this.
+		int max_retries = -1;///< failures in a row before giving up, negative to retry forever.
+	};
+
+	struct Frame
+	{
+		cv::Mat img;///< decoded BGR image.
+		int64_t index = -1;///< frame index since Open(), counting skipped frames as well.
+		int64_t capture_us = 0;///< steadyMicros() when the frame was decoded, for end-to-end latency.
+	};
+
+	/**
+	 * @brief counters of the source, all values are accumulated since Open().
+	 */
+	struct Stats
+	{
+		uint64_t captured = 0;///< frames decoded.
+		uint64_t delivered = 0;///< frames handed to the consumer.
+		uint64_t skipped = 0;///< frames overwritten in the mailbox since the consumer lagged behind.
+		uint64_t reconnects = 0;///< successful reopenings after a failure.
+		uint64_t failures = 0;///< failed opens and reads.
+		uint64_t loops = 0;///< LOOP only, times the file was rewound.
+	};
+
+public:
+	LiveSource() = default;
+
+	/**
+	 * @brief stop and join the capture thread.
+	 */
+	~LiveSource();
+
+	LiveSource(const LiveSource &) = delete;
+	LiveSource &operator=(const LiveSource &) = delete;
+
+	/**
+	 * @brief start the capture thread, the source is opened there.
+	 * @return false if the uri is empty, or a FILE or LOOP source cannot be opened.
+	 */
+	bool Open(const Options &options);
+
+	bool IsOpened() const;
+
+	/**
+	 * @brief get the latest frame, blocking until a new one is available.
+	 * @details the buffer inside frame is swapped into the mailbox for reuse.
+	 * @param frame output frame.
+	 * @param timeout_ms timeout, negative to wait forever.
+	 * @return false if the source ended, gave up reconnecting, or timed out.
+	 */
+	bool Read(Frame &frame, int timeout_ms = -1);
+
+	/**
+	 * @brief get source property cached at the latest (re)connection.
+	 * @param prop one of cv::CAP_PROP_FPS, cv::CAP_PROP_FRAME_WIDTH, cv::CAP_PROP_FRAME_HEIGHT.
+	 * @return property value, 0 before connected.
+	 */
+	double Get(int prop) const;
+
+	/**
+	 * @brief stop capturing and close the source.
+	 */
+	void Release();
+
+	Stats GetStats() const;
+
+	/**
+	 * @brief record the decode latency of each frame into given stream statistics.
+	 * @param stats stream statistics, nullptr to stop recording.
+	 */
+	void SetLatencyStats(const SharedRef<StreamLatency> &stats);
+
+	/**
+	 * @brief pin the capture thread.
+	 * @param cpus CPU ids.
+	 * @return true if pinned, false if not opened or pinning failed.
+	 */
+	bool SetAffinity(const std::vector<int> &cpus);
+
+private:
+	/**
+	 * @brief open the source and cache its properties, called on the capture thread.
+	 */
+	bool Connect();
+
+	/**
+	 * @brief wait before the next attempt, returns early on Release().
+	 * @return false if stopped.
+	 */
+	bool Backoff(int &delay_ms);
+
+	/**
+	 * @brief wait until the frame is due, LOOP only.
+	 * @return false if stopped.
+	 */
+	bool Pace(int64_t due_us);
+
+	/**
+	 * @brief capture thread main loop.
+	 */
+	void Loop();
+
+private:
+	Options m_options;
+	cv::VideoCapture m_cap;///< owned by the capture thread once started.
+	std::thread m_thread;
+	mutable std::mutex m_mtx;
+	std::condition_variable m_not_empty;///< consumer waits for a new frame.
+	std::condition_variable m_changed;///< capture thread waits for the consumer or Release().
+	SharedRef<StreamLatency> m_stats_ref = nullptr;
+	std::atomic<StreamLatency *> m_stats = nullptr;
+	Frame m_mailbox;
+	bool m_full = false;///< m_mailbox holds a frame not read yet.
+	bool m_stop = false;
+	bool m_eof = false;
+	bool m_opened = false;
+
+	std::atomic<double> m_fps = 0.0;
+	std::atomic<double> m_width = 0.0;
+	std::atomic<double> m_height = 0.0;
+
+	std::atomic<uint64_t> m_captured = 0;
+	std::atomic<uint64_t> m_delivered = 0;
+	std::atomic<uint64_t> m_skipped = 0;
+	std::atomic<uint64_t> m_reconnects = 0;
+	std::atomic<uint64_t> m_failures = 0;
+	std::atomic<uint64_t> m_loops = 0;
+};
+
+/**
+ * @brief build the source options from config, RTSP_SITE for rtsp and VIDEO_FILE otherwise.
+ */
+extern LiveSource::Options sourceOptions(const Config &config);
+
+}
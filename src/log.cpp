@@ -0,0 +1,237 @@
+#include <algorithm>
+#include <cstdio>
+#include "log.h"
+
+namespace helmet
+{
+
+static const char *levelTag(LogLevel level)
+{
+	switch (level) {
+		case LogLevel::VERBOSE:
+			return "[V] ";
+		case LogLevel::INFO:
+			return "[I] ";
+		case LogLevel::WARNING:
+			return "[W] ";
+		case LogLevel::ERROR:
+			return "[E] ";
+		case LogLevel::FATAL:
+			return "[F] ";
+		default:
+			return "";
+	}
+}
+
+bool parseLogLevel(const std::string &name, LogLevel &level)
+{
+	std::string upper = name;
+	std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
+	static const char *names[] = {"VERBOSE", "INFO", "WARNING", "ERROR", "FATAL", "OFF"};
+	for (int i = 0; i <= (int)LogLevel::OFF; ++i) {
+		if (upper == names[i]) {
+			level = static_cast<LogLevel>(i);
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * @brief buffer of the current thread, shared with the logger so retiring it never touches the logger.
+ */
+struct LogLocal
+{
+	SharedRef<LogBuffer> buf = nullptr;
+
+	~LogLocal()
+	{
+		if (!buf)return;
+		std::lock_guard<std::mutex> lock(buf->mtx);
+		buf->retired = true;
+	}
+};
+
+static thread_local LogLocal t_local;
+
+AsyncLogger &AsyncLogger::Instance()
+{
+	static AsyncLogger logger;
+	return logger;
+}
+
+AsyncLogger::AsyncLogger()
+{
+	m_running = true;
+	m_thread = std::thread(&AsyncLogger::Loop, this);
+}
+
+AsyncLogger::~AsyncLogger()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mtx);
+		m_stop = true;
+	}
+	m_wake.notify_all();
+	if (m_thread.joinable()) {
+		m_thread.join();
+	}
+	m_running = false;
+	Drain();
+}
+
+void AsyncLogger::SetLevel(LogLevel level)
+{
+	m_level.store((int)level, std::memory_order_relaxed);
+}
+
+void AsyncLogger::SetRateLimit(unsigned int per_second)
+{
+	m_rate.store(per_second, std::memory_order_relaxed);
+}
+
+LogBuffer &AsyncLogger::Local()
+{
+	auto &local = t_local;
+	if (!local.buf) {
+		auto buf = createSharedRef<LogBuffer>();
+		buf->refill = std::chrono::steady_clock::now();
+		buf->tokens = (double)m_rate.load(std::memory_order_relaxed);
+		std::lock_guard<std::mutex> lock(m_mtx);
+		m_buffers.push_back(buf);
+		local.buf = buf;
+	}
+	return *local.buf;
+}
+
+bool AsyncLogger::Acquire(LogBuffer &buf)
+{
+	const auto rate = m_rate.load(std::memory_order_relaxed);
+	if (rate == 0)return true;
+	///@note token bucket, refilled at the given rate and holding one second of burst.
+	auto now = std::chrono::steady_clock::now();
+	buf.tokens += std::chrono::duration<double>(now - buf.refill).count() * rate;
+	buf.tokens = std::min(buf.tokens, (double)rate);
+	buf.refill = now;
+	if (buf.tokens < 1.0) {
+		buf.suppressed++;
+		return false;
+	}
+	buf.tokens -= 1.0;
+	return true;
+}
+
+void AsyncLogger::Write(LogLevel level, const std::string &msg)
+{
+	if (!Enabled(level) || level == LogLevel::OFF)return;
+	const bool is_err = level >= LogLevel::ERROR;
+	if (!m_running) {
+		std::fprintf(is_err ? stderr : stdout, "%s%s\n", levelTag(level), msg.c_str());
+		return;
+	}
+	auto &buf = Local();
+	if (!is_err && !Acquire(buf))return;
+
+	bool wake = level >= LogLevel::WARNING;
+	{
+		std::lock_guard<std::mutex> lock(buf.mtx);
+		if (buf.suppressed > 0) {
+			buf.out += levelTag(LogLevel::WARNING);
+			buf.out += std::to_string(buf.suppressed) + " messages suppressed by rate limit\n";
+			buf.suppressed = 0;
+		}
+		auto &dst = is_err ? buf.err : buf.out;
+		if (dst.size() + msg.size() > MAX_PENDING) {
+			buf.dropped++;
+			wake = true;
+		}
+		else {
+			dst += levelTag(level);
+			dst += msg;
+			dst += '\n';
+			wake = wake || dst.size() > MAX_PENDING / 2;
+		}
+	}
+	if (wake)m_wake.notify_one();
+}
+
+void AsyncLogger::Flush()
+{
+	Drain();
+}
+
+void AsyncLogger::Loop()
+{
+	std::unique_lock<std::mutex> lock(m_mtx);
+	while (!m_stop) {
+		m_wake.wait_for(lock, std::chrono::milliseconds(100));
+		lock.unlock();
+		Drain();
+		lock.lock();
+	}
+}
+
+void AsyncLogger::Drain()
+{
+	std::lock_guard<std::mutex> drain(m_drain_mtx);
+	std::vector<SharedRef<LogBuffer>> buffers;
+	{
+		std::lock_guard<std::mutex> lock(m_mtx);
+		buffers = m_buffers;
+	}
+	std::string out, err;
+	bool retired = false;
+	for (auto &buf : buffers) {
+		std::string buf_out, buf_err;
+		uint64_t dropped = 0;
+		{
+			std::lock_guard<std::mutex> lock(buf->mtx);
+			buf_out.swap(buf->out);
+			buf_err.swap(buf->err);
+			std::swap(dropped, buf->dropped);
+			retired = retired || buf->retired;
+		}
+		out += buf_out;
+		err += buf_err;
+		if (dropped > 0) {
+			err += levelTag(LogLevel::WARNING);
+			err += std::to_string(dropped) + " messages dropped, log buffer is full\n";
+		}
+	}
+	if (retired) {
+		///@note nothing is written to a retired buffer any more, so it is empty from now on.
+		std::lock_guard<std::mutex> lock(m_mtx);
+		m_buffers.erase(std::remove_if(m_buffers.begin(), m_buffers.end(), [](const SharedRef<LogBuffer> &b) {
+			std::lock_guard<std::mutex> buf_lock(b->mtx);
+			return b->retired && b->out.empty() && b->err.empty();
+		}), m_buffers.end());
+	}
+	if (!out.empty()) {
+		std::fwrite(out.data(), 1, out.size(), stdout);
+		std::fflush(stdout);
+	}
+	if (!err.empty()) {
+		std::fwrite(err.data(), 1, err.size(), stderr);
+		std::fflush(stderr);
+	}
+}
+
+LogStream::LogStream(LogLevel level)
+	: m_level(level), m_os([]() -> std::ostringstream & {
+	static thread_local std::ostringstream os;
+	return os;
+}())
+{
+	m_on = AsyncLogger::Instance().Enabled(level);
+	if (m_on) {
+		m_os.str(std::string());
+		m_os.clear();
+	}
+}
+
+LogStream::~LogStream()
+{
+	if (m_on)AsyncLogger::Instance().Write(m_level, m_os.str());
+}
+
+}
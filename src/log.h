@@ -0,0 +1,185 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "util.h"
+
+namespace helmet
+{
+/**
+ * @brief severity of log messages, the same order as nvinfer1::ILogger::Severity reversed.
+ */
+enum class LogLevel
+{
+	VERBOSE = 0,
+	INFO = 1,
+	WARNING = 2,
+	ERROR = 3,
+	FATAL = 4,
+	OFF = 5 ///< only used as threshold, nothing is logged.
+};
+
+/**
+ * @brief parse a level name, i.e. "VERBOSE", "INFO", "WARNING", "ERROR", "FATAL" or "OFF".
+ * @param name level name, case insensitive.
+ * @param level parsed level, unchanged if the name is unknown.
+ * @return true if parsed.
+ */
+extern bool parseLogLevel(const std::string &name, LogLevel &level);
+
+/**
+ * @brief per thread message buffer, drained by the sink thread.
+ * @details only the owner thread and the sink lock it, so writers never contend with each other.
+ */
+struct LogBuffer
+{
+	std::mutex mtx;
+	std::string out;///< pending messages for stdout.
+	std::string err;///< pending messages for stderr, i.e. ERROR and above.
+	uint64_t dropped = 0;///< messages dropped since last drain because the buffer is full.
+	bool retired = false;///< the owner thread exited, the buffer is removed once drained.
+	///@note rate limiting state, only touched by the owner thread.
+	double tokens = 0.0;
+	std::chrono::steady_clock::time_point refill;
+	uint64_t suppressed = 0;
+};
+
+/**
+ * @brief process wide asynchronous levelled logger.
+ * @details messages are formatted on the calling thread and appended to its own buffer, a background sink <!--
+ * --> thread writes all buffers out in batches, so no thread waits on the stdout lock. Messages below <!--
+ * --> ERROR are rate limited per thread, the number of suppressed messages is reported afterwards.
+ * @note messages are still written synchronously after the logger is destroyed at exit.
+ * @example:
+ * @code
+ * 	AsyncLogger::Instance().SetLevel(LogLevel::WARNING);
+ * 	logStream(LogLevel::INFO) << "Model size: " << size;
+ * @endcode
+ */
+class AsyncLogger final
+{
+public:
+	static AsyncLogger &Instance();
+
+	/**
+	 * @brief write out pending messages and stop the sink thread.
+	 */
+	~AsyncLogger();
+
+	/**
+	 * @brief set the minimal level being logged.
+	 */
+	void SetLevel(LogLevel level);
+
+	/**
+	 * @brief check whether a level is logged, this is cheap enough for hot path.
+	 */
+	bool Enabled(LogLevel level) const
+	{
+		return (int)level >= m_level.load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * @brief set the maximum number of messages below ERROR per second per thread.
+	 * @param per_second rate limit, 0 for unlimited.
+	 */
+	void SetRateLimit(unsigned int per_second);
+
+	/**
+	 * @brief log one message.
+	 * @param level message severity.
+	 * @param msg message without trailing new line.
+	 */
+	void Write(LogLevel level, const std::string &msg);
+
+	/**
+	 * @brief write out all pending messages on the calling thread.
+	 */
+	void Flush();
+
+private:
+	AsyncLogger();
+
+	/**
+	 * @brief get buffer of current thread, created on first use and retired when the thread exits.
+	 */
+	LogBuffer &Local();
+
+	/**
+	 * @brief check the rate limit of current thread.
+	 * @return true if the message can be logged.
+	 */
+	bool Acquire(LogBuffer &buf);
+
+	/**
+	 * @brief sink thread main loop.
+	 */
+	void Loop();
+
+	/**
+	 * @brief swap out and write all buffers.
+	 */
+	void Drain();
+
+private:
+	static constexpr size_t MAX_PENDING = 1 << 20;///< bytes kept per thread before messages are dropped.
+
+	std::atomic_int m_level = (int)LogLevel::INFO;
+	std::atomic_uint m_rate = 0;
+	std::atomic_bool m_running = false;
+	std::mutex m_mtx;///< guards the buffer list and wakes the sink.
+	std::mutex m_drain_mtx;///< serializes draining, keeps the output order.
+	std::condition_variable m_wake;
+	bool m_stop = false;
+	std::vector<SharedRef<LogBuffer>> m_buffers;///< buffers outlive their threads until drained.
+	std::thread m_thread;
+};
+
+/**
+ * @brief stream style front end of AsyncLogger, the message is submitted when it goes out of scope.
+ * @note std::endl is accepted and ignored, so existing std::cout statements can be converted as they are.
+ */
+class LogStream final
+{
+public:
+	explicit LogStream(LogLevel level);
+	~LogStream();
+
+	LogStream(const LogStream &) = delete;
+	LogStream &operator=(const LogStream &) = delete;
+
+	template<typename T>
+	LogStream &operator<<(const T &value)
+	{
+		if (m_on)m_os << value;
+		return *this;
+	}
+
+	LogStream &operator<<(std::ostream &(*)(std::ostream &))
+	{
+		return *this;
+	}
+
+private:
+	LogLevel m_level;
+	bool m_on = false;
+	std::ostringstream &m_os;///< thread local, reused across messages.
+};
+
+/**
+ * @brief begin a message.
+ * @param level message severity.
+ * @return stream collecting the message.
+ */
+inline LogStream logStream(LogLevel level)
+{
+	return LogStream(level);
+}
+
+}
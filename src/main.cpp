@@ -4,6 +4,12 @@
 #include "trt_deploy.h"
 #include "trt_deployresult.h"
 #include "model.h"
+#include "video_reader.h"
+#include "video_writer.h"
+#include "clip_recorder.h"
+#include "live_source.h"
+#include "resource_cache.h"
+#include "placement.h"
 
 using namespace helmet;
 
@@ -15,6 +21,9 @@ using namespace helmet;
  */
 
 int TEST_THREADS = 1;
+bool HEADLESS = false;///< no output video, frames not analysed are only grabbed.
+bool CLIPS = false;///< only clips around alarms are stored instead of the whole annotated video.
+bool LIVE = false;///< frames come from the SOURCE of the YAML file, latest frame wins, nothing is written.
 
 void process_video(int thread_id, const std::string &file)
 {
@@ -23,30 +32,60 @@ void process_video(int thread_id, const std::string &file)
 		std::cerr << "The video file is not exist..." << std::endl;
 		return;
 	}
+	Tracer::Instance().SetThreadName("stream-" + std::to_string(thread_id));
 //    cv::Mat::setDefaultAllocator(cv::cuda::HostMem::getAllocator (cv::cuda::HostMem::AllocType::PAGE_LOCKED));
 
 	auto in_path = std::filesystem::path(file);
-	cv::VideoCapture cap(in_path);
-	cv::VideoWriter vw;
+	PrefetchVideoReader cap(4);
+	cap.Open(in_path);
+	AsyncVideoWriter vw(8, AsyncVideoWriter::DropPolicy::DROP_OLDEST);
+	ClipRecorder::Options clip_options;
+	clip_options.dir = (in_path.parent_path() / "clips").string();
+	ClipRecorder recorder(clip_options);
 
 	std::filesystem::path
 		output_path = in_path.parent_path() / (in_path.stem().string() + std::to_string(thread_id) + ".mp4");
-	vw.open(output_path,
-			cv::VideoWriter::fourcc('m', 'p', '4', 'v'),
-			cap.get(cv::CAP_PROP_FPS),
-			cv::Size(cap.get(cv::CAP_PROP_FRAME_WIDTH),
-					 cap.get(cv::CAP_PROP_FRAME_HEIGHT)));
+	const double fps = cap.Get(cv::CAP_PROP_FPS) > 0 ? cap.Get(cv::CAP_PROP_FPS) : 25.0;
+	if (!HEADLESS && CLIPS) {
+		recorder.Open(in_path.stem().string() + std::to_string(thread_id), fps);
+	}
+	else if (!HEADLESS) {
+		vw.Open(output_path,
+				cv::VideoWriter::fourcc('m', 'p', '4', 'v'),
+				cap.Get(cv::CAP_PROP_FPS),
+				cv::Size(cap.Get(cv::CAP_PROP_FRAME_WIDTH),
+						 cap.Get(cv::CAP_PROP_FRAME_HEIGHT)));
+	}
 
-	cv::Mat img;
+	PrefetchVideoReader::Frame frame;
 	bool init = false;
 	cvModel *models = nullptr;
 	std::chrono::high_resolution_clock::time_point curr_time;
-	while (cap.isOpened()) {
-		cap.read(img);
+	while (cap.Read(frame)) {
+		if (!frame.decoded) {
+			if (init)Skip_Algorithm(models);
+			continue;
+		}
+		auto &img = frame.img;
 		if (!init) {
 			models = Allocate_Algorithm(img, IA_TYPE_PEOPLEHELME_DETECTION, 0);
 			SetPara_Algorithm(models, IA_TYPE_PEOPLEHELME_DETECTION);
 			UpdateParams_Algorithm(models);
+			///@note frames are passed through or wait, see PASS_THROUGH, while the engine loads in background.
+			Prepare_Algorithm(models, -1);
+			BindThread_Algorithm(models);
+			///@note frames already in the lookahead ring are decoded anyway, cadence stays aligned by frame index.
+			if (HEADLESS)cap.SetDecodeInterval(models->Frameinterval);
+			///@note the stream thread is pinned by BindThread_Algorithm, its decode and encode threads follow it.
+			int placement[3];
+			if (GetPlacement_Algorithm(models, placement) == 0) {
+				cap.SetAffinity({placement[2]});
+				vw.SetAffinity(Placement::Instance().Topology().NodeCpus(placement[0]));
+				recorder.SetAffinity(Placement::Instance().Topology().NodeCpus(placement[0]));
+			}
+			auto stats = LatencyRegistry::Instance().Find(models);
+			cap.SetLatencyStats(stats);
+			vw.SetLatencyStats(stats);
 			init = true;
 		}
 		if (img.cols == 0 || img.rows == 0)break;
@@ -58,14 +97,68 @@ void process_video(int thread_id, const std::string &file)
 		auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(dur).count();
 		std::cout << "Thread: " << std::this_thread::get_id() << " Cpu: " << sched_getcpu() << " taken: " << ms << "ms"
 				  << std::endl;
-		vw.write(img.clone());
+		if (CLIPS)recorder.Write(img, (int64_t)((double)frame.index * 1e6 / fps), models->alarm != 0);
+		else vw.Write(img);
+	}
+	cap.Release();
+	vw.Release();
+	recorder.Release();
+	auto stats = vw.GetStats();
+	std::cout << "Thread: " << thread_id << " encoder queued: " << stats.queued << " written: " << stats.written
+			  << " dropped: " << stats.dropped << std::endl;
+	if (CLIPS) {
+		auto clip_stats = recorder.GetStats();
+		std::cout << "Thread: " << thread_id << " clips: " << clip_stats.clips << " frames: " << clip_stats.clip_frames
+				  << " of " << clip_stats.queued << " bytes: " << clip_stats.bytes_written << " dropped: "
+				  << clip_stats.dropped << std::endl;
 	}
-	cap.release();
-	vw.release();
-	Destroy_Algorithm(models);
+	auto dec_stats = cap.GetStats();
+	std::cout << "Thread: " << thread_id << " decoder grabbed: " << dec_stats.grabbed << " retrieved: "
+			  << dec_stats.retrieved << " skipped: " << dec_stats.skipped << std::endl;
+	if (models)Destroy_Algorithm(models);
 
 }
 
+/**
+ * @brief analyse the SOURCE of the YAML file, e.g. a camera, always processing the newest frame.
+ */
+void process_live(int thread_id)
+{
+	Tracer::Instance().SetThreadName("stream-" + std::to_string(thread_id));
+	std::string file = checkFileExist("./helmet_detection.yaml") ? "./helmet_detection.yaml" : "../config/helmet_detection.yaml";
+	auto config = ResourceCache::Instance().AcquireConfig(file);
+	LiveSource source;
+	if (!source.Open(sourceOptions(*config))) {
+		std::cerr << "Cannot open source " << config->SOURCE << std::endl;
+		return;
+	}
+	LiveSource::Frame frame;
+	cvModel *models = nullptr;
+	int64_t max_age_us = 0;
+	///@note a live source may be down for a while, reconnecting is done by the capture thread meanwhile.
+	///@note no timeout, analysis only stops once the source ended or gave up reconnecting.
+	while (source.Read(frame, -1)) {
+		if (!models) {
+			models = Allocate_Algorithm(frame.img, IA_TYPE_PEOPLEHELME_DETECTION, 0);
+			SetPara_Algorithm(models, IA_TYPE_PEOPLEHELME_DETECTION);
+			UpdateParams_Algorithm(models);
+			Prepare_Algorithm(models, -1);
+			BindThread_Algorithm(models);
+			int placement[3];
+			if (GetPlacement_Algorithm(models, placement) == 0)source.SetAffinity({placement[2]});
+			source.SetLatencyStats(LatencyRegistry::Instance().Find(models));
+		}
+		Process_Algorithm(models, frame.img);
+		max_age_us = std::max(max_age_us, steadyMicros() - frame.capture_us);
+	}
+	source.Release();
+	auto stats = source.GetStats();
+	std::cout << "Thread: " << thread_id << " source captured: " << stats.captured << " delivered: " << stats.delivered
+			  << " skipped: " << stats.skipped << " reconnects: " << stats.reconnects << " failures: " << stats.failures
+			  << " max latency: " << max_age_us / 1000 << "ms" << std::endl;
+	if (models)Destroy_Algorithm(models);
+}
+
 int main(int argc, char **argv)
 {
 	bool enable_cpu_affinity = false;
@@ -76,23 +169,28 @@ int main(int argc, char **argv)
 		int temp = std::atoi(argv[2]);
 		if (temp)enable_cpu_affinity = true;
 	}
+	if (argc > 3) {
+		HEADLESS = std::atoi(argv[3]) != 0;
+	}
+	if (argc > 4) {
+		CLIPS = std::atoi(argv[4]) != 0;
+	}
+	if (argc > 5) {
+		LIVE = std::atoi(argv[5]) != 0;
+	}
+	if (enable_cpu_affinity) {
+		///@note overrides PLACEMENT of the YAML file, threads are pinned by topology instead of CPU i for thread i.
+		PlacementOptions options;
+		options.policy = PlacementPolicy::COMPACT;
+		Placement::Configure(options);
+	}
 	std::vector<std::thread> threads(TEST_THREADS);
 	std::vector<std::string> files(TEST_THREADS);
 	std::string base = "/home/wgf/Downloads/datasets/Anquanmao/helmet-live/";
 	for (int i = 0; i < TEST_THREADS; ++i) {
 		files[i] = base + std::to_string(i) + ".mp4";
 //        files[i] = "/home/wgf/Downloads/datasets/Anquanmao/helmet-live/multithread.mp4";
-		threads[i] = std::thread(process_video, i, files[i]);
-		if (enable_cpu_affinity) {
-			cpu_set_t cpuset;
-			CPU_ZERO(&cpuset);
-			CPU_SET(i, &cpuset);
-			int rc = pthread_setaffinity_np(threads[i].native_handle(),
-											sizeof(cpu_set_t), &cpuset);
-			if (rc != 0) {
-				std::cerr << "Error calling pthread_setaffinity_np: " << rc << "\n";
-			}
-		}
+		threads[i] = LIVE ? std::thread(process_live, i) : std::thread(process_video, i, files[i]);
 	}
 	for (int i = 0; i < TEST_THREADS; ++i) {
 		threads[i].join();
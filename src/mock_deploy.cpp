@@ -0,0 +1,205 @@
+#include <iostream>
+#include <thread>
+#include "mock_deploy.h"
+#include "latency_stats.h"
+#include "log.h"
+#include "work_pool.h"
+
+namespace helmet
+{
+
+MockDeploy::MockDeploy(SharedRef<Config> &config, int gpuID)
+	: TrtDeploy(config, gpuID)
+{
+	assert(m_config->N_STD[0] > 0.0f && m_config->N_STD[1] > 0.0f && m_config->N_STD[2] > 0.0f);
+	// normalization constant, should be 1.0/255.0;
+	const auto normalizer = 0.00392157f;
+	for (int c = 0; c < 3; ++c) {
+		m_mul[c] = normalizer / m_config->N_STD[c];
+		m_add[c] = -m_config->N_MEAN[c] / m_config->N_STD[c];
+	}
+}
+
+void MockDeploy::Init(const std::string &model_file)
+{
+	if (!m_postprocessor) {
+		m_postprocessor = createSharedRef<Postprocessor>(m_config);
+	}
+	m_blob.resize((size_t)3 * m_input_size.area());
+	///@note there is no engine metadata, the type is taken from config and "auto" means float32.
+	m_input_type = TensorType::FLOAT32;
+	if (m_config->INPUT_DTYPE != "auto" && !parseTensorType(m_config->INPUT_DTYPE, m_input_type)) {
+		logStream(LogLevel::WARNING) << "Unknown input dtype: " << m_config->INPUT_DTYPE << ", using float32." << std::endl;
+	}
+	for (const auto &name : m_config->INPUT_NAME) {
+		logStream(LogLevel::INFO) << "Mock backend input: " << name << " dtype: " << tensorTypeName(m_input_type) << std::endl;
+	}
+
+	const auto out_num = m_config->OUTPUT_NAMES.size();
+	m_outputs.resize(out_num);
+	for (size_t i = 0; i < out_num; ++i) {
+		int out_size = 1;
+		if (i < m_config->OUTPUT_SHAPES.size()) {
+			for (auto d : m_config->OUTPUT_SHAPES[i]) {
+				out_size *= d > 0 ? d : -d;
+			}
+		}
+		else {
+			logStream(LogLevel::WARNING) << "No shape of output: " << m_config->OUTPUT_NAMES[i] << ", using 1." << std::endl;
+		}
+		m_outputs[i].resize(out_size, 0.0f);
+		logStream(LogLevel::INFO) << "Mock backend output: " << m_config->OUTPUT_NAMES[i] << " size: " << out_size << std::endl;
+	}
+	if (m_config->MOCK_DETS.size() % 6 != 0) {
+		logStream(LogLevel::WARNING) << "MOCK_DETS should be groups of 6 floats, the tail is ignored." << std::endl;
+	}
+	if (m_config->MOCK_PATTERN.empty()) {
+		m_config->MOCK_PATTERN = "1";
+	}
+	///@note there is no engine batch dimension, the config decides how many images share one fake latency.
+	m_max_batch = (int)std::max(1u, m_config->BATCH_SIZE);
+	m_model_load_status = ModelLoadStatus::LOADED_SUCCESS;
+}
+
+void MockDeploy::Infer(const cv::Mat &img, SharedRef<TrtResults> &result)
+{
+	if (!INIT_FLAG) {
+		Init(m_config->MODEL_NAME);
+		INIT_FLAG = true;
+	}
+	{
+		StageTimer timer(Stage::PREPROCESS);
+		cv::resize(img, m_resized, m_input_size, 0, 0, (int)m_config->INTERP);
+		Normalize();
+	}
+	StageTimer timer(Stage::INFER);
+	Emit(result);
+}
+
+void MockDeploy::Infer(const cv::Mat &img, PixelFormat format, const cv::Mat &mask, SharedRef<TrtResults> &result)
+{
+	if (format == PixelFormat::BGR) {
+		Infer(img, result);
+		return;
+	}
+	if (!INIT_FLAG) {
+		Init(m_config->MODEL_NAME);
+		INIT_FLAG = true;
+	}
+	{
+		StageTimer timer(Stage::PREPROCESS);
+		m_resized.create(cv::Size(m_config->TRAIN_SIZE[1], m_config->TRAIN_SIZE[0]), CV_8UC3);
+		m_yuv_resizer.Run(img, format, m_resized, mask, (int)m_config->INTERP);
+		Normalize();
+	}
+	StageTimer timer(Stage::INFER);
+	Emit(result);
+}
+
+void MockDeploy::InferBatch(const std::vector<cv::Mat> &imgs, std::vector<SharedRef<TrtResults>> &results)
+{
+	if (!INIT_FLAG) {
+		Init(m_config->MODEL_NAME);
+		INIT_FLAG = true;
+	}
+	for (size_t i = 0; i < imgs.size(); ++i) {
+		{
+			StageTimer timer(Stage::PREPROCESS);
+			cv::resize(imgs[i], m_resized, m_input_size, 0, 0, (int)m_config->INTERP);
+			Normalize();
+		}
+		StageTimer timer(Stage::INFER);
+		Emit(results[i], i % (size_t)m_max_batch == 0);
+	}
+}
+
+uint64_t MockDeploy::Calls() const
+{
+	return m_calls;
+}
+
+void MockDeploy::Normalize()
+{
+	const size_t plane = m_resized.total();
+	const int cols = m_resized.cols;
+	if (m_input_type == TensorType::UINT8) {
+		m_blob_u8.resize(plane * 3);
+		unsigned char *dst0 = m_blob_u8.data();
+		unsigned char *dst1 = dst0 + plane;
+		unsigned char *dst2 = dst1 + plane;
+		WorkPool::Instance().ParallelFor(0, m_resized.rows, 16, [&](int begin, int end) {
+			for (int y = begin; y < end; ++y) {
+				const unsigned char *src = m_resized.ptr<unsigned char>(y);
+				size_t k = (size_t)y * cols;
+				for (int x = 0; x < cols; ++x, ++k) {
+					dst0[k] = src[3 * x];
+					dst1[k] = src[3 * x + 1];
+					dst2[k] = src[3 * x + 2];
+				}
+			}
+		});
+		return;
+	}
+	m_blob.resize(plane * 3);
+	if (m_input_type == TensorType::FLOAT16)m_blob_half.resize(plane * 3);
+	float *dst0 = m_blob.data();
+	float *dst1 = dst0 + plane;
+	float *dst2 = dst1 + plane;
+	WorkPool::Instance().ParallelFor(0, m_resized.rows, 16, [&](int begin, int end) {
+		for (int y = begin; y < end; ++y) {
+			const unsigned char *src = m_resized.ptr<unsigned char>(y);
+			const size_t row = (size_t)y * cols;
+			size_t k = row;
+			for (int x = 0; x < cols; ++x, ++k) {
+				dst0[k] = src[3 * x] * m_mul[0] + m_add[0];
+				dst1[k] = src[3 * x + 1] * m_mul[1] + m_add[1];
+				dst2[k] = src[3 * x + 2] * m_mul[2] + m_add[2];
+			}
+			if (m_input_type == TensorType::FLOAT16) {
+				///@note converted row by row while the floats are still in cache.
+				for (int c = 0; c < 3; ++c) {
+					floatToHalf(m_blob.data() + c * plane + row, m_blob_half.data() + c * plane + row, cols);
+				}
+			}
+		}
+	});
+}
+
+void MockDeploy::Emit(SharedRef<TrtResults> &res, bool sleep)
+{
+	res->Clear();
+	if (sleep && m_config->MOCK_LATENCY_MS > 0.0f) {
+		std::this_thread::sleep_for(std::chrono::microseconds((int64_t)(m_config->MOCK_LATENCY_MS * 1000.0f)));
+	}
+	const auto &pattern = m_config->MOCK_PATTERN;
+	const bool emit = pattern[m_calls % pattern.size()] != '0';
+	m_calls++;
+
+	int num = 0;
+	if (!m_outputs.empty()) {
+		auto &dets = m_outputs[0];
+		const size_t slots = dets.size() / 6;
+		const size_t scripted = emit ? m_config->MOCK_DETS.size() / 6 : 0;
+		for (size_t j = 0; j < slots; ++j) {
+			float *d = &dets[j * 6];
+			if (j < scripted) {
+				std::copy_n(&m_config->MOCK_DETS[j * 6], 6, d);
+				num++;
+			}
+			else {
+				///@note empty slots get an invalid class and zero score, like padded NMS outputs.
+				d[0] = -1.0f;
+				std::fill_n(d + 1, 5, 0.0f);
+			}
+		}
+	}
+	if (m_outputs.size() > 1 && !m_outputs[1].empty()) {
+		m_outputs[1][0] = (float)num;
+	}
+	for (size_t i = 0; i < m_outputs.size(); ++i) {
+		res->Set(std::make_pair(m_config->OUTPUT_NAMES[i], m_outputs[i]));
+	}
+	res->Stamp(steadyMicros(), m_input_size);
+}
+
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "trt_deploy.h"
+#include "yuv_convert.h"
+
+namespace helmet
+{
+/**
+ * @brief CPU only backend emitting scripted detections, for testing and benchmarking without a GPU.
+ * @details the preprocessing is done on CPU, i.e. resize, normalization and permute into a [C,H,W] float <!--
+ * --> tensor, then the inference is replaced by a fixed sleep and deterministic outputs:
+ * - the output tensors are named by OUTPUT_NAMES and sized by OUTPUT_SHAPES.
+ * - MOCK_DETS gives the detections as [class, score, x_min, y_min, x_max, y_max] in network input coordinates.
+ * - MOCK_PATTERN is cycled per inference, '1' emits MOCK_DETS and '0' emits nothing.
+ * - MOCK_LATENCY_MS is the fake compute latency.
+ * - INPUT_DTYPE selects the input tensor type, "float16" is converted with F16C, "uint8" keeps raw pixels.
+ * @note selected by BACKEND: "mock" in the config file, postprocessing is the same as TrtDeploy.
+ * @example:
+ * @code
+ * 	auto config = createSharedRef<Config>(0, nullptr, file);
+ * 	config->MOCK_DETS = {0, 0.9f, 100, 100, 200, 300};
+ * 	config->MOCK_PATTERN = "110";
+ * 	SharedRef<TrtDeploy> deploy = createSharedRef<MockDeploy>(config);
+ * 	deploy->Infer(img, res);
+ * @endcode
+ */
+class MockDeploy final: public TrtDeploy
+{
+public:
+	explicit MockDeploy(SharedRef<Config> &config, int gpuID = 0);
+
+	~MockDeploy() override = default;
+
+public:
+	void Infer(const cv::Mat &img, SharedRef<TrtResults> &result) override;
+
+	void Infer(const cv::Mat &img, PixelFormat format, const cv::Mat &mask, SharedRef<TrtResults> &result) override;
+
+	/**
+	 * @brief preprocess every frame on CPU, the fake latency is paid once per chunk of BATCH_SIZE frames.
+	 */
+	void InferBatch(const std::vector<cv::Mat> &imgs, std::vector<SharedRef<TrtResults>> &results) override;
+
+	/**
+	 * @brief get number of inferences done.
+	 */
+	uint64_t Calls() const;
+
+protected:
+	/**
+	 * @brief allocate host tensors from the config, no model file is read.
+	 * @param model_file not used.
+	 */
+	void Init(const std::string &model_file) override;
+
+private:
+	/**
+	 * @brief normalize m_resized and permute it into the input tensor of m_input_type.
+	 */
+	void Normalize();
+
+	/**
+	 * @brief sleep for the fake latency and emit the scripted outputs.
+	 * @param res output results.
+	 * @param sleep false for the images of a batch after the first one.
+	 */
+	void Emit(SharedRef<TrtResults> &res, bool sleep = true);
+
+private:
+	cv::Mat m_resized;///< resized BGR image.
+	std::vector<float> m_blob;///< input tensor in [C,H,W].
+	std::vector<uint16_t> m_blob_half;///< FLOAT16 input tensor in [C,H,W].
+	std::vector<unsigned char> m_blob_u8;///< UINT8 input tensor in [C,H,W], not normalized.
+	std::vector<std::vector<float>> m_outputs;///< output tensors in the order of OUTPUT_NAMES.
+	YUVResizer m_yuv_resizer;
+	float m_mul[3] = {1.0f, 1.0f, 1.0f};
+	float m_add[3] = {0.0f, 0.0f, 0.0f};
+	uint64_t m_calls = 0;
+};
+
+}
@@ -1,8 +1,21 @@
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <mutex>
 #include <thread>
 #include "model.h"
 #include "config.h"
 #include "trt_deploy.h"
+#include "mock_deploy.h"
 #include "trt_deployresult.h"
+#include "latency_stats.h"
+#include "resource_cache.h"
+#include "config_snapshot.h"
+#include "work_pool.h"
+#include "placement.h"
+#include "async_runner.h"
+#include "evidence.h"
+#include "log.h"
 
 namespace helmet
 {
@@ -13,17 +26,102 @@ public:
 	explicit InferModel(int gpuID, SharedRef<Config> &config)
 	{
 		m_config = config;
-		mDeploy = createSharedRef<TrtDeploy>(config, gpuID);
+		if (config->BACKEND == "mock") {
+			mDeploy = createSharedRef<MockDeploy>(config, gpuID);
+		}
+		else {
+			mDeploy = createSharedRef<TrtDeploy>(config, gpuID);
+		}
 		mResult = createSharedRef<TrtResults>(config);
 		m_process = config->SAMPLE_DATA;
+		m_gpu_id = gpuID;
+	}
+
+	~InferModel()
+	{
+		///@note the async worker still processes frames with this instance.
+		m_async.reset();
+		///@note the backend is still in use by the preparing thread.
+		if (m_prepare.valid())m_prepare.wait();
+		Placement::Instance().Release(m_placement);
+	}
+
+	/**
+	 * @brief get the ROI mask of a frame size, rescaled once per resolution and ROI version.
+	 * @details the ROI polygons are given at the allocated frame size, a camera may switch resolution later.
+	 */
+	const cv::Mat &ROIFor(const RuntimeParams &params, const cv::Size &frame)
+	{
+		if (params.roi_img.size() == frame)return params.roi_img;
+		if (m_roi_version != params.version || m_roi_scaled.size() != frame) {
+			cv::resize(params.roi_img, m_roi_scaled, frame, 0, 0, cv::INTER_NEAREST);
+			m_roi_version = params.version;
+		}
+		return m_roi_scaled;
+	}
+
+	/**
+	 * @brief check whether the current frame can be inferred.
+	 * @details never waits unless PASS_THROUGH is off, without Prepare_Algorithm the backend is initialized lazily as before.
+	 * @return false if frames should be passed through.
+	 */
+	bool Ready()
+	{
+		int state = m_ready.load(std::memory_order_acquire);
+		if (state == READY_PREPARING && !m_config->PASS_THROUGH) {
+			m_prepare.wait();
+			state = m_ready.load(std::memory_order_acquire);
+		}
+		return state == READY_LAZY || state == READY_OK;
+	}
+
+	/**
+	 * @brief pass a frame through while the backend is not ready.
+	 * @details the frame index and sampling cadence still advance, so the sampled frames stay in phase <!--
+	 * --> with a caller decoding only every Frameinterval-th frame.
+	 */
+	void PassThrough(cvModel *pModel)
+	{
+		pModel->alarm = 0;
+		m_frame++;
+		RcuCell<RuntimeParams>::ReadGuard params(*m_params);
+		NextSample(params->SAMPLE_DATA);
+	}
+
+	/**
+	 * @brief advance the sampling cadence.
+	 * @param interval current sampling interval.
+	 * @return true if the current frame should be inferred.
+	 */
+	bool NextSample(int interval)
+	{
+		bool infer = m_process == interval;
+		m_process--;
+		if (m_process <= 0) {
+			m_process = interval;
+		}
+		return infer;
 	}
 
 public:
 	SharedRef<TrtDeploy> mDeploy;
 	SharedRef<TrtResults> mResult;
-	SharedRef<Config> m_config;
-	cv::Mat m_roi_img;
+	SharedRef<Config> m_config;///< static config, never modified after allocation.
+	UniqueRef<RcuCell<RuntimeParams>> m_params = nullptr;///< runtime parameters, read once per frame.
+	uint64_t m_params_version = 0;///< version of thresholds last handed to postprocessing.
 	int m_process = 2;
+	SharedRef<StreamLatency> m_latency = nullptr;///< per stage latency, histograms are recorded only if TIMING is on.
+	int64_t m_frame = 0;///< index of next frame, used to sample and label trace events.
+	int m_gpu_id = 0;
+	std::atomic_int m_ready = READY_LAZY;///< EReadyState, the backend belongs to the preparing thread until READY_OK.
+	std::future<void> m_prepare;
+	WorkPoolStream m_pool_stream;///< shares the CPU preprocessing pool with the other streams.
+	StreamPlacement m_placement;///< CPUs and node of the stream, not placed if PLACEMENT is none.
+	UniqueRef<AsyncRunner> m_async = nullptr;///< worker of Submit_Algorithm, nullptr without a callback.
+	std::vector<Box> m_boxes;///< detections handed to the async callback.
+	std::vector<cv_Detection> m_evidence;///< target detections handed to the evidence writer.
+	cv::Mat m_roi_scaled;///< ROI mask of a frame size other than the allocated one.
+	uint64_t m_roi_version = 0;///< version of the ROI m_roi_scaled is built from.
 };
 
 void *GenModel(int gpuID, SharedRef<Config> config)
@@ -32,7 +130,7 @@ void *GenModel(int gpuID, SharedRef<Config> config)
 	return reinterpret_cast<void *>(model);
 }
 
-cv::Mat genROI(const cv::Size s, const std::vector<int> &points, cv_Point *coords)
+cv::Mat genROI(const cv::Size s, const std::vector<int> &points, const std::vector<cv::Point> &coords)
 {
 	if (points.empty()){
 		return {s, CV_8UC3, cv::Scalar::all(255)};
@@ -45,7 +143,7 @@ cv::Mat genROI(const cv::Size s, const std::vector<int> &points, cv_Point *coord
 	for (auto &each : points) {
 		std::vector<cv::Point> pts;
 		for (int j = sums; j < each + sums; ++j) {
-			pts.emplace_back(coords[j].x, coords[j].y);
+			pts.push_back(coords[j]);
 		}
 		sums += each;
 		contour.push_back(pts);
@@ -58,10 +156,69 @@ cv::Mat genROI(const cv::Size s, const std::vector<int> &points, cv_Point *coord
 	return roi_img;
 }
 
+/**
+ * @brief rebuild the ROI masks of a snapshot from its polygons.
+ * @param params snapshot being prepared.
+ * @param frame frame size.
+ * @param config static config.
+ */
+void buildROI(RuntimeParams &params, const cv::Size &frame, const Config &config)
+{
+	params.roi_img = genROI(frame, params.pointNum, params.points);
+	params.roi_small.release();
+	if (!params.pointNum.empty()) {
+		cv::Mat resized;
+		cv::resize(params.roi_img, resized, cv::Size(config.TRAIN_SIZE[1], config.TRAIN_SIZE[0]),
+				   0, 0, cv::INTER_NEAREST);
+		cv::cvtColor(resized, params.roi_small, cv::COLOR_BGR2GRAY);
+	}
+}
+
+/**
+ * @brief hand the thresholds of a snapshot to postprocessing if they changed.
+ */
+void applyThresholds(InferModel *model, const RuntimeParams &params)
+{
+	if (params.version == model->m_params_version)return;
+	model->mDeploy->SetThresholds(params.SCORE_THRESHOLD, params.ALARM_COUNT);
+	model->mDeploy->SetInputSize(params.TARGET_H, params.TARGET_W);
+	model->m_params_version = params.version;
+}
+
+/**
+ * @brief assign CPUs to a new stream, no thread is pinned here.
+ * @details the thread processing the stream is pinned by BindThread_Algorithm, the threads of the library <!--
+ * --> working for the stream by bindStreamThread().
+ */
+static StreamPlacement placeStream(const Config &config, int gpuID)
+{
+	PlacementOptions options;
+	if (!parsePlacementPolicy(config.PLACEMENT, options.policy)) {
+		logStream(LogLevel::WARNING) << "Unknown placement " << config.PLACEMENT << ", threads are not pinned." << std::endl;
+	}
+	options.smt = config.PLACEMENT_SMT;
+	options.gpu_local = config.PLACEMENT_GPU_LOCAL;
+	options.bind_memory = config.PLACEMENT_BIND_MEMORY;
+	options.reserved = config.PLACEMENT_RESERVED_CPUS;
+	///@note the first caller decides, the application may have configured it before.
+	Placement::Configure(options);
+	auto &placement = Placement::Instance();
+	static std::once_flag pool_pinned;
+	std::call_once(pool_pinned, [&placement] { WorkPool::Instance().SetAffinity(placement.PoolCpus()); });
+	if (!placement.Enabled())return StreamPlacement();
+	int gpu_node = -1;
+	char bus_id[32] = {0};
+	if (config.BACKEND != "mock" && cudaDeviceGetPCIBusId(bus_id, sizeof(bus_id), gpuID) == cudaSuccess) {
+		gpu_node = pciNumaNode(bus_id);
+	}
+	auto slot = placement.Acquire(gpu_node);
+	logStream(LogLevel::INFO) << "Stream placed on node " << slot.node << ", cpu " << slot.worker_cpu
+							  << ", decode cpu " << slot.decode_cpu << std::endl;
+	return slot;
+}
+
 cvModel *Allocate_Algorithm(cv::Mat &input_frame, int algID, int gpuID)
 {
-	cv::cuda::setDevice(gpuID);
-	cudaSetDevice(gpuID);
 	std::string file;
 	if (checkFileExist("./helmet_detection.yaml"))
 		file = "./helmet_detection.yaml";
@@ -69,18 +226,52 @@ cvModel *Allocate_Algorithm(cv::Mat &input_frame, int algID, int gpuID)
 		file = "../config/helmet_detection.yaml";
 	}
 	else {
-		std::cout << "Cannot find YAML file!" << std::endl;
+		logStream(LogLevel::ERROR) << "Cannot find YAML file!" << std::endl;
+	}
+	///@note the file is parsed once per process, each instance gets its own copy.
+	auto config = ResourceCache::Instance().AcquireConfig(file);
+	///@note the mock backend never touches the GPU, so it runs on machines without one.
+	if (config->BACKEND != "mock") {
+		cv::cuda::setDevice(gpuID);
+		cudaSetDevice(gpuID);
 	}
-	auto config = createSharedRef<Config>(0, nullptr, file);
 	config->INPUT_SHAPE[config->INPUT_SHAPE.size() - 1] = input_frame.cols;
 	config->INPUT_SHAPE[config->INPUT_SHAPE.size() - 2] = input_frame.rows;
 	auto *ptr = new cvModel();
 	ptr->FrameNum = 0;
-	ptr->Frameinterval = 0;
+	ptr->Frameinterval = config->SAMPLE_DATA;
 	ptr->countNum = 0;
 	ptr->width = input_frame.cols;
 	ptr->height = input_frame.rows;
+	///@note the pool is process wide, the first instance creating it decides the number of threads.
+	WorkPool::Configure(config->CPU_THREADS);
+	auto placement = placeStream(*config, gpuID);
 	ptr->iModel = GenModel(gpuID, config);
+	auto model = reinterpret_cast<InferModel *>(ptr->iModel);
+	model->m_placement = std::move(placement);
+	auto params = createUniqueRef<RuntimeParams>(*config);
+	buildROI(*params, input_frame.size(), *config);
+	model->m_params = createUniqueRef<RcuCell<RuntimeParams>>(std::move(params));
+	model->m_latency = LatencyRegistry::Instance().Acquire(ptr, config->TIMING);
+	if (config->EVIDENCE) {
+		EvidenceOptions options;
+		options.dir = config->EVIDENCE_DIR;
+		options.crop = config->EVIDENCE_CROP;
+		options.margin = config->EVIDENCE_MARGIN;
+		options.quality = config->EVIDENCE_QUALITY;
+		options.capacity = config->EVIDENCE_QUEUE;
+		///@note the writer is process wide, the first instance creating it decides the options.
+		EvidenceWriter::Configure(options);
+		EvidenceWriter::Instance();
+	}
+	if (config->TIMING && !config->TIMING_FILE.empty())LatencyRegistry::Instance().SetDumpFile(config->TIMING_FILE);
+	if (config->TRACE) {
+		auto &tracer = Tracer::Instance();
+		tracer.SetBufferCapacity(config->TRACE_BUFFER_SIZE);
+		tracer.SetSampling(config->TRACE_SAMPLING);
+		if (!config->TRACE_FILE.empty())tracer.SetExportFile(config->TRACE_FILE);
+		tracer.SetEnabled(true);
+	}
 	return ptr;
 }
 
@@ -89,47 +280,441 @@ void SetPara_Algorithm(cvModel *pModel, int algID)
 	//todo: implement this
 }
 
+/**
+ * @brief pin a thread working for the stream to its node and select its GPU, the current device is per thread.
+ */
+static void bindStreamThread(const InferModel *model)
+{
+	const auto &placement = model->m_placement;
+	if (placement.placed) {
+		pinThread(pthread_self(), placement.node_cpus);
+		if (Placement::Instance().Options().bind_memory && Placement::Instance().Topology().Nodes().size() > 1) {
+			preferMemoryNode(placement.node);
+		}
+	}
+	if (model->m_config->BACKEND != "mock") {
+		cv::cuda::setDevice(model->m_gpu_id);
+		cudaSetDevice(model->m_gpu_id);
+	}
+}
+
+int BindThread_Algorithm(cvModel *pModel)
+{
+	auto model = reinterpret_cast<InferModel *>(pModel->iModel);
+	if (model->m_config->BACKEND != "mock") {
+		cv::cuda::setDevice(model->m_gpu_id);
+		cudaSetDevice(model->m_gpu_id);
+	}
+	const auto &placement = model->m_placement;
+	if (!placement.placed)return -1;
+	pinThread(pthread_self(), {placement.worker_cpu});
+	///@note the buffers allocated from now on by this thread are first touched on the stream's node.
+	if (Placement::Instance().Options().bind_memory && Placement::Instance().Topology().Nodes().size() > 1) {
+		if (!preferMemoryNode(placement.node)) {
+			logStream(LogLevel::WARNING) << "Cannot prefer memory of node " << placement.node << std::endl;
+		}
+	}
+	return 0;
+}
+
+int Prepare_Algorithm(cvModel *pModel, int warmup_num)
+{
+	auto model = reinterpret_cast<InferModel *>(pModel->iModel);
+	int state = READY_LAZY;
+	if (!model->m_ready.compare_exchange_strong(state, READY_PREPARING))return state;
+	const int times = warmup_num >= 0 ? warmup_num : model->m_config->WARMUP_NUM;
+	model->m_prepare = std::async(std::launch::async, [model, times]() {
+		Tracer::Instance().SetThreadName("prepare");
+		///@note engine and buffers are allocated here, so they should land on the stream's node as well.
+		bindStreamThread(model);
+		auto start = std::chrono::steady_clock::now();
+		const bool ok = model->mDeploy->Prepare(times);
+		auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+		if (ok) {
+			logStream(LogLevel::INFO) << "Prepared with " << times << " warm up inferences in " << ms << "ms" << std::endl;
+		}
+		else {
+			logStream(LogLevel::ERROR) << "Prepare failed, frames are passed through without inference." << std::endl;
+		}
+		model->m_ready.store(ok ? READY_OK : READY_FAILED, std::memory_order_release);
+	});
+	return READY_PREPARING;
+}
+
+int IsReady_Algorithm(cvModel *pModel)
+{
+	auto model = reinterpret_cast<InferModel *>(pModel->iModel);
+	return model->m_ready.load(std::memory_order_acquire);
+}
+
 void UpdateParams_Algorithm(cvModel *pModel)
 {
 	auto model = reinterpret_cast<InferModel *>(pModel->iModel);
-	auto roi = pModel->p;
-	model->m_roi_img = genROI(cv::Size(pModel->width,pModel->height),
-							  pModel->pointNum, roi);
+	std::vector<cv::Point> points;
+	int total = 0;
+	for (auto each : pModel->pointNum) {
+		total += each;
+	}
+	total = std::min(total, SIZE);
+	for (int j = 0; j < total; ++j) {
+		points.emplace_back(pModel->p[j].x, pModel->p[j].y);
+	}
+	///@note the masks are built before publishing, so streams keep using the old ROI until it is done.
+	const auto frame = cv::Size(pModel->width, pModel->height);
+	const auto &config = *model->m_config;
+	model->m_params->Update([&](RuntimeParams &next) {
+		next.version++;
+		next.pointNum = pModel->pointNum;
+		next.points = std::move(points);
+		buildROI(next, frame, config);
+	});
+}
+
+long UpdateRuntime_Algorithm(cvModel *pModel, float score_threshold, int alarm_count, int sample_interval)
+{
+	auto model = reinterpret_cast<InferModel *>(pModel->iModel);
+	uint64_t version = 0;
+	model->m_params->Update([&](RuntimeParams &next) {
+		if (score_threshold >= 0.0f)next.SCORE_THRESHOLD = score_threshold;
+		if (alarm_count > 0)next.ALARM_COUNT = alarm_count;
+		if (sample_interval > 0)next.SAMPLE_DATA = sample_interval;
+		version = ++next.version;
+	});
+	if (sample_interval > 0)pModel->Frameinterval = sample_interval;
+	return (long)version;
 }
 
-void Process_Algorithm(cvModel *pModel, cv::Mat &input_frame)
+long UpdateInputSize_Algorithm(cvModel *pModel, int width, int height)
+{
+	auto model = reinterpret_cast<InferModel *>(pModel->iModel);
+	if (width <= 0 || height <= 0)return -1;
+	uint64_t version = 0;
+	model->m_params->Update([&](RuntimeParams &next) {
+		next.TARGET_W = width;
+		next.TARGET_H = height;
+		version = ++next.version;
+	});
+	return (long)version;
+}
+
+/**
+ * @brief draw the ROI polygons, given at the allocated frame size, onto a frame of any size.
+ */
+static void drawROI(const cvModel *pModel, const RuntimeParams &params, const Config &config, cv::Mat &frame)
+{
+	const auto &roi = params.points;
+	const float sx = (float)frame.cols / (float)pModel->width;
+	const float sy = (float)frame.rows / (float)pModel->height;
+	int sums = 0;
+	for (auto &each : params.pointNum) {
+		for (int j = sums; j < each + sums; ++j) {
+			int k = j + 1;
+			if (k == each + sums)k = sums;
+			cv::line(frame, cv::Point(cvRound(roi[j].x * sx), cvRound(roi[j].y * sy)),
+					 cv::Point(cvRound(roi[k].x * sx), cvRound(roi[k].y * sy)), cv::Scalar(255, 0, 0),
+					 config.BOX_LINE_WIDTH);
+		}
+		sums += each;
+	}
+}
+
+/**
+ * @brief queue an evidence snapshot of the frame if it raised an alarm.
+ * @param frame frame as handed back to the caller.
+ * @param index frame index of the stream.
+ */
+static void keepEvidence(cvModel *pModel, const cv::Mat &frame, int64_t index)
 {
+	auto model = reinterpret_cast<InferModel *>(pModel->iModel);
+	if (!pModel->alarm || !model->m_config->EVIDENCE)return;
+	model->mDeploy->Detections(model->m_boxes);
+	model->m_evidence.clear();
+	for (const auto &b : model->m_boxes) {
+		if (b.class_id != model->m_config->TARGET_CLASS)continue;
+		model->m_evidence.push_back(cv_Detection{b.class_id, b.score, b.x_min, b.y_min, b.x_max, b.y_max});
+	}
+	EvidenceWriter::Instance().Capture(frame, model->m_latency->id, index, model->m_evidence);
+}
 
+/**
+ * @brief process one frame on the calling thread.
+ * @param draw draw the results and ROI onto the frame, otherwise only the alarm is updated.
+ * @return false if the frame is passed through since the backend is not ready.
+ */
+static bool processFrame(cvModel *pModel, cv::Mat &input_frame, bool draw)
+{
 	auto model = reinterpret_cast<InferModel *>(pModel->iModel);
-	auto roi = pModel->p;
-	if (model->m_roi_img.empty()) {
-		model->m_roi_img = genROI(input_frame.size(), pModel->pointNum, roi);
+	if (!model->Ready()) {
+		model->PassThrough(pModel);
+		return false;
 	}
+	const int64_t index = model->m_frame++;
+	StreamScope scope(model->m_latency.get(), index);
+	RcuCell<RuntimeParams>::ReadGuard params(*model->m_params);
+	applyThresholds(model, *params);
 	cv::Mat removed_roi;
 	auto config = model->m_config;
 
-	if(model->m_process==config->SAMPLE_DATA){
-		input_frame.copyTo(removed_roi, model->m_roi_img);
+	if (model->NextSample(params->SAMPLE_DATA)) {
+		{
+			StageTimer timer(Stage::ROI_MASK);
+			input_frame.copyTo(removed_roi, model->ROIFor(*params, input_frame.size()));
+		}
 		model->mDeploy->Infer(removed_roi, model->mResult);
 	}
-	model->m_process--;
-	if(model->m_process<=0){
-		model->m_process = config->SAMPLE_DATA;
+	if (!draw) {
+		model->mDeploy->Postprocessing(model->mResult, input_frame.size(), pModel->alarm);
+		keepEvidence(pModel, input_frame, index);
+		return true;
 	}
 	model->mDeploy->Postprocessing(model->mResult, input_frame, pModel->alarm);
+	drawROI(pModel, *params, *config, input_frame);
+	keepEvidence(pModel, input_frame, index);
+	return true;
+}
 
-	int sums = 0;
-	for (auto &each : pModel->pointNum) {
-		for (int j = sums; j < each + sums; ++j) {
-			int k = j + 1;
-			if (k == each + sums)k = sums;
-			cv::line(input_frame, cv::Point(roi[j].x, roi[j].y),
-					 cv::Point(roi[k].x, roi[k].y), cv::Scalar(255, 0, 0),
-					 config->BOX_LINE_WIDTH);
+void Process_Algorithm(cvModel *pModel, cv::Mat &input_frame)
+{
+	processFrame(pModel, input_frame, true);
+}
+
+int Process_Algorithm_Batch(cvModel **pModels, cv::Mat *input_frames, int n)
+{
+	using ParamsGuard = RcuCell<RuntimeParams>::ReadGuard;
+	struct Item
+	{
+		cvModel *pModel = nullptr;
+		InferModel *model = nullptr;
+		cv::Mat *frame = nullptr;
+		int64_t index = 0;///< frame index of the stream.
+		UniqueRef<ParamsGuard> params;
+		cv::Mat removed_roi;
+		bool infer = false;
+		bool grouped = false;
+	};
+	std::vector<Item> items;
+	items.reserve(std::max(n, 0));
+	for (int i = 0; i < n; ++i) {
+		auto model = reinterpret_cast<InferModel *>(pModels[i]->iModel);
+		if (!model->Ready()) {
+			model->PassThrough(pModels[i]);
+			continue;
 		}
-		sums += each;
+		Item item;
+		item.pModel = pModels[i];
+		item.model = model;
+		item.frame = &input_frames[i];
+		item.index = model->m_frame++;
+		StreamScope scope(model->m_latency.get(), item.index);
+		item.params = createUniqueRef<ParamsGuard>(*model->m_params);
+		applyThresholds(model, **item.params);
+		item.infer = model->NextSample((*item.params)->SAMPLE_DATA);
+		if (item.infer) {
+			StageTimer timer(Stage::ROI_MASK);
+			item.frame->copyTo(item.removed_roi, model->ROIFor(**item.params, item.frame->size()));
+		}
+		items.push_back(std::move(item));
+	}
+
+	///@note frames of the same model file, size, backend and GPU share one preprocessing and inference, run by the first stream's backend.
+	int inferred = 0;
+	std::vector<cv::Mat> imgs;
+	std::vector<SharedRef<TrtResults>> results;
+	for (size_t i = 0; i < items.size(); ++i) {
+		auto &lead = items[i];
+		if (!lead.infer || lead.grouped)continue;
+		imgs.clear();
+		results.clear();
+		for (size_t j = i; j < items.size(); ++j) {
+			auto &other = items[j];
+			if (!other.infer || other.grouped)continue;
+			///@note the lead's engine runs the group, so the frames must target the same backend and GPU.
+			if (other.frame->size() != lead.frame->size() ||
+				other.model->m_config->MODEL_NAME != lead.model->m_config->MODEL_NAME ||
+				other.model->mDeploy->InputSize() != lead.model->mDeploy->InputSize() ||
+				other.model->m_config->BACKEND != lead.model->m_config->BACKEND ||
+				other.model->m_gpu_id != lead.model->m_gpu_id) {
+				continue;
+			}
+			other.grouped = true;
+			imgs.push_back(other.removed_roi);
+			results.push_back(other.model->mResult);
+		}
+		StreamScope scope(lead.model->m_latency.get(), lead.index);
+		if (lead.model->m_config->BACKEND != "mock") {
+			cv::cuda::setDevice(lead.model->m_gpu_id);
+			cudaSetDevice(lead.model->m_gpu_id);
+		}
+		lead.model->mDeploy->InferBatch(imgs, results);
+		inferred += (int)imgs.size();
+	}
+
+	for (auto &item : items) {
+		StreamScope scope(item.model->m_latency.get(), item.index);
+		item.model->mDeploy->Postprocessing(item.model->mResult, *item.frame, item.pModel->alarm);
+		drawROI(item.pModel, **item.params, *item.model->m_config, *item.frame);
+		keepEvidence(item.pModel, *item.frame, item.index);
+	}
+	return inferred;
+}
+
+void Skip_Algorithm(cvModel *pModel)
+{
+	auto model = reinterpret_cast<InferModel *>(pModel->iModel);
+	if (!model->Ready()) {
+		model->PassThrough(pModel);
+		return;
+	}
+	StreamScope scope(model->m_latency.get(), model->m_frame++);
+	RcuCell<RuntimeParams>::ReadGuard params(*model->m_params);
+	applyThresholds(model, *params);
+	model->NextSample(params->SAMPLE_DATA);
+	model->mDeploy->Postprocessing(model->mResult, cv::Size(pModel->width, pModel->height), pModel->alarm);
+}
+
+void ProcessYUV_Algorithm(cvModel *pModel, cv::Mat &yuv_frame, int format)
+{
+	auto model = reinterpret_cast<InferModel *>(pModel->iModel);
+	if (!model->Ready()) {
+		model->PassThrough(pModel);
+		return;
+	}
+	StreamScope scope(model->m_latency.get(), model->m_frame++);
+	RcuCell<RuntimeParams>::ReadGuard params(*model->m_params);
+	applyThresholds(model, *params);
+	auto pixel_format = static_cast<PixelFormat>(format);
+	auto picture = getPictureSize(yuv_frame, pixel_format);
+
+	if (model->NextSample(params->SAMPLE_DATA)) {
+		model->mDeploy->Infer(yuv_frame, pixel_format, params->roi_small, model->mResult);
+	}
+	model->mDeploy->Postprocessing(model->mResult, picture, pModel->alarm);
+}
+
+long GetLatency_Algorithm(cvModel *pModel, int stage, float *percentiles)
+{
+	if (stage < 0 || stage >= (int)Stage::NUM)return -1;
+	auto stats = LatencyRegistry::Instance().Find(pModel);
+	if (!stats || !stats->enabled)return -1;
+	const auto &h = stats->stages[stage];
+	if (percentiles) {
+		percentiles[0] = (float)(h.Percentile(0.5) / 1000.0);
+		percentiles[1] = (float)(h.Percentile(0.9) / 1000.0);
+		percentiles[2] = (float)(h.Percentile(0.99) / 1000.0);
+		percentiles[3] = (float)(h.Percentile(0.999) / 1000.0);
+	}
+	return (long)h.Count();
+}
+
+long GetPlanCache_Algorithm(cvModel *pModel, long *stats)
+{
+	auto model = reinterpret_cast<InferModel *>(pModel->iModel);
+	if (model->m_ready.load(std::memory_order_acquire) == READY_PREPARING)return -1;
+	auto cache = model->mDeploy->CacheStats();
+	if (stats) {
+		stats[0] = (long)cache.hits;
+		stats[1] = (long)cache.misses;
+		stats[2] = (long)cache.evictions;
+	}
+	return (long)cache.size;
+}
+
+int GetPlacement_Algorithm(cvModel *pModel, int *placement)
+{
+	auto model = reinterpret_cast<InferModel *>(pModel->iModel);
+	const auto &slot = model->m_placement;
+	if (!slot.placed)return -1;
+	if (placement) {
+		placement[0] = slot.node;
+		placement[1] = slot.worker_cpu;
+		placement[2] = slot.decode_cpu;
+	}
+	return 0;
+}
+
+int SetCallback_Algorithm(cvModel *pModel, AsyncCallback_Algorithm callback, void *user_data, int max_in_flight, int flags)
+{
+	auto model = reinterpret_cast<InferModel *>(pModel->iModel);
+	///@note the old worker is joined first, its queued frames are reported as cancelled.
+	model->m_async.reset();
+	if (!callback)return 0;
+	if (max_in_flight <= 0)max_in_flight = model->m_config->ASYNC_IN_FLIGHT;
+	auto process = [pModel](cv::Mat &frame, bool annotate, int &alarm, std::vector<cv_Detection> &dets) {
+		auto model = reinterpret_cast<InferModel *>(pModel->iModel);
+		dets.clear();
+		if (!processFrame(pModel, frame, annotate)) {
+			alarm = 0;
+			return;
+		}
+		alarm = pModel->alarm;
+		model->mDeploy->Detections(model->m_boxes);
+		for (const auto &b : model->m_boxes) {
+			dets.push_back(cv_Detection{b.class_id, b.score, b.x_min, b.y_min, b.x_max, b.y_max});
+		}
+	};
+	///@note the worker runs inference, it needs the stream's GPU and node like Prepare_Algorithm.
+	auto setup = [model] { bindStreamThread(model); };
+	model->m_async = createUniqueRef<AsyncRunner>(pModel, process, callback, user_data, max_in_flight, flags, setup);
+	return 0;
+}
+
+long Submit_Algorithm(cvModel *pModel, cv::Mat &input_frame)
+{
+	auto model = reinterpret_cast<InferModel *>(pModel->iModel);
+	if (!model->m_async)return -1;
+	return model->m_async->Submit(input_frame);
+}
+
+int Flush_Algorithm(cvModel *pModel, int timeout_ms)
+{
+	auto model = reinterpret_cast<InferModel *>(pModel->iModel);
+	if (!model->m_async)return 0;
+	return model->m_async->Flush(timeout_ms) ? 0 : -1;
+}
+
+long GetAsyncStats_Algorithm(cvModel *pModel, long *stats)
+{
+	auto model = reinterpret_cast<InferModel *>(pModel->iModel);
+	if (!model->m_async)return -1;
+	auto async = model->m_async->GetStats();
+	if (stats) {
+		stats[0] = (long)async.submitted;
+		stats[1] = (long)async.completed;
+		stats[2] = (long)async.dropped;
+	}
+	return (long)async.in_flight;
+}
+
+long GetEvidenceStats_Algorithm(cvModel *pModel, long *stats, float *latency)
+{
+	auto model = reinterpret_cast<InferModel *>(pModel->iModel);
+	if (!model->m_config->EVIDENCE)return -1;
+	const auto &writer = EvidenceWriter::Instance();
+	auto evidence = writer.GetStats();
+	if (stats) {
+		stats[0] = (long)evidence.captured;
+		stats[1] = (long)evidence.written;
+		stats[2] = (long)evidence.dropped;
+		stats[3] = (long)evidence.failed;
+	}
+	if (latency) {
+		latency[0] = (float)(writer.Latency().Percentile(0.5) / 1000.0);
+		latency[1] = (float)(writer.Latency().Percentile(0.99) / 1000.0);
+		latency[2] = (float)(writer.Latency().Max() / 1000.0);
 	}
+	return (long)evidence.depth;
+}
 
+void SetTrace_Algorithm(int enable, int sampling)
+{
+	Tracer::Instance().SetSampling(sampling);
+	Tracer::Instance().SetEnabled(enable != 0);
+}
+
+int DumpTrace_Algorithm(const char *file)
+{
+	if (!file)return -1;
+	return Tracer::Instance().Export(std::string(file)) ? 0 : -1;
 }
 
 void Destroy_Algorithm(cvModel *pModel)
@@ -139,6 +724,8 @@ void Destroy_Algorithm(cvModel *pModel)
 		delete model;
 		model = nullptr;
 	}
+	///@note released once the async worker and the preparing thread are done, their latest frames count too.
+	LatencyRegistry::Instance().Release(pModel);
 	delete pModel;
 	pModel = nullptr;
 }
@@ -26,6 +26,36 @@ typedef enum
 
 } EIAType;
 
+typedef enum
+{
+	PIXEL_FORMAT_BGR = 0,  //BGR三通道，CV_8UC3
+	PIXEL_FORMAT_NV12 = 1, //NV12，CV_8UC1，高度为图像高度的3/2
+	PIXEL_FORMAT_I420 = 2  //I420，CV_8UC1，高度为图像高度的3/2
+
+} EPixelFormat;
+
+typedef enum
+{
+	STAGE_DECODE = 0,		  //视频解码
+	STAGE_ROI_MASK = 1,		  //ROI区域掩码
+	STAGE_PREPROCESS = 2,	  //预处理
+	STAGE_INFER = 3,		  //推理
+	STAGE_DECODE_RESULTS = 4, //推理结果解析与报警
+	STAGE_DRAW = 5,			  //绘制结果
+	STAGE_ENCODE = 6,		  //视频编码
+	STAGE_NUM = 7
+
+} EStage;
+
+typedef enum
+{
+	READY_LAZY = 0,		 //未调用Prepare_Algorithm，首帧处理时同步初始化
+	READY_PREPARING = 1, //后台初始化与预热中
+	READY_OK = 2,		 //初始化完成，可以推理
+	READY_FAILED = 3	 //模型加载或显存分配失败
+
+} EReadyState;
+
 typedef struct
 {
 	int x;
@@ -33,6 +63,44 @@ typedef struct
 
 } cv_Point;
 
+typedef struct
+{
+	int class_id; //类别
+	float score;  //置信度
+	int x_min;	  //原图坐标
+	int y_min;
+	int x_max;
+	int y_max;
+
+} cv_Detection;
+
+typedef enum
+{
+	ASYNC_DONE = 0,		 //处理完成
+	ASYNC_DROPPED = 1,	 //在途帧数达到上限被丢弃，未处理
+	ASYNC_CANCELLED = 2	 //销毁或重新注册回调时仍在排队，未处理
+
+} EAsyncStatus;
+
+typedef enum
+{
+	ASYNC_ANNOTATE = 1,	  //回调中提供绘制了检测框与ROI的帧
+	ASYNC_DROP_OLDEST = 2 //在途帧数达到上限时丢弃最早排队的帧，默认丢弃新提交的帧
+
+} EAsyncFlag;
+
+typedef struct
+{
+	long ticket;			  //Submit_Algorithm返回的帧编号
+	int status;				  //EAsyncStatus
+	int alarm;				  //0代表正常，1 代表异常
+	int num_dets;			  //检测框个数
+	const cv_Detection *dets; //检测框，仅在回调内有效
+	cv::Mat *frame;			  //ASYNC_ANNOTATE时为绘制后的帧，否则为nullptr，仅在回调内有效
+	void *user_data;		  //注册回调时传入
+
+} cvAsyncResult;
+
 typedef struct
 {
 	cv_Point p[SIZE]; //用于画出ROI的点，请顺时针给出，目前支持四边形
@@ -66,11 +134,59 @@ typedef struct
 
 } cvModel;
 
+// 异步处理完成或丢弃时的回调，在库内线程中按帧编号顺序调用，回调返回前该路不会处理下一帧
+typedef void (*AsyncCallback_Algorithm)(cvModel *pModel, const cvAsyncResult *result);
+
 
 extern cvModel* Allocate_Algorithm(cv::Mat &input_frame, int algID, int gpuID);
 extern void SetPara_Algorithm(cvModel *pModel,int algID);
+// 将调用线程绑定到本路分配的处理CPU(配置PLACEMENT)并选择本路GPU，由处理本路帧的线程在处理前调用；Allocate_Algorithm只分配CPU，不绑定调用线程
+// 未放置时仅选择GPU并返回-1，成功返回0；库内为本路工作的线程(预热、异步回调)自动绑定
+extern int BindThread_Algorithm(cvModel *pModel);
+// 在Allocate_Algorithm之后、首次处理之前调用，于后台线程完成模型加载、显存分配、预处理计划构建及warmup_num次预热推理(<0时使用配置WARMUP_NUM)
+// 就绪前Process_Algorithm等不会阻塞，帧原样返回且alarm为0，采样节奏照常推进(配置PASS_THROUGH为False时等待就绪)；返回当前状态(EReadyState)
+extern int Prepare_Algorithm(cvModel *pModel, int warmup_num);
+// 查询就绪状态(EReadyState)，不阻塞
+extern int IsReady_Algorithm(cvModel *pModel);
 extern void UpdateParams_Algorithm(cvModel *pModel);
 extern void Process_Algorithm(cvModel *pModel, cv::Mat &input_frame);
+// 多路批量处理，frames[i]由models[i]处理，采样、ROI、报警与画框语义与逐路调用Process_Algorithm相同
+// 同一模型文件、同一后端与GPU、同一帧分辨率且同一网络输入分辨率的帧合并为一次预处理与推理(每次最多为引擎批大小)，结果按路分发；每路在数组中至多出现一次，且调用期间不可在其他线程处理
+// 返回实际推理的帧数
+extern int Process_Algorithm_Batch(cvModel **pModels, cv::Mat *input_frames, int n);
+// 注册异步回调并启动该路的处理线程，max_in_flight为排队与处理中的帧数上限(<=0时使用配置ASYNC_IN_FLIGHT)，flags为EAsyncFlag的组合
+// callback为nullptr时停止处理线程；重新注册时排队的帧以ASYNC_CANCELLED通知；返回0成功
+extern int SetCallback_Algorithm(cvModel *pModel, AsyncCallback_Algorithm callback, void *user_data, int max_in_flight, int flags);
+// 异步提交一帧，帧被复制后立即返回帧编号，结果通过回调返回；未注册回调时返回-1
+// 注册回调后不可再对该路调用Process_Algorithm等同步接口，报警状态以回调为准
+extern long Submit_Algorithm(cvModel *pModel, cv::Mat &input_frame);
+// 等待已提交的帧全部回调完成，timeout_ms<0时一直等待，完成返回0，超时返回-1
+extern int Flush_Algorithm(cvModel *pModel, int timeout_ms);
+// 读取异步统计，stats依次为提交数/完成数/丢弃数，返回当前在途帧数；未注册回调时返回-1
+extern long GetAsyncStats_Algorithm(cvModel *pModel, long *stats);
+// 读取报警取证快照统计(配置EVIDENCE，进程内各路共用)，stats依次为入队数/写入数/丢弃数/失败数，latency依次为编码写盘耗时p50/p99/最大值(毫秒)
+// 返回排队与编码中的快照数；未开启EVIDENCE时返回-1
+extern long GetEvidenceStats_Algorithm(cvModel *pModel, long *stats, float *latency);
+// 运行时更新参数，立即对下一帧生效：score_threshold<0、alarm_count<=0、sample_interval<=0表示不修改；返回新的参数版本号
+// ROI多边形通过修改pointNum/p后调用UpdateParams_Algorithm更新，二者均可在其他线程调用
+extern long UpdateRuntime_Algorithm(cvModel *pModel, float score_threshold, int alarm_count, int sample_interval);
+// 运行时修改网络输入分辨率，对下一帧生效，无需重建流水线；须在引擎优化配置(OPT_PROFILE)的范围内，超出时保持原分辨率
+// 返回新的参数版本号，参数非法时返回-1
+extern long UpdateInputSize_Algorithm(cvModel *pModel, int width, int height);
+// 跳过未解码的帧，仅计数并更新报警状态，保持与Frameinterval一致的采样节奏
+extern void Skip_Algorithm(cvModel *pModel);
+// 直接处理YUV帧（EPixelFormat），色彩转换与缩放合并进行，仅更新报警状态，不绘制结果
+extern void ProcessYUV_Algorithm(cvModel *pModel, cv::Mat &yuv_frame, int format);
+// 读取某阶段(EStage)耗时分位数，percentiles依次为p50/p90/p99/p999(毫秒)，返回样本数；未开启TIMING时返回-1
+extern long GetLatency_Algorithm(cvModel *pModel, int stage, float *percentiles);
+// 读取各分辨率预处理缓存的统计，stats依次为命中数/构建数/淘汰数，返回当前缓存的分辨率个数；后台初始化中返回-1
+extern long GetPlanCache_Algorithm(cvModel *pModel, long *stats);
+// 读取本路的CPU放置(配置PLACEMENT)，placement依次为NUMA节点/处理线程CPU/解码线程CPU，未放置时返回-1
+extern int GetPlacement_Algorithm(cvModel *pModel, int *placement);
+// 运行时开关阶段追踪，sampling为采样间隔(每sampling帧追踪一帧)，所有路共享
+extern void SetTrace_Algorithm(int enable, int sampling);
+// 将已缓存的追踪事件写为Chrome trace-event JSON，可由Perfetto或chrome://tracing打开，成功返回0
+extern int DumpTrace_Algorithm(const char *file);
 extern void Destroy_Algorithm(cvModel *pModel);
 
 }
@@ -0,0 +1,266 @@
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#if defined(__x86_64__) || defined(__i386__)
+#define HELMET_NMS_X86
+#include <immintrin.h>
+#endif
+#include "nms.h"
+
+namespace helmet
+{
+
+/**
+ * @brief sorted candidates of HostNms::Run() tested by a kernel, padded by 8 for vector loads.
+ */
+struct SuppressArgs
+{
+	const float *x1;
+	const float *y1;
+	const float *x2;
+	const float *y2;
+	const float *area;
+	unsigned char *suppressed;
+	size_t n;
+	float iou;
+};
+
+/**
+ * @brief suppress the candidates after k overlapping candidate k more than the IoU threshold.
+ */
+static void suppressScalar(const SuppressArgs &a, size_t k)
+{
+	const float ax1 = a.x1[k], ay1 = a.y1[k], ax2 = a.x2[k], ay2 = a.y2[k], aarea = a.area[k];
+	for (size_t j = k + 1; j < a.n; ++j) {
+		const float w = std::max(0.0f, std::min(ax2, a.x2[j]) - std::max(ax1, a.x1[j]));
+		const float h = std::max(0.0f, std::min(ay2, a.y2[j]) - std::max(ay1, a.y1[j]));
+		const float inter = w * h;
+		if (inter > a.iou * (aarea + a.area[j] - inter))a.suppressed[j] = 1;
+	}
+}
+
+#ifdef HELMET_NMS_X86
+__attribute__((target("sse2")))
+static void suppressSse(const SuppressArgs &a, size_t k)
+{
+	const __m128 vx1 = _mm_set1_ps(a.x1[k]), vy1 = _mm_set1_ps(a.y1[k]);
+	const __m128 vx2 = _mm_set1_ps(a.x2[k]), vy2 = _mm_set1_ps(a.y2[k]);
+	const __m128 varea = _mm_set1_ps(a.area[k]), viou = _mm_set1_ps(a.iou), zero = _mm_setzero_ps();
+	for (size_t j = k + 1; j < a.n; j += 4) {
+		__m128 w = _mm_sub_ps(_mm_min_ps(vx2, _mm_loadu_ps(&a.x2[j])), _mm_max_ps(vx1, _mm_loadu_ps(&a.x1[j])));
+		__m128 h = _mm_sub_ps(_mm_min_ps(vy2, _mm_loadu_ps(&a.y2[j])), _mm_max_ps(vy1, _mm_loadu_ps(&a.y1[j])));
+		__m128 inter = _mm_mul_ps(_mm_max_ps(w, zero), _mm_max_ps(h, zero));
+		__m128 uni = _mm_sub_ps(_mm_add_ps(varea, _mm_loadu_ps(&a.area[j])), inter);
+		int mask = _mm_movemask_ps(_mm_cmpgt_ps(inter, _mm_mul_ps(viou, uni)));
+		for (; mask; mask &= mask - 1) {
+			a.suppressed[j + __builtin_ctz(mask)] = 1;
+		}
+	}
+}
+
+__attribute__((target("avx")))
+static void suppressAvx(const SuppressArgs &a, size_t k)
+{
+	const __m256 vx1 = _mm256_set1_ps(a.x1[k]), vy1 = _mm256_set1_ps(a.y1[k]);
+	const __m256 vx2 = _mm256_set1_ps(a.x2[k]), vy2 = _mm256_set1_ps(a.y2[k]);
+	const __m256 varea = _mm256_set1_ps(a.area[k]), viou = _mm256_set1_ps(a.iou), zero = _mm256_setzero_ps();
+	for (size_t j = k + 1; j < a.n; j += 8) {
+		__m256 w = _mm256_sub_ps(_mm256_min_ps(vx2, _mm256_loadu_ps(&a.x2[j])),
+								 _mm256_max_ps(vx1, _mm256_loadu_ps(&a.x1[j])));
+		__m256 h = _mm256_sub_ps(_mm256_min_ps(vy2, _mm256_loadu_ps(&a.y2[j])),
+								 _mm256_max_ps(vy1, _mm256_loadu_ps(&a.y1[j])));
+		__m256 inter = _mm256_mul_ps(_mm256_max_ps(w, zero), _mm256_max_ps(h, zero));
+		__m256 uni = _mm256_sub_ps(_mm256_add_ps(varea, _mm256_loadu_ps(&a.area[j])), inter);
+		int mask = _mm256_movemask_ps(_mm256_cmp_ps(inter, _mm256_mul_ps(viou, uni), _CMP_GT_OQ));
+		for (; mask; mask &= mask - 1) {
+			a.suppressed[j + __builtin_ctz(mask)] = 1;
+		}
+	}
+}
+#endif
+
+bool nmsKernelSupported(NmsKernel kernel)
+{
+	switch (kernel) {
+	case NmsKernel::SCALAR:
+		return true;
+#ifdef HELMET_NMS_X86
+	case NmsKernel::SSE:
+		return __builtin_cpu_supports("sse2");
+	case NmsKernel::AVX:
+		return __builtin_cpu_supports("avx");
+#endif
+	default:
+		return false;
+	}
+}
+
+NmsKernel bestNmsKernel()
+{
+	static const NmsKernel best = nmsKernelSupported(NmsKernel::AVX) ? NmsKernel::AVX :
+								  nmsKernelSupported(NmsKernel::SSE) ? NmsKernel::SSE : NmsKernel::SCALAR;
+	return best;
+}
+
+bool parseRawFormat(const std::string &name, RawFormat &format)
+{
+	std::string upper(name);
+	std::transform(upper.begin(), upper.end(), upper.begin(), [](unsigned char c) { return (char)std::toupper(c); });
+	if (upper == "YOLOV5") {
+		format = RawFormat::YOLOV5;
+		return true;
+	}
+	if (upper == "YOLOV8") {
+		format = RawFormat::YOLOV8;
+		return true;
+	}
+	return false;
+}
+
+void HostNms::Decode(const float *data, size_t size, RawFormat format, int num_classes,
+					 float score_threshold, BoxesSoA &boxes)
+{
+	boxes.Clear();
+	if (num_classes <= 0)return;
+	if (format == RawFormat::YOLOV5) {
+		const size_t stride = 5 + num_classes;
+		const size_t num = size / stride;
+		for (size_t n = 0; n < num; ++n) {
+			const float *row = data + n * stride;
+			const float obj = row[4];
+			///@note the final score is obj * cls <= obj, most anchors are rejected here.
+			if (obj < score_threshold)continue;
+			int best = 0;
+			for (int c = 1; c < num_classes; ++c) {
+				if (row[5 + c] > row[5 + best])best = c;
+			}
+			const float score = obj * row[5 + best];
+			if (score < score_threshold)continue;
+			const float hw = row[2] * 0.5f;
+			const float hh = row[3] * 0.5f;
+			boxes.Push(row[0] - hw, row[1] - hh, row[0] + hw, row[1] + hh, score, best);
+		}
+		return;
+	}
+
+	const size_t num = size / (4 + num_classes);
+	///@note planes are scanned one after another, so memory is read sequentially.
+	m_best.assign(data + 4 * num, data + 5 * num);
+	m_best_cls.assign(num, 0);
+	for (int c = 1; c < num_classes; ++c) {
+		const float *plane = data + (4 + c) * num;
+		for (size_t n = 0; n < num; ++n) {
+			if (plane[n] > m_best[n]) {
+				m_best[n] = plane[n];
+				m_best_cls[n] = c;
+			}
+		}
+	}
+	for (size_t n = 0; n < num; ++n) {
+		if (m_best[n] < score_threshold)continue;
+		const float hw = data[2 * num + n] * 0.5f;
+		const float hh = data[3 * num + n] * 0.5f;
+		boxes.Push(data[n] - hw, data[num + n] - hh, data[n] + hw, data[num + n] + hh, m_best[n], m_best_cls[n]);
+	}
+}
+
+void HostNms::Run(const BoxesSoA &boxes, const NmsParams &params, std::vector<int> &keep)
+{
+	keep.clear();
+	m_order.clear();
+	const size_t total = boxes.Size();
+	for (size_t i = 0; i < total; ++i) {
+		if (boxes.score[i] >= params.score_threshold)m_order.push_back((int)i);
+	}
+	if (m_order.empty() || params.top_k == 0)return;
+
+	auto by_score = [&](int a, int b) {
+		return boxes.score[a] > boxes.score[b] || (boxes.score[a] == boxes.score[b] && a < b);
+	};
+	if (params.pre_top_k > 0 && m_order.size() > (size_t)params.pre_top_k) {
+		std::partial_sort(m_order.begin(), m_order.begin() + params.pre_top_k, m_order.end(), by_score);
+		m_order.resize(params.pre_top_k);
+	}
+	else {
+		std::sort(m_order.begin(), m_order.end(), by_score);
+	}
+
+	///@note classes are shifted apart further than any coordinate, so boxes of different classes never overlap.
+	float extent = 0.0f;
+	for (auto i : m_order) {
+		extent = std::max(extent, std::max(std::abs(boxes.x2[i]), std::abs(boxes.y2[i])));
+		extent = std::max(extent, std::max(std::abs(boxes.x1[i]), std::abs(boxes.y1[i])));
+	}
+	const float offset = 2.0f * extent + 1.0f;
+
+	const size_t n = m_order.size();
+	const size_t padded = n + 8;
+	m_x1.assign(padded, 0.0f);
+	m_y1.assign(padded, 0.0f);
+	m_x2.assign(padded, 0.0f);
+	m_y2.assign(padded, 0.0f);
+	m_area.assign(padded, 0.0f);
+	m_suppressed.assign(padded, 0);
+	for (size_t k = 0; k < n; ++k) {
+		const int i = m_order[k];
+		const float shift = (float)boxes.cls[i] * offset;
+		m_x1[k] = boxes.x1[i] + shift;
+		m_y1[k] = boxes.y1[i] + shift;
+		m_x2[k] = boxes.x2[i] + shift;
+		m_y2[k] = boxes.y2[i] + shift;
+		m_area[k] = std::max(0.0f, boxes.x2[i] - boxes.x1[i]) * std::max(0.0f, boxes.y2[i] - boxes.y1[i]);
+	}
+
+	const SuppressArgs args{m_x1.data(), m_y1.data(), m_x2.data(), m_y2.data(), m_area.data(),
+							m_suppressed.data(), n, params.iou_threshold};
+	auto suppress = suppressScalar;
+#ifdef HELMET_NMS_X86
+	if (m_kernel == NmsKernel::AVX)suppress = suppressAvx;
+	else if (m_kernel == NmsKernel::SSE)suppress = suppressSse;
+#endif
+	const size_t limit = params.top_k > 0 ? (size_t)params.top_k : n;
+	for (size_t k = 0; k < n; ++k) {
+		if (m_suppressed[k])continue;
+		keep.push_back(m_order[k]);
+		if (keep.size() >= limit)break;
+		suppress(args, k);
+	}
+}
+
+bool HostNms::SetKernel(NmsKernel kernel)
+{
+	if (!nmsKernelSupported(kernel))return false;
+	m_kernel = kernel;
+	return true;
+}
+
+NmsKernel HostNms::Kernel() const
+{
+	return m_kernel;
+}
+
+int HostNms::Run(const BoxesSoA &boxes, const NmsParams &params, int rows, std::vector<float> &dets)
+{
+	Run(boxes, params, m_keep);
+	dets.resize((size_t)rows * 6);
+	const int num = std::min((int)m_keep.size(), rows);
+	for (int r = 0; r < rows; ++r) {
+		float *d = &dets[(size_t)r * 6];
+		if (r < num) {
+			const int i = m_keep[r];
+			d[0] = (float)boxes.cls[i];
+			d[1] = boxes.score[i];
+			d[2] = boxes.x1[i];
+			d[3] = boxes.y1[i];
+			d[4] = boxes.x2[i];
+			d[5] = boxes.y2[i];
+		}
+		else {
+			d[0] = -1.0f;
+			std::fill_n(d + 1, 5, 0.0f);
+		}
+	}
+	return num;
+}
+
+}
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace helmet
+{
+/**
+ * @brief layout of raw detector outputs decoded on host.
+ */
+enum class RawFormat
+{
+	YOLOV5 = 0,///< [N, 5 + C] rows of cx, cy, w, h, objectness and class scores.
+	YOLOV8 = 1 ///< [4 + C, N] planes of cx, cy, w, h and class scores, no objectness.
+};
+
+/**
+ * @brief parse a raw format name, i.e. "yolov5" or "yolov8".
+ * @param name format name, case insensitive.
+ * @param format parsed format, unchanged if the name is unknown.
+ * @return true if parsed.
+ */
+extern bool parseRawFormat(const std::string &name, RawFormat &format);
+
+/**
+ * @brief instruction set of the IoU test in HostNms::Run(), all of them keep the same boxes.
+ */
+enum class NmsKernel
+{
+	SCALAR = 0,
+	SSE = 1,///< SSE2, 4 boxes per test.
+	AVX = 2 ///< 8 boxes per test.
+};
+
+/**
+ * @brief check whether the CPU running the process supports a kernel.
+ */
+extern bool nmsKernelSupported(NmsKernel kernel);
+
+/**
+ * @brief get the widest kernel the CPU supports, checked once.
+ */
+extern NmsKernel bestNmsKernel();
+
+/**
+ * @brief candidate boxes stored as structure of arrays, so IoU of one box against many is vectorized.
+ */
+struct BoxesSoA
+{
+	std::vector<float> x1;
+	std::vector<float> y1;
+	std::vector<float> x2;
+	std::vector<float> y2;
+	std::vector<float> score;
+	std::vector<int> cls;
+
+	size_t Size() const
+	{
+		return score.size();
+	}
+
+	void Clear()
+	{
+		x1.clear();
+		y1.clear();
+		x2.clear();
+		y2.clear();
+		score.clear();
+		cls.clear();
+	}
+
+	void Push(float bx1, float by1, float bx2, float by2, float s, int c)
+	{
+		x1.push_back(bx1);
+		y1.push_back(by1);
+		x2.push_back(bx2);
+		y2.push_back(by2);
+		score.push_back(s);
+		cls.push_back(c);
+	}
+};
+
+/**
+ * @brief parameters of host NMS.
+ */
+struct NmsParams
+{
+	float score_threshold = 0.25f;///< candidates below are pruned before sorting.
+	float iou_threshold = 0.45f;///< boxes of the same class overlapping more are suppressed.
+	int pre_top_k = 1000;///< only the best candidates are sorted and compared, <= 0 for all.
+	int top_k = 100;///< maximum boxes kept.
+};
+
+/**
+ * @brief class aware non maximum suppression on CPU.
+ * @details boxes of different classes are shifted apart by class index, so one greedy pass handles <!--
+ * --> all classes. Candidates are pruned by score, the best pre_top_k are partially sorted, then each kept <!--
+ * --> box suppresses the rest with an SSE/AVX IoU test, division free: inter > iou * (area_a + area_b - inter). <!--
+ * --> The kernel is picked at runtime from the CPU, not from the compiler flags.
+ * @note the scratch buffers are reused, one object should be kept per stream.
+ * @example:
+ * @code
+ * 	HostNms nms;
+ * 	nms.Decode(raw.data(), raw.size(), RawFormat::YOLOV5, 2, params.score_threshold, boxes);
+ * 	nms.Run(boxes, params, keep);
+ * @endcode
+ */
+class HostNms final
+{
+public:
+	/**
+	 * @brief decode raw detector outputs into candidate boxes.
+	 * @details candidates whose objectness or best class score is below the threshold are skipped as early <!--
+	 * --> as possible, thus most of the grid is rejected before touching all class scores.
+	 * @note scores are taken as they are, i.e. the sigmoid is expected to be part of the export.
+	 * @param data raw output tensor.
+	 * @param size number of floats in data.
+	 * @param format layout of data.
+	 * @param num_classes number of classes C.
+	 * @param score_threshold minimal score of a candidate.
+	 * @param boxes output candidates in x1, y1, x2, y2 of the network input.
+	 */
+	void Decode(const float *data, size_t size, RawFormat format, int num_classes,
+				float score_threshold, BoxesSoA &boxes);
+
+	/**
+	 * @brief run NMS.
+	 * @param boxes candidate boxes.
+	 * @param params NMS parameters.
+	 * @param keep indices into boxes of kept boxes, in descending score.
+	 */
+	void Run(const BoxesSoA &boxes, const NmsParams &params, std::vector<int> &keep);
+
+	/**
+	 * @brief run NMS and write kept boxes as rows of [class, score, x_min, y_min, x_max, y_max], <!--
+	 * --> the same layout as multiclass_nms3.
+	 * @param boxes candidate boxes.
+	 * @param params NMS parameters.
+	 * @param rows number of output rows, rows beyond the kept boxes are padded with class -1.
+	 * @param dets output detections, resized to rows * 6.
+	 * @return number of kept boxes.
+	 */
+	int Run(const BoxesSoA &boxes, const NmsParams &params, int rows, std::vector<float> &dets);
+
+	/**
+	 * @brief force a kernel, e.g. to compare them.
+	 * @return false if the CPU does not support it, the kernel is unchanged then.
+	 */
+	bool SetKernel(NmsKernel kernel);
+
+	NmsKernel Kernel() const;
+
+private:
+	NmsKernel m_kernel = bestNmsKernel();
+	std::vector<int> m_order;///< candidate indices sorted by score.
+	std::vector<int> m_keep;
+	///@note sorted candidates with class offsets applied, padded for vector loads.
+	std::vector<float> m_x1;
+	std::vector<float> m_y1;
+	std::vector<float> m_x2;
+	std::vector<float> m_y2;
+	std::vector<float> m_area;
+	std::vector<unsigned char> m_suppressed;
+	std::vector<float> m_best;///< best class score per anchor, for planar layouts.
+	std::vector<int> m_best_cls;
+};
+
+}
@@ -0,0 +1,347 @@
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <thread>
+#include <tuple>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include "placement.h"
+#include "log.h"
+
+namespace helmet
+{
+
+bool parseCpuList(const std::string &text, std::vector<int> &cpus)
+{
+	cpus.clear();
+	std::stringstream ss(text);
+	std::string item;
+	while (std::getline(ss, item, ',')) {
+		///@note only surrounding blanks are dropped, "1 2" must not become 12.
+		const auto first_char = item.find_first_not_of(" \t\r\n");
+		if (first_char == std::string::npos)continue;
+		item = item.substr(first_char, item.find_last_not_of(" \t\r\n") - first_char + 1);
+		///@note only digits and one dash between two numbers are accepted, e.g. "1x", "1-2-3" or "-1" are malformed.
+		if (!std::isdigit((unsigned char)item[0]))return false;
+		const char *text_end = item.c_str() + item.size();
+		char *end = nullptr;
+		const long first = std::strtol(item.c_str(), &end, 10);
+		long last = first;
+		if (*end == '-') {
+			const char *second = end + 1;
+			if (!std::isdigit((unsigned char)*second))return false;
+			last = std::strtol(second, &end, 10);
+		}
+		if (end != text_end)return false;
+		///@note ids beyond CPU_SETSIZE cannot be pinned, a huge range would only exhaust memory.
+		if (last < first || last >= CPU_SETSIZE)return false;
+		for (long c = first; c <= last; ++c) {
+			cpus.push_back((int)c);
+		}
+	}
+	std::sort(cpus.begin(), cpus.end());
+	cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+	return true;
+}
+
+bool pinThread(pthread_t thread, const std::vector<int> &cpus)
+{
+	if (cpus.empty())return false;
+	cpu_set_t cpuset;
+	CPU_ZERO(&cpuset);
+	for (int c : cpus) {
+		if (c >= 0 && c < CPU_SETSIZE)CPU_SET(c, &cpuset);
+	}
+	const int rc = pthread_setaffinity_np(thread, sizeof(cpu_set_t), &cpuset);
+	if (rc != 0) {
+		logStream(LogLevel::WARNING) << "Error calling pthread_setaffinity_np: " << rc << std::endl;
+		return false;
+	}
+	return true;
+}
+
+/**
+ * @brief read the first line of a sysfs file.
+ * @return false if unreadable.
+ */
+static bool readLine(const std::string &file, std::string &line)
+{
+	std::ifstream in(file);
+	return in && std::getline(in, line);
+}
+
+int pciNumaNode(const std::string &bus_id)
+{
+	std::string id(bus_id);
+	std::transform(id.begin(), id.end(), id.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+	std::string line;
+	if (!readLine("/sys/bus/pci/devices/" + id + "/numa_node", line))return -1;
+	return std::atoi(line.c_str());
+}
+
+bool preferMemoryNode(int node)
+{
+#ifdef SYS_set_mempolicy
+	///@note called through syscall, so libnuma is not needed, 1 is MPOL_PREFERRED.
+	const int mpol_preferred = 1;
+	if (node < 0 || node >= 64)return false;
+	unsigned long mask = 1ul << node;
+	return syscall(SYS_set_mempolicy, mpol_preferred, &mask, sizeof(mask) * 8) == 0;
+#else
+	return false;
+#endif
+}
+
+void CpuTopology::Load(const std::string &root, const std::vector<int> &reserved)
+{
+	m_cores.clear();
+	m_nodes.clear();
+	std::vector<int> online;
+	std::string line;
+	if (!readLine(root + "/cpu/online", line) || !parseCpuList(line, online) || online.empty()) {
+		online.clear();
+		for (int c = 0; c < (int)std::max(1u, std::thread::hardware_concurrency()); ++c) {
+			online.push_back(c);
+		}
+	}
+	cpu_set_t allowed;
+	CPU_ZERO(&allowed);
+	const bool has_mask = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+
+	std::map<int, int> node_of;
+	std::vector<int> nodes;
+	if (readLine(root + "/node/online", line) && parseCpuList(line, nodes)) {
+		for (int n : nodes) {
+			std::vector<int> cpus;
+			if (!readLine(root + "/node/node" + std::to_string(n) + "/cpulist", line) || !parseCpuList(line, cpus))continue;
+			for (int c : cpus) {
+				node_of[c] = n;
+			}
+		}
+	}
+
+	std::map<std::tuple<int, int, int>, Core> cores;
+	for (int c : online) {
+		if (has_mask && (c >= CPU_SETSIZE || !CPU_ISSET(c, &allowed)))continue;
+		if (std::find(reserved.begin(), reserved.end(), c) != reserved.end())continue;
+		const std::string dir = root + "/cpu/cpu" + std::to_string(c) + "/topology/";
+		int package = 0, id = c;
+		if (readLine(dir + "physical_package_id", line))package = std::atoi(line.c_str());
+		if (readLine(dir + "core_id", line))id = std::atoi(line.c_str());
+		const auto it = node_of.find(c);
+		const int node = it == node_of.end() ? 0 : it->second;
+		auto &core = cores[std::make_tuple(node, package, id)];
+		core.node = node;
+		core.package = package;
+		core.id = id;
+		core.threads.push_back(c);
+	}
+	for (auto &kv : cores) {
+		std::sort(kv.second.threads.begin(), kv.second.threads.end());
+		if (m_nodes.empty() || m_nodes.back() != kv.second.node)m_nodes.push_back(kv.second.node);
+		m_cores.push_back(std::move(kv.second));
+	}
+}
+
+const std::vector<CpuTopology::Core> &CpuTopology::Cores() const
+{
+	return m_cores;
+}
+
+const std::vector<int> &CpuTopology::Nodes() const
+{
+	return m_nodes;
+}
+
+std::vector<int> CpuTopology::NodeCpus(int node) const
+{
+	std::vector<int> cpus;
+	for (const auto &core : m_cores) {
+		if (core.node == node)cpus.insert(cpus.end(), core.threads.begin(), core.threads.end());
+	}
+	std::sort(cpus.begin(), cpus.end());
+	return cpus;
+}
+
+std::string CpuTopology::Describe() const
+{
+	std::stringstream ss;
+	size_t threads = 0;
+	for (const auto &core : m_cores) {
+		threads += core.threads.size();
+	}
+	ss << m_nodes.size() << " nodes, " << m_cores.size() << " cores, " << threads << " threads";
+	for (int node : m_nodes) {
+		const auto cpus = NodeCpus(node);
+		ss << "; node " << node << ": " << cpus.size() << " cpus";
+	}
+	return ss.str();
+}
+
+bool parsePlacementPolicy(const std::string &name, PlacementPolicy &policy)
+{
+	std::string lower(name);
+	std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+	if (lower == "none") {
+		policy = PlacementPolicy::NONE;
+		return true;
+	}
+	if (lower == "compact") {
+		policy = PlacementPolicy::COMPACT;
+		return true;
+	}
+	if (lower == "spread") {
+		policy = PlacementPolicy::SPREAD;
+		return true;
+	}
+	return false;
+}
+
+std::mutex Placement::s_mtx;
+bool Placement::s_configured = false;
+PlacementOptions Placement::s_options;
+
+Placement &Placement::Instance()
+{
+	static Placement placement;
+	return placement;
+}
+
+bool Placement::Configure(const PlacementOptions &options)
+{
+	std::lock_guard<std::mutex> lock(s_mtx);
+	if (s_configured)return false;
+	s_options = options;
+	s_configured = true;
+	return true;
+}
+
+Placement::Placement()
+{
+	{
+		std::lock_guard<std::mutex> lock(s_mtx);
+		///@note later Configure() calls are ignored once the placement exists.
+		s_configured = true;
+		m_options = s_options;
+	}
+	if (m_options.policy == PlacementPolicy::NONE)return;
+	m_topology.Load("/sys/devices/system", m_options.reserved);
+	m_load.assign(m_topology.Cores().size(), 0);
+	m_streams.assign(m_topology.Nodes().size(), 0);
+	logStream(LogLevel::INFO) << "CPU topology: " << m_topology.Describe() << std::endl;
+}
+
+const PlacementOptions &Placement::Options() const
+{
+	return m_options;
+}
+
+const CpuTopology &Placement::Topology() const
+{
+	return m_topology;
+}
+
+bool Placement::Enabled() const
+{
+	return m_options.policy != PlacementPolicy::NONE && !m_topology.Cores().empty();
+}
+
+int Placement::LeastLoaded(int node, int exclude) const
+{
+	int best = -1;
+	const auto &cores = m_topology.Cores();
+	for (int i = 0; i < (int)cores.size(); ++i) {
+		if (cores[i].node != node || i == exclude)continue;
+		if (best < 0 || m_load[i] < m_load[best])best = i;
+	}
+	return best;
+}
+
+int Placement::NodeLoad(int node) const
+{
+	const int core = LeastLoaded(node, -1);
+	return core < 0 ? std::numeric_limits<int>::max() : m_load[core];
+}
+
+StreamPlacement Placement::Acquire(int preferred_node)
+{
+	StreamPlacement placement;
+	if (!Enabled())return placement;
+	std::lock_guard<std::mutex> lock(m_mtx);
+	const auto &nodes = m_topology.Nodes();
+	const auto &cores = m_topology.Cores();
+	int slot = -1;
+	if (m_options.gpu_local && preferred_node >= 0) {
+		const auto it = std::find(nodes.begin(), nodes.end(), preferred_node);
+		if (it != nodes.end())slot = (int)(it - nodes.begin());
+	}
+	if (slot < 0) {
+		for (int i = 0; i < (int)nodes.size(); ++i) {
+			if (slot < 0) {
+				slot = i;
+				continue;
+			}
+			if (m_options.policy == PlacementPolicy::SPREAD) {
+				if (m_streams[i] < m_streams[slot])slot = i;
+			}
+			else {
+				///@note compact takes the first node with a free core, else the least loaded one.
+				const int load = NodeLoad(nodes[i]), best = NodeLoad(nodes[slot]);
+				if (best > 0 && load < best)slot = i;
+			}
+		}
+	}
+	const int node = nodes[slot];
+	const int worker = LeastLoaded(node, -1);
+	m_load[worker]++;
+	placement.cores.push_back(worker);
+	placement.worker_cpu = cores[worker].threads[0];
+	if (m_options.smt && cores[worker].threads.size() > 1) {
+		placement.decode_cpu = cores[worker].threads[1];
+	}
+	else {
+		const int decode = LeastLoaded(node, worker);
+		if (decode < 0) {
+			placement.decode_cpu = placement.worker_cpu;
+		}
+		else {
+			m_load[decode]++;
+			placement.cores.push_back(decode);
+			placement.decode_cpu = cores[decode].threads[0];
+		}
+	}
+	m_streams[slot]++;
+	placement.node = node;
+	placement.node_cpus = m_topology.NodeCpus(node);
+	placement.placed = true;
+	return placement;
+}
+
+void Placement::Release(StreamPlacement &placement)
+{
+	if (!placement.placed)return;
+	std::lock_guard<std::mutex> lock(m_mtx);
+	for (auto core : placement.cores) {
+		if (core < m_load.size() && m_load[core] > 0)m_load[core]--;
+	}
+	const auto &nodes = m_topology.Nodes();
+	const auto it = std::find(nodes.begin(), nodes.end(), placement.node);
+	if (it != nodes.end() && m_streams[it - nodes.begin()] > 0)m_streams[it - nodes.begin()]--;
+	placement = StreamPlacement();
+}
+
+std::vector<std::vector<int>> Placement::PoolCpus() const
+{
+	std::vector<std::vector<int>> sets;
+	if (!Enabled())return sets;
+	for (int node : m_topology.Nodes()) {
+		sets.push_back(m_topology.NodeCpus(node));
+	}
+	return sets;
+}
+
+}
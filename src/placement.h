@@ -0,0 +1,203 @@
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <vector>
+#include <pthread.h>
+
+namespace helmet
+{
+/**
+ * @brief parse a sysfs CPU list, e.g. "0-3,8,10-11".
+ * @param text list text.
+ * @param cpus parsed ids in ascending order.
+ * @return false if the text is malformed.
+ */
+extern bool parseCpuList(const std::string &text, std::vector<int> &cpus);
+
+/**
+ * @brief pin a thread to a set of CPUs.
+ * @param thread native handle, i.e. pthread_self() or std::thread::native_handle().
+ * @param cpus CPU ids, nothing is done if empty.
+ * @return true if pinned.
+ */
+extern bool pinThread(pthread_t thread, const std::vector<int> &cpus);
+
+/**
+ * @brief get the NUMA node a PCI device, e.g. a GPU, is attached to.
+ * @param bus_id PCI bus id, e.g. "0000:3B:00.0" from cudaDeviceGetPCIBusId(), case insensitive.
+ * @return node id, -1 if unknown.
+ */
+extern int pciNumaNode(const std::string &bus_id);
+
+/**
+ * @brief prefer a NUMA node for the pages first touched by the calling thread from now on.
+ * @details MPOL_PREFERRED is used, so allocations still succeed from other nodes once the node is full.
+ * @param node node id.
+ * @return true if set, false if the kernel has no NUMA support.
+ */
+extern bool preferMemoryNode(int node);
+
+/**
+ * @brief CPU topology of the process, read from sysfs.
+ * @details only the CPUs online and in the affinity mask of the process are kept, so cores taken away by <!--
+ * --> taskset or a cpuset cgroup are never assigned. SMT siblings are grouped into physical cores.
+ */
+class CpuTopology final
+{
+public:
+	struct Core
+	{
+		int node = 0;
+		int package = 0;
+		int id = 0;///< core id within the package.
+		std::vector<int> threads;///< logical CPUs, SMT siblings, ascending.
+	};
+
+public:
+	/**
+	 * @brief read the topology.
+	 * @param root sysfs root of devices, falls back to one node of hardware concurrency cores if unreadable.
+	 * @param reserved CPUs excluded, e.g. used by other processes.
+	 */
+	void Load(const std::string &root = "/sys/devices/system", const std::vector<int> &reserved = {});
+
+	const std::vector<Core> &Cores() const;
+
+	/**
+	 * @brief get node ids in ascending order.
+	 */
+	const std::vector<int> &Nodes() const;
+
+	/**
+	 * @brief get all usable CPUs of a node.
+	 */
+	std::vector<int> NodeCpus(int node) const;
+
+	/**
+	 * @brief one line summary for logging.
+	 */
+	std::string Describe() const;
+
+private:
+	std::vector<Core> m_cores;///< ordered by node, package and core id.
+	std::vector<int> m_nodes;
+};
+
+/**
+ * @brief how streams are spread over the topology.
+ */
+enum class PlacementPolicy
+{
+	NONE = 0,///< threads are left to the scheduler.
+	COMPACT = 1,///< fill one node before the next, streams share the last level cache.
+	SPREAD = 2 ///< round robin over nodes, more memory bandwidth per stream.
+};
+
+/**
+ * @brief parse "none", "compact" or "spread", case insensitive.
+ * @return true if parsed.
+ */
+extern bool parsePlacementPolicy(const std::string &name, PlacementPolicy &policy);
+
+struct PlacementOptions
+{
+	PlacementPolicy policy = PlacementPolicy::NONE;
+	bool smt = true;///< the decode thread shares the physical core of the stream thread.
+	bool gpu_local = true;///< streams are placed on the node of their GPU.
+	bool bind_memory = true;///< buffers are first touched on the stream's node.
+	std::vector<int> reserved;///< CPUs never assigned.
+};
+
+/**
+ * @brief CPUs assigned to one stream.
+ */
+struct StreamPlacement
+{
+	bool placed = false;
+	int node = -1;
+	int worker_cpu = -1;///< stream thread calling Process_Algorithm.
+	int decode_cpu = -1;///< decode thread of the stream.
+	std::vector<int> node_cpus;///< node local CPUs, for threads not pinned to a core, e.g. encoding.
+	std::vector<size_t> cores;///< cores loaded by the stream, released on destruction.
+};
+
+/**
+ * @brief process wide placement of stream threads, decode threads and the shared pool.
+ * @details each stream gets the least loaded physical core of its node for its own thread, the decode <!--
+ * --> thread goes to the SMT sibling of that core, or the next least loaded core if SMT is off. The node <!--
+ * --> is the GPU's one if known, otherwise chosen by the policy. Pool workers are pinned per node, not per core, <!--
+ * --> so the scheduler still balances them within the node.
+ * @note the first caller of Configure() decides, like the shared pool.
+ * @example:
+ * @code
+ * 	Placement::Configure(options);
+ * 	auto slot = Placement::Instance().Acquire(gpu_node);
+ * 	pinThread(pthread_self(), {slot.worker_cpu});
+ * 	...
+ * 	Placement::Instance().Release(slot);
+ * @endcode
+ */
+class Placement final
+{
+public:
+	static Placement &Instance();
+
+	/**
+	 * @brief set options, ignored if already configured.
+	 * @return true if the options are taken.
+	 */
+	static bool Configure(const PlacementOptions &options);
+
+	Placement(const Placement &) = delete;
+	Placement &operator=(const Placement &) = delete;
+
+	const PlacementOptions &Options() const;
+
+	const CpuTopology &Topology() const;
+
+	bool Enabled() const;
+
+	/**
+	 * @brief assign CPUs to a new stream.
+	 * @param preferred_node node of the stream's GPU, -1 if unknown.
+	 * @return placement, placed is false if the policy is NONE.
+	 */
+	StreamPlacement Acquire(int preferred_node);
+
+	/**
+	 * @brief give back the cores of a stream.
+	 */
+	void Release(StreamPlacement &placement);
+
+	/**
+	 * @brief get CPU sets for the pool workers, one set per node, empty if disabled.
+	 */
+	std::vector<std::vector<int>> PoolCpus() const;
+
+private:
+	Placement();
+
+	/**
+	 * @brief least loaded core of a node, excluding one core.
+	 * @return core index, -1 if none.
+	 */
+	int LeastLoaded(int node, int exclude) const;
+
+	/**
+	 * @brief load of the least loaded core of a node.
+	 */
+	int NodeLoad(int node) const;
+
+private:
+	PlacementOptions m_options;
+	CpuTopology m_topology;
+	std::vector<int> m_load;///< streams' threads per core.
+	std::vector<int> m_streams;///< streams per node, indexed like Nodes().
+	mutable std::mutex m_mtx;
+	static std::mutex s_mtx;
+	static bool s_configured;
+	static PlacementOptions s_options;
+};
+
+}
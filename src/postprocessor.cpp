@@ -2,43 +2,126 @@
 #include <opencv2/freetype.hpp>
 #include "postprocessor.h"
 #include "config.h"
+#include "latency_stats.h"
+#include "log.h"
 #include <cmath>
 
 namespace helmet
 {
 
+HelmetDetectionPost::HelmetDetectionPost(SharedRef<Config> &config)
+	: PostprocessorOps(config)
+{
+	m_host_nms = config->NMS_MODE == "host";
+	if (m_host_nms && !parseRawFormat(config->RAW_FORMAT, m_raw_format)) {
+		logStream(LogLevel::ERROR) << "Unknown raw format: " << config->RAW_FORMAT << ", using yolov5." << std::endl;
+	}
+	else if (!m_host_nms && config->NMS_MODE != "model") {
+		logStream(LogLevel::WARNING) << "Unknown nms mode: " << config->NMS_MODE << ", using model." << std::endl;
+	}
+	if (!parseAlarmMode(config->ALARM_MODE, m_alarm_mode)) {
+		logStream(LogLevel::WARNING) << "Unknown alarm mode: " << config->ALARM_MODE << ", using count." << std::endl;
+	}
+	m_grid_cols = std::max(1, config->ALARM_GRID.size() > 0 ? config->ALARM_GRID[0] : 1);
+	m_grid_rows = std::max(1, config->ALARM_GRID.size() > 1 ? config->ALARM_GRID[1] : 1);
+	if (!parseSmoothMethod(config->SMOOTH_METHOD, m_smooth)) {
+		logStream(LogLevel::WARNING) << "Unknown smooth method: " << config->SMOOTH_METHOD << ", using none." << std::endl;
+	}
+	if (m_smooth != SmoothMethod::NONE) {
+		m_moving_average.Configure((size_t)(m_grid_cols * m_grid_rows), (size_t)std::max(1, config->SMOOTH_WINDOW),
+								   (int64_t)config->SMOOTH_TAU_MS * 1000);
+	}
+	if (m_alarm_mode == AlarmMode::TIME) {
+		AlarmParams params;
+		params.window_us = (int64_t)config->ALARM_WINDOW_MS * 1000;
+		params.on_ratio = config->ALARM_ON_RATIO;
+		params.off_ratio = std::min(config->ALARM_OFF_RATIO, config->ALARM_ON_RATIO);
+		params.min_evidence = std::max(1, config->ALARM_MIN_EVIDENCE);
+		params.cooldown_us = (int64_t)config->ALARM_COOLDOWN_MS * 1000;
+		m_alarm.Configure(params, m_grid_cols, m_grid_rows, (size_t)std::max(1, config->ALARM_WINDOW_CAPACITY));
+	}
+}
+
 void HelmetDetectionPost::Run(const SharedRef<TrtResults> &res, cv::Mat &img,int &alarm)
 {
 	//our simple program will only draw letters on top of images.
 //	auto flag = static_cast<PostProcessFlag>(m_config->POST_MODE);
 //	assert(flag == PostProcessFlag::DRAW_BOX_LETTER);
 	alarm = 0;
+	{
+		StageTimer timer(Stage::DECODE_RESULTS);
+		if (!Decode(res, img.size()))return;
+		UpdateAlarm(res, img.size(), alarm);
+	}
+	StageTimer timer(Stage::DRAW);
+	Draw(img);
+}
 
-	std::vector<float> dets;
-	std::vector<float> num_dets;
-	res->Get(m_config->OUTPUT_NAMES[0], dets);
-	res->Get(m_config->OUTPUT_NAMES[1], num_dets);
-
-	float scale_x = (float)img.cols / (float)m_config->TARGET_SIZE[1];
-	float scale_y = (float)img.rows / (float)m_config->TARGET_SIZE[0];
-
-	std::vector<Box> curr;
-	for (int j = 0; j < 100; ++j) {
-		Box b;
-		b.class_id = round2int(dets[0+j*6]);
-		b.score = dets[1+j*6];
-		b.x_min = (int)(dets[2+j*6] * scale_x);
-		b.y_min = (int)(dets[3+j*6] * scale_y);
-		b.x_max = (int)(dets[4+j*6] * scale_x);
-		b.y_max = (int)(dets[5+j*6] * scale_y);
-		curr.push_back(b);
-	}
-	auto b = curr;
-	bool ff = false;
+void HelmetDetectionPost::Run(const SharedRef<TrtResults> &res, const cv::Size &frame, int &alarm)
+{
+	alarm = 0;
+	StageTimer timer(Stage::DECODE_RESULTS);
+	if (!Decode(res, frame))return;
+	UpdateAlarm(res, frame, alarm);
+}
+
+bool HelmetDetectionPost::Decode(const SharedRef<TrtResults> &res, const cv::Size &frame)
+{
+	const int num = 100;
+	///@note no stale boxes are reported if the results are not available.
+	m_boxes.clear();
+	if (m_host_nms) {
+		///@note the raw head is decoded and suppressed into the same rows as multiclass_nms3 outputs.
+		res->Get(m_config->OUTPUT_NAMES[0], m_raw);
+		if (m_raw.empty())return false;
+		NmsParams params;
+		params.score_threshold = m_score_threshold;
+		params.iou_threshold = m_config->IOU_THRESHOLD;
+		params.pre_top_k = m_config->NMS_PRE_TOP_K;
+		params.top_k = std::min(m_config->NMS_TOP_K, num);
+		m_nms.Decode(m_raw.data(), m_raw.size(), m_raw_format, m_config->NUM_CLASSES, m_score_threshold, m_candidates);
+		m_nms.Run(m_candidates, params, num, m_dets);
+	}
+	else {
+		res->Get(m_config->OUTPUT_NAMES[0], m_dets);
+		res->Get(m_config->OUTPUT_NAMES[1], m_num_dets);
+		///@note a data dependent output holds only the kept rows, padded like a fixed size one.
+		if (!m_num_dets.empty() && m_dets.size() < num * 6) {
+			const size_t rows = m_dets.size() / 6;
+			m_dets.resize(num * 6, 0.0f);
+			for (size_t j = rows; j < num; ++j) {
+				m_dets[j * 6] = -1.0f;
+			}
+		}
+	}
+	if (m_dets.size() < num * 6)return false;
+
+	///@note the input size may change at runtime, boxes are scaled back from the size they were inferred at.
+	cv::Size input = res->InputSize();
+	if (input.empty())input = cv::Size(m_config->TARGET_SIZE[1], m_config->TARGET_SIZE[0]);
+	float scale_x = (float)frame.width / (float)input.width;
+	float scale_y = (float)frame.height / (float)input.height;
+
+	m_boxes.resize(num);
+	for (int j = 0; j < num; ++j) {
+		Box &b = m_boxes[j];
+		b.class_id = round2int(m_dets[0+j*6]);
+		b.score = m_dets[1+j*6];
+		b.x_min = (int)(m_dets[2+j*6] * scale_x);
+		b.y_min = (int)(m_dets[3+j*6] * scale_y);
+		b.x_max = (int)(m_dets[4+j*6] * scale_x);
+		b.y_max = (int)(m_dets[5+j*6] * scale_y);
+	}
+	return true;
+}
+
+void HelmetDetectionPost::Draw(cv::Mat &img)
+{
+	auto &b = m_boxes;
 	///@note the putText method does not have GPU version since it quite slow running on GPU for per pixel ops.
 	for (int k = 0; k < b.size(); ++k) {
 		if(b[k].class_id>1)continue;
-		if (b[k].score > m_config->SCORE_THRESHOLD) {
+		if (b[k].score > m_score_threshold) {
 			std::vector<unsigned char> box_color;
 			box_color.resize(3);
 			std::vector<unsigned char> text_color;
@@ -58,22 +141,82 @@ void HelmetDetectionPost::Run(const SharedRef<TrtResults> &res, cv::Mat &img,int
 			float percent = 100 * b[k].score;
 //			text << m_config->POST_TEXT[b[k].class_id] << ": " << std::fixed<<std::setprecision(3)<<percent << "%";
 			const int line_type = 8;
-			m_font->putText(img,m_config->POST_TEXT[b[k].class_id],cv::Point(b[k].x_min, b[k].y_min-m_config->TEXT_FONT_SIZE-10),
-							m_config->TEXT_FONT_SIZE,cv::Scalar(text_color[0], text_color[1], text_color[2]),
-							(int)m_config->TEXT_LINE_WIDTH,line_type,false);
+			if (m_font->loaded) {
+				m_font->Local().putText(img,m_config->POST_TEXT[b[k].class_id],cv::Point(b[k].x_min, b[k].y_min-m_config->TEXT_FONT_SIZE-10),
+								m_config->TEXT_FONT_SIZE,cv::Scalar(text_color[0], text_color[1], text_color[2]),
+								(int)m_config->TEXT_LINE_WIDTH,line_type,false);
+			}
 //			m_font->putText(img, text.str(),
 //						cv::Point(b[k].x_min, b[k].y_min-m_config->TEXT_FONT_SIZE-10),
 //						cv::FONT_HERSHEY_PLAIN, m_config->TEXT_FONT_SIZE,
 //						cv::Scalar(text_color[0], text_color[1], text_color[2]),
 //						(int)m_config->TEXT_LINE_WIDTH);
-			if(b[k].class_id==m_config->TARGET_CLASS){
-				m_latency+=2;
-				if(m_latency>2*m_config->ALARM_COUNT){
-					alarm = 1;
-					m_latency = 0;
+		}
+	}
+}
+
+bool HelmetDetectionPost::IsTarget(const Box &b) const
+{
+	return b.class_id <= 1 && b.score > m_score_threshold && b.class_id == m_config->TARGET_CLASS;
+}
+
+void HelmetDetectionPost::Smooth(const cv::Size &frame, int64_t time_us)
+{
+	m_moving_average.Begin();
+	for (const auto &box : m_boxes) {
+		if (!IsTarget(box))continue;
+		m_moving_average.Add(gridCell((box.x_min + box.x_max) / 2, (box.y_min + box.y_max) / 2,
+									  frame.width, frame.height, m_grid_cols, m_grid_rows), box.score);
+	}
+	m_moving_average.Commit(time_us);
+}
+
+bool HelmetDetectionPost::IsSmoothedTarget(int cell) const
+{
+	if (m_smooth == SmoothMethod::NONE)return true;
+	return m_moving_average.Score(cell, m_smooth) >= m_config->SMOOTH_THRESHOLD;
+}
+
+void HelmetDetectionPost::UpdateAlarm(const SharedRef<TrtResults> &res, const cv::Size &frame, int &alarm)
+{
+	auto &b = m_boxes;
+	///@note results reused for skipped frames are not evidence again, only the clock advances.
+	const bool fresh = res->Sequence() != m_sequence;
+	m_sequence = res->Sequence();
+	if (fresh && m_smooth != SmoothMethod::NONE)Smooth(frame, res->Time());
+	auto cellOf = [&](const Box &box) {
+		return gridCell((box.x_min + box.x_max) / 2, (box.y_min + box.y_max) / 2,
+						frame.width, frame.height, m_grid_cols, m_grid_rows);
+	};
+	if (m_alarm_mode == AlarmMode::TIME) {
+		if (fresh) {
+			m_alarm.Begin();
+			if (m_smooth != SmoothMethod::NONE) {
+				///@note a smoothed cell stays marked through single missed detections.
+				for (int c = 0; c < (int)m_alarm.Cells(); ++c) {
+					if (IsSmoothedTarget(c))m_alarm.Mark(c);
 				}
-				ff = true;
 			}
+			else {
+				for (const auto &box : b) {
+					if (IsTarget(box))m_alarm.Mark(cellOf(box));
+				}
+			}
+			m_alarm.Commit(res->Time());
+		}
+		const int64_t now = steadyMicros();
+		alarm = m_alarm.Evaluate(std::max(now, res->Time())) ? 1 : 0;
+		return;
+	}
+	bool ff = false;
+	for (int k = 0; k < b.size(); ++k) {
+		if (IsTarget(b[k]) && IsSmoothedTarget(cellOf(b[k]))) {
+			m_latency+=2;
+			if(m_latency>2*m_alarm_count){
+				alarm = 1;
+				m_latency = 0;
+			}
+			ff = true;
 		}
 	}
 	if(!ff){
@@ -82,6 +225,14 @@ void HelmetDetectionPost::Run(const SharedRef<TrtResults> &res, cv::Mat &img,int
 	if(m_latency<0)m_latency=0;
 }
 
+void HelmetDetectionPost::Detections(std::vector<Box> &dets) const
+{
+	dets.clear();
+	for (const auto &b : m_boxes) {
+		if (b.class_id >= 0 && b.score > m_score_threshold)dets.push_back(b);
+	}
+}
+
 void Postprocessor::Init()
 {
 //	if (!m_ops) {
@@ -89,6 +240,14 @@ void Postprocessor::Init()
 //	}
 //	m_ops->registerType<HelmetDetectionPost>(m_config->POSTPROCESS_NAME);
 	m_worker = new HelmetDetectionPost(m_config);
+	m_worker->SetThresholds(m_score_threshold, m_alarm_count);
+}
+
+void Postprocessor::SetThresholds(float score_threshold, int alarm_count)
+{
+	m_score_threshold = score_threshold;
+	m_alarm_count = alarm_count;
+	if (m_worker)m_worker->SetThresholds(score_threshold, alarm_count);
 }
 
 void Postprocessor::Run(const SharedRef<TrtResults> &res, cv::Mat &img,int &alarm)
@@ -100,6 +259,24 @@ void Postprocessor::Run(const SharedRef<TrtResults> &res, cv::Mat &img,int &alar
 	m_worker->Run(res, img,alarm);
 }
 
+void Postprocessor::Run(const SharedRef<TrtResults> &res, const cv::Size &frame, int &alarm)
+{
+	if (!INIT_FLAG) {
+		Init();
+		INIT_FLAG = true;
+	}
+	m_worker->Run(res, frame, alarm);
+}
+
+void Postprocessor::Detections(std::vector<Box> &dets) const
+{
+	if (!m_worker) {
+		dets.clear();
+		return;
+	}
+	m_worker->Detections(dets);
+}
+
 Postprocessor::~Postprocessor()
 {
 //	if (m_ops) {
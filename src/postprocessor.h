@@ -4,6 +4,10 @@
 #include <vector>
 #include <opencv2/freetype.hpp>
 #include "trt_deployresult.h"
+#include "resource_cache.h"
+#include "nms.h"
+#include "alarm_engine.h"
+#include "score_smoother.h"
 #include "util.h"
 
 namespace helmet
@@ -25,10 +29,10 @@ class PostprocessorOps
 public:
 	explicit PostprocessorOps(SharedRef<Config>& config){
 		m_config = config;
-		m_font = cv::freetype::createFreeType2();
-		if(!checkFileExist(config->POST_TEXT_FONT_FILE))
-			std::cerr<<"Font file not found!"<<std::endl;
-		else m_font->loadFontData(config->POST_TEXT_FONT_FILE,0);
+		///@note the font is loaded once per process and shared by all instances.
+		m_font = ResourceCache::Instance().AcquireFont(config->POST_TEXT_FONT_FILE);
+		m_score_threshold = config->SCORE_THRESHOLD;
+		m_alarm_count = config->ALARM_COUNT;
 	}
 	/**
 	 * @brief virtual de-constructor for avoiding memory leaking.
@@ -51,10 +55,34 @@ public:
 	 * @param out_img output images.
 	 */
 	virtual void Run(const SharedRef<TrtResults> &res, cv::Mat &img,int &alarm) = 0;
+	/**
+	 * @brief alarm only interface, nothing is drawn.
+	 * @param res inference results.
+	 * @param frame size of the raw image the results refer to.
+	 * @param alarm output alarm.
+	 */
+	virtual void Run(const SharedRef<TrtResults> &res, const cv::Size &frame,int &alarm) = 0;
+	/**
+	 * @brief get the valid boxes of the latest run, in raw image coordinates.
+	 * @param dets output boxes above the score threshold.
+	 */
+	virtual void Detections(std::vector<Box> &dets) const = 0;
+	/**
+	 * @brief update the thresholds which can be changed at runtime.
+	 * @param score_threshold minimal score of a valid box.
+	 * @param alarm_count accumulated count to raise an alarm.
+	 */
+	void SetThresholds(float score_threshold, int alarm_count)
+	{
+		m_score_threshold = score_threshold;
+		m_alarm_count = alarm_count;
+	}
 
 protected:
 	SharedRef<Config> m_config = nullptr;
-	cv::Ptr<cv::freetype::FreeType2> m_font = nullptr;
+	float m_score_threshold = 0.6f;///< runtime copy of SCORE_THRESHOLD.
+	int m_alarm_count = 5;///< runtime copy of ALARM_COUNT.
+	SharedRef<SharedFont> m_font = nullptr;
 };
 
 /**
@@ -65,11 +93,61 @@ protected:
 class HelmetDetectionPost final: public PostprocessorOps
 {
 public:
-	explicit HelmetDetectionPost(SharedRef<Config>& config): PostprocessorOps(config){};
+	explicit HelmetDetectionPost(SharedRef<Config>& config);
 	void Run(const SharedRef<TrtResults> &res, cv::Mat &img,int &alarm) override;
+	void Run(const SharedRef<TrtResults> &res, const cv::Size &frame,int &alarm) override;
+	void Detections(std::vector<Box> &dets) const override;
+private:
+	/**
+	 * @brief decode the model output into m_boxes, coordinates are scaled to the raw image.
+	 * @param res inference results.
+	 * @param frame size of the raw image.
+	 * @return false if the results are not available.
+	 */
+	bool Decode(const SharedRef<TrtResults> &res, const cv::Size &frame);
+	/**
+	 * @brief draw the decoded boxes.
+	 * @param img raw image.
+	 */
+	void Draw(cv::Mat &img);
+	/**
+	 * @brief accumulate the alarm state from decoded boxes.
+	 * @param res inference results, their stamp tells fresh ones from reused ones.
+	 * @param frame size of the raw image.
+	 * @param alarm output alarm.
+	 */
+	void UpdateAlarm(const SharedRef<TrtResults> &res, const cv::Size &frame, int &alarm);
+	/**
+	 * @brief check whether a decoded box is a valid target.
+	 */
+	bool IsTarget(const Box &b) const;
+	/**
+	 * @brief add the target scores of fresh results to the smoother.
+	 * @param frame size of the raw image.
+	 * @param time_us time of the inference.
+	 */
+	void Smooth(const cv::Size &frame, int64_t time_us);
+	/**
+	 * @brief check whether the smoothed score of a cell passes SMOOTH_THRESHOLD, always true without smoothing.
+	 */
+	bool IsSmoothedTarget(int cell) const;
 private:
-    std::vector<float> m_moving_average;///< moving average.
+    ScoreSmoother m_moving_average;///< smoothed target scores per ALARM_GRID cell.
+	std::vector<float> m_dets;
+	std::vector<float> m_num_dets;
+	std::vector<Box> m_boxes;///< decoded boxes of the latest results.
     int m_latency = 0;
+	bool m_host_nms = false;///< the model outputs raw heads, NMS_MODE is "host".
+	RawFormat m_raw_format = RawFormat::YOLOV5;
+	HostNms m_nms;
+	std::vector<float> m_raw;///< raw head output for host NMS.
+	BoxesSoA m_candidates;
+	AlarmMode m_alarm_mode = AlarmMode::COUNT;
+	AlarmEngine m_alarm;///< time mode only.
+	uint64_t m_sequence = 0;///< stamp of the latest results added to m_alarm and m_moving_average.
+	SmoothMethod m_smooth = SmoothMethod::NONE;
+	int m_grid_cols = 1;
+	int m_grid_rows = 1;
 };
 
 /**
@@ -79,7 +157,11 @@ private:
 class Postprocessor final
 {
 public:
-	explicit Postprocessor(SharedRef<Config>& config){m_config = config;}
+	explicit Postprocessor(SharedRef<Config>& config){
+		m_config = config;
+		m_score_threshold = config->SCORE_THRESHOLD;
+		m_alarm_count = config->ALARM_COUNT;
+	}
 	/**
  	* @brief de-constructor.
  	*/
@@ -92,6 +174,24 @@ public:
 	 * @note the work is done using CPU computation, not GPU.
 	 */
 	void Run(const SharedRef<TrtResults> &res, cv::Mat &img,int& alarm);
+	/**
+	 * @brief invoking working function without drawing.
+	 * @param res inference results.
+	 * @param frame size of raw images.
+	 * @param alarm output alarm.
+	 */
+	void Run(const SharedRef<TrtResults> &res, const cv::Size &frame,int& alarm);
+	/**
+	 * @brief get the valid boxes of the latest run.
+	 * @param dets output boxes, empty before the first run.
+	 */
+	void Detections(std::vector<Box> &dets) const;
+	/**
+	 * @brief update the thresholds which can be changed at runtime.
+	 * @param score_threshold minimal score of a valid box.
+	 * @param alarm_count accumulated count to raise an alarm.
+	 */
+	void SetThresholds(float score_threshold, int alarm_count);
 	/**
 	 * @brief initialization of this class, mainly to register the used worker class.
 	 */
@@ -102,5 +202,7 @@ private:
 	PostprocessorOps* m_worker = nullptr;///< real worker.
 	bool INIT_FLAG = false; ///< initialization flag.
 	SharedRef<Config> m_config = nullptr;
+	float m_score_threshold = 0.6f;
+	int m_alarm_count = 5;
 };
 }
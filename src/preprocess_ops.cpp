@@ -8,6 +8,10 @@ namespace helmet
 
 void NormalizeImage::Run(std::vector<cv::cuda::GpuMat> &data)
 {
+	if (m_mul.size() != data[0].size()) {
+		m_mul = cv::cuda::GpuMat(data[0].size(), CV_32FC3, m_coe);
+		m_subtract = cv::cuda::GpuMat(data[0].size(), CV_32FC3, m_off);
+	}
 	NormalizeImageOnGpu(data.data(), *m_stream, data.size(),
 						m_mul, m_subtract);
 }
@@ -16,20 +20,14 @@ NormalizeImage::NormalizeImage(SharedRef<Config> &config,SharedRef<cv::cuda::Str
 {
 	m_config = config;
 	assert(m_config->N_STD[0]>0&&m_config->N_STD[1]>0&&m_config->N_STD[2]>0);
-	const auto ori_w = m_config->TARGET_SIZE[1];
-	const auto ori_h = m_config->TARGET_SIZE[0];
 	// normalization constant, should be 1.0/255.0;
 	const auto normalizer = 0.00392157f;
-	const float coe_1 = normalizer / m_config->N_STD[0];
-	const float coe_2 = normalizer / m_config->N_STD[1];
-	const float coe_3 = normalizer / m_config->N_STD[2];
-	const float off_1 = -m_config->N_MEAN[0] / m_config->N_STD[0];
-	const float off_2 = -m_config->N_MEAN[1] / m_config->N_STD[1];
-	const float off_3 = -m_config->N_MEAN[2] / m_config->N_STD[2];
-	m_mul = cv::cuda::GpuMat(ori_h, ori_w, CV_32FC3,
-								  cv::Scalar(coe_1, coe_2, coe_3));
-	m_subtract = cv::cuda::GpuMat(ori_h, ori_w, CV_32FC3,
-									   cv::Scalar(off_1, off_2, off_3));
+	m_coe = cv::Scalar(normalizer / m_config->N_STD[0], normalizer / m_config->N_STD[1],
+					   normalizer / m_config->N_STD[2]);
+	m_off = cv::Scalar(-m_config->N_MEAN[0] / m_config->N_STD[0], -m_config->N_MEAN[1] / m_config->N_STD[1],
+					   -m_config->N_MEAN[2] / m_config->N_STD[2]);
+	m_mul = cv::cuda::GpuMat(m_target, CV_32FC3, m_coe);
+	m_subtract = cv::cuda::GpuMat(m_target, CV_32FC3, m_off);
 }
 
 void Permute::Run(std::vector<cv::cuda::GpuMat> &data)
@@ -57,10 +55,8 @@ std::pair<float, float> Resize::GenerateScale(const cv::cuda::GpuMat &im)
 	if (m_config->KEEP_RATIO) {
 		int im_size_max = std::max(origin_w, origin_h);
 		int im_size_min = std::min(origin_w, origin_h);
-		int target_size_max =
-			*std::max_element(m_config->TARGET_SIZE.begin(), m_config->TARGET_SIZE.end());
-		int target_size_min =
-			*std::min_element(m_config->TARGET_SIZE.begin(), m_config->TARGET_SIZE.end());
+		int target_size_max = std::max(m_target.width, m_target.height);
+		int target_size_min = std::min(m_target.width, m_target.height);
 		float scale_min =
 			static_cast<float>(target_size_min) / static_cast<float>(im_size_min);
 		float scale_max =
@@ -71,10 +67,10 @@ std::pair<float, float> Resize::GenerateScale(const cv::cuda::GpuMat &im)
 	else {
 		//always [H,W] order.
 		resize_scale.first =
-			static_cast<float>(m_config->TARGET_SIZE[0]) / static_cast<float>(origin_h);
+			static_cast<float>(m_target.height) / static_cast<float>(origin_h);
 
 		resize_scale.second =
-			static_cast<float>(m_config->TARGET_SIZE[1]) / static_cast<float>(origin_w);
+			static_cast<float>(m_target.width) / static_cast<float>(origin_w);
 
 	}
 
@@ -87,8 +83,8 @@ void LetterBoxResize::Run(std::vector<cv::cuda::GpuMat> &data)
 	auto new_shape_w = (int)std::round((float)data[0].cols * resize_scale);
 	auto new_shape_h = (int)std::round((float)data[0].rows * resize_scale);
 
-	auto pad_w = (float)(m_config->TARGET_SIZE[1] - new_shape_w) / 2.0f;
-	auto pad_h = (float)(m_config->TARGET_SIZE[0] - new_shape_h) / 2.0f;
+	auto pad_w = (float)(m_target.width - new_shape_w) / 2.0f;
+	auto pad_h = (float)(m_target.height - new_shape_h) / 2.0f;
 
 	int top = (int)std::round(pad_h - 0.1);
 	int bottom = (int)std::round(pad_h + 0.1);
@@ -110,8 +106,8 @@ float LetterBoxResize::GenerateScale(const cv::cuda::GpuMat &im)
 	int origin_w = im.cols;
 	int origin_h = im.rows;
 
-	int target_h = m_config->TARGET_SIZE[0];
-	int target_w = m_config->TARGET_SIZE[1];
+	int target_h = m_target.height;
+	int target_w = m_target.width;
 
 	float ratio_h = static_cast<float>(target_h) / static_cast<float>(origin_h);
 	float ratio_w = static_cast<float>(target_w) / static_cast<float>(origin_w);
@@ -18,6 +18,7 @@ namespace helmet {
 		explicit PreprocessOp(SharedRef<Config> &config,SharedRef<cv::cuda::Stream>& stream){
 			m_config = config;
             m_stream = stream;
+			m_target = cv::Size(config->TARGET_SIZE[1], config->TARGET_SIZE[0]);
 		}
 		virtual ~PreprocessOp() = default;
 		/**
@@ -26,10 +27,18 @@ namespace helmet {
 		 * @param num number of images.
 		 */
         virtual void Run(std::vector<cv::cuda::GpuMat> &data) = 0;
+		/**
+		 * @brief set the network input size of the next runs, TARGET_SIZE of the config initially.
+		 */
+		void SetTargetSize(const cv::Size &target)
+		{
+			m_target = target;
+		}
 
     protected:
         SharedRef<cv::cuda::Stream> m_stream = nullptr;///< for parallel purpose.
         SharedRef<Config> m_config = nullptr;
+		cv::Size m_target;///< network input size, changed at runtime instead of the read only config.
     };
 
 	/**
@@ -46,8 +55,10 @@ namespace helmet {
 		 */
         void Run(std::vector<cv::cuda::GpuMat> &data) override;
 	private:
-		cv::cuda::GpuMat m_mul;
+		cv::cuda::GpuMat m_mul;///< sized like the images, rebuilt when the input size changes.
 		cv::cuda::GpuMat m_subtract;
+		cv::Scalar m_coe;
+		cv::Scalar m_off;
     };
 	/**
 	 * @brief do nothing, yeah yeah i know it is silly, this class is kept only to make somebody happy, --!>
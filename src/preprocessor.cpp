@@ -1,6 +1,9 @@
+#include <algorithm>
 #include <thread>
 #include "preprocess_util.hpp"
 #include "preprocessor.h"
+#include "work_pool.h"
+#include "log.h"
 
 namespace helmet
 {
@@ -28,63 +31,205 @@ PreprocessorFactory::PreprocessorFactory(SharedRef<Config> &config, SharedRef<cv
 		m_stream = stream;
 		m_cuda_stream = static_cast<cudaStream_t>(m_stream->cudaPtr());
 	}
+	m_plans = createUniqueRef<PlanCache>(m_config->PLAN_CACHE_SIZE);
+	m_target = cv::Size(m_config->TARGET_SIZE[1], m_config->TARGET_SIZE[0]);
 }
 
-void PreprocessorFactory::CvtForGpuMat(const std::vector<cv::Mat> &input,
-									   std::vector<cv::cuda::GpuMat> &frames, int &num)
+void PreprocessorFactory::CvtForGpuMat(PreprocessPlan &plan, int &num)
 {
-
-	num = (int)input.size();
+	num = (int)plan.input.size();
 	for (int i = 0; i < num; ++i) {
-		frames[i].upload(input[i], *m_stream);
-		frames[i].convertTo(frames[i], cv::COLOR_BGR2RGB, *m_stream);
-		frames[i].convertTo(frames[i], CV_32FC3, 1.0, 0.0, *m_stream);
+		///@note both buffers are allocated with the plan, neither upload nor convertTo reallocates.
+		plan.staging[i].upload(plan.input[i], *m_stream);
+		plan.staging[i].convertTo(plan.converted[i], CV_32FC3, 1.0, 0.0, *m_stream);
+		plan.gpu_data[i] = plan.converted[i];
 	}
 }
 
+PreprocessPlan::~PreprocessPlan()
+{
+	for (auto &i : device_ptr) {
+		cudaFree(i);
+	}
+	for (auto &i : paged_ptr) {
+		cudaFreeHost(i);
+	}
+}
+
+PlanCache::PlanCache(size_t capacity)
+{
+	m_capacity = std::max<size_t>(capacity, 1);
+	m_stats.capacity = m_capacity;
+}
+
+PreprocessPlan *PlanCache::Find(const PlanKey &key)
+{
+	if (m_last >= m_plans.size() || !(m_plans[m_last].first == key)) {
+		m_last = m_plans.size();
+		for (size_t i = 0; i < m_plans.size(); ++i) {
+			if (m_plans[i].first == key) {
+				m_last = i;
+				break;
+			}
+		}
+		if (m_last == m_plans.size())return nullptr;
+	}
+	m_stats.hits++;
+	auto *plan = m_plans[m_last].second.get();
+	plan->last_used = ++m_tick;
+	return plan;
+}
+
+bool PlanCache::Full() const
+{
+	return m_plans.size() >= m_capacity;
+}
+
+PreprocessPlan &PlanCache::Insert(const PlanKey &key, UniqueRef<PreprocessPlan> plan)
+{
+	m_stats.misses++;
+	plan->last_used = ++m_tick;
+	if (Full()) {
+		size_t oldest = 0;
+		for (size_t i = 1; i < m_plans.size(); ++i) {
+			if (m_plans[i].second->last_used < m_plans[oldest].second->last_used)oldest = i;
+		}
+		m_plans[oldest] = std::make_pair(key, std::move(plan));
+		m_last = oldest;
+		m_stats.evictions++;
+	}
+	else {
+		m_plans.emplace_back(key, std::move(plan));
+		m_last = m_plans.size() - 1;
+	}
+	m_stats.size = m_plans.size();
+	return *m_plans[m_last].second;
+}
+
+PlanCacheStats PlanCache::Stats() const
+{
+	return m_stats;
+}
+
+void PreprocessorFactory::Allocate(PreprocessPlan &plan, const cv::Size &size, int type, size_t num)
+{
+	auto ss = (size_t)size.area() * CV_ELEM_SIZE(type);
+	plan.device_ptr.resize(num, nullptr);
+	plan.staging.resize(num);
+	for (size_t i = 0; i < num; i++) {
+		cudaMalloc(&plan.device_ptr[i], ss);
+		plan.staging[i] = cv::cuda::GpuMat(size.height, size.width, type, plan.device_ptr[i]);
+	}
+	plan.converted.resize(num);
+	for (size_t i = 0; i < num; i++) {
+		plan.converted[i].create(size, CV_MAKETYPE(CV_32F, CV_MAT_CN(type)));
+	}
+	plan.gpu_data.resize(num);
+	plan.paged_ptr.resize(num, nullptr);
+	plan.input.resize(num);
+	for (size_t i = 0; i < num; i++) {
+		cudaMallocHost(&plan.paged_ptr[i], ss);
+		plan.input[i] = cv::Mat(size, type, plan.paged_ptr[i]);
+	}
+}
+
+PreprocessPlan &PreprocessorFactory::AcquirePlan(const std::vector<cv::Mat> &input, PixelFormat format)
+{
+	const PlanKey key{input[0].cols, input[0].rows, input[0].type(), (int)input.size(), m_target.width,
+					  m_target.height};
+	auto *cached = m_plans->Find(key);
+	if (cached)return *cached;
+
+	auto plan = createUniqueRef<PreprocessPlan>();
+	auto picture = getPictureSize(input[0], format);
+	plan->picture = picture;
+	if (m_config->INPUT_SHAPE[m_config->INPUT_SHAPE.size() - 1] != picture.width) {
+		plan->scale_w = (float)m_target.width / (float)picture.width;
+		logStream(LogLevel::WARNING) << "Input shape width in config file is not same as data width..." << std::endl;
+	}
+	if (m_config->INPUT_SHAPE[m_config->INPUT_SHAPE.size() - 2] != picture.height) {
+		plan->scale_h = (float)m_target.height / (float)picture.height;
+		logStream(LogLevel::WARNING) << "Input shape height in config file is not same as data height..." << std::endl;
+	}
+	///@note YUV frames are converted and downscaled to train size on host, only the small image is uploaded.
+	if (format == PixelFormat::BGR) {
+		Allocate(*plan, input[0].size(), input[0].type(), input.size());
+	}
+	else {
+		Allocate(*plan, cv::Size(m_config->TRAIN_SIZE[1], m_config->TRAIN_SIZE[0]), CV_8UC3, input.size());
+	}
+	if (m_plans->Full()) {
+		///@note the evicted buffers may still be referenced by queued work.
+		m_stream->waitForCompletion();
+	}
+	auto &inserted = m_plans->Insert(key, std::move(plan));
+	auto stats = m_plans->Stats();
+	logStream(LogLevel::INFO) << "Preprocessing plan built for " << picture.width << "x" << picture.height
+							  << ", plans cached: " << stats.size << ", evicted: " << stats.evictions << std::endl;
+	return inserted;
+}
+
+void PreprocessorFactory::SetInputType(TensorType type)
+{
+	m_input_type = type;
+}
+
+void PreprocessorFactory::SetTargetSize(const cv::Size &target)
+{
+	m_target = target;
+	for (auto &[name, item] : m_workers) {
+		item->SetTargetSize(target);
+	}
+}
+
+PlanCacheStats PreprocessorFactory::CacheStats() const
+{
+	return m_plans->Stats();
+}
+
 void PreprocessorFactory::Run(const std::vector<cv::Mat> &input, SharedRef<ImageBlob> &output)
+{
+	Run(input, output, PixelFormat::BGR, cv::Mat());
+}
+
+void PreprocessorFactory::Run(const std::vector<cv::Mat> &input, SharedRef<ImageBlob> &output,
+							  PixelFormat format, const cv::Mat &mask)
 {
 	if (!INIT_FLAG) {
 		Init();
 		INIT_FLAG = true;
-		if (m_config->INPUT_SHAPE[m_config->INPUT_SHAPE.size() - 1] != input[0].cols) {
-			m_config->INPUT_SHAPE[m_config->INPUT_SHAPE.size() - 1] = input[0].cols;
-			SCALE_W = (float)m_config->TARGET_SIZE[1] / (float)input[0].cols;
-			std::cout << "Input shape width in config file is not same as data width..." << std::endl;
-		}
-		if (m_config->INPUT_SHAPE[m_config->INPUT_SHAPE.size() - 2] != input[0].rows) {
-			m_config->INPUT_SHAPE[m_config->INPUT_SHAPE.size() - 2] = input[0].rows;
-			SCALE_H = (float)m_config->TARGET_SIZE[0] / (float)input[0].rows;
-			std::cout << "Input shape height in config file is not same as data height..." << std::endl;
-		}
-		m_gpu_data.resize(input.size());
-		auto ss = input[0].total() * input[0].elemSize();
-		for (auto &i : m_gpu_data) {
-			void *ptr = nullptr;
-			cudaMalloc(&ptr, ss);
-			i = cv::cuda::GpuMat(input[0].rows, input[0].cols, input[0].type(), ptr);
-		}
-		m_input_paged_mat.resize(input.size());
-		m_input.resize(input.size());
+	}
+	///@note the config is shared read only, the actual picture size is kept in the plan instead of patching INPUT_SHAPE.
+	auto &plan = AcquirePlan(input, format);
+	m_picture = plan.picture;
+	SCALE_W = plan.scale_w;
+	SCALE_H = plan.scale_h;
+	if (format == PixelFormat::BGR) {
 		for (int i = 0; i < input.size(); i++) {
-			cudaMallocHost(&m_input_paged_mat[i], ss);
-			m_input[i] = cv::Mat(cv::Size(input[0].cols, input[0].rows),
-								 input[0].type(), m_input_paged_mat[i]);
-
+			///@note a single thread does not saturate the copy into pinned memory, rows are copied in bands.
+			const size_t row_bytes = input[i].cols * input[i].elemSize();
+			auto *dst = static_cast<unsigned char *>(plan.paged_ptr[i]);
+			const auto *src = input[i].data;
+			WorkPool::Instance().ParallelFor(0, input[i].rows, 64, [&](int begin, int end) {
+				memcpy(dst + begin * row_bytes, src + begin * row_bytes, (end - begin) * row_bytes);
+			});
 		}
-
 	}
-	for (int i = 0; i < input.size(); i++) {
-		memcpy(m_input_paged_mat[i], input[i].data, input[i].total() * input[i].elemSize());
+	else {
+		for (int i = 0; i < input.size(); i++) {
+			m_yuv_resizer.Run(input[i], format, plan.input[i], mask, (int)m_config->INTERP);
+		}
 	}
+	///@note the pipeline replaces the working images, they are pointed back to the converted buffers per frame.
 	int num = 0;
-	CvtForGpuMat(m_input, m_gpu_data, num);
+	CvtForGpuMat(plan, num);
 
 	for (const auto &i : m_config->PIPELINE_TYPE) {
-		m_workers[i]->Run(m_gpu_data);
+		if (m_input_type == TensorType::UINT8 && i == "NormalizeImage")continue;
+		m_workers[i]->Run(plan.gpu_data);
 	}
 
-	output->m_gpu_data = this->m_gpu_data;
+	output->m_gpu_data = plan.gpu_data;
 }
 
 PreprocessorFactory::~PreprocessorFactory()
@@ -93,9 +238,9 @@ PreprocessorFactory::~PreprocessorFactory()
 		delete item;
 		item = nullptr;
 	}
-	for(auto &i:m_input_paged_mat){
-		cudaFreeHost(i);
-	}
+	///@note the staging buffers are freed with the plans.
+	if (m_stream)m_stream->waitForCompletion();
+	m_plans.reset();
 }
 
 void Preprocessor::Run(const std::vector<cv::Mat> &input,
@@ -103,19 +248,47 @@ void Preprocessor::Run(const std::vector<cv::Mat> &input,
 					   SharedRef<cv::cuda::Stream> &stream)
 {
 	if (cv::cuda::getCudaEnabledDeviceCount() == 0) {
-		std::cerr << "Your OpenCV does not support CUDA!" << std::endl;
-		std::cerr << "Please install CUDA version OpenCV! "
+		logStream(LogLevel::ERROR) << "Your OpenCV does not support CUDA!" << std::endl;
+		logStream(LogLevel::ERROR) << "Please install CUDA version OpenCV! "
 					 "See: https://towardsdev.com/installing-opencv-4-with-cuda-in-ubuntu-20-04-fde6d6a0a367"
 				  << std::endl;
 	}
 	if (!m_preprocess_factory) {
 		m_preprocess_factory = createSharedRef<PreprocessorFactory>(m_config, stream);
+		m_preprocess_factory->SetInputType(m_input_type);
+		if (!m_target.empty())m_preprocess_factory->SetTargetSize(m_target);
 	}
 
 	m_preprocess_factory->Run(input, output);
 
 }
 
+void Preprocessor::Run(const std::vector<cv::Mat> &input,
+					   SharedRef<ImageBlob> &output,
+					   SharedRef<cv::cuda::Stream> &stream,
+					   PixelFormat format, const cv::Mat &mask)
+{
+	if (!m_preprocess_factory) {
+		m_preprocess_factory = createSharedRef<PreprocessorFactory>(m_config, stream);
+		m_preprocess_factory->SetInputType(m_input_type);
+		if (!m_target.empty())m_preprocess_factory->SetTargetSize(m_target);
+	}
+
+	m_preprocess_factory->Run(input, output, format, mask);
+}
+
+void Preprocessor::SetTargetSize(const cv::Size &target)
+{
+	m_target = target;
+	if (m_preprocess_factory)m_preprocess_factory->SetTargetSize(target);
+}
+
+PlanCacheStats Preprocessor::CacheStats() const
+{
+	if (!m_preprocess_factory)return {};
+	return m_preprocess_factory->CacheStats();
+}
+
 
 #endif
 
@@ -6,6 +6,8 @@
 #include "macro.h"
 #include "config.h"
 #include "preprocess_ops.h"
+#include "yuv_convert.h"
+#include "tensor_pack.h"
 
 namespace helmet
 {
@@ -24,6 +26,103 @@ struct ImageBlob
 	std::vector<cv::cuda::GpuMat> m_gpu_data;///< real gpu data.
 };
 
+/**
+ * @brief staging buffers of one input resolution, built on the first frame of that resolution and reused.
+ * @note buffers are freed on destruction, the stream using them must be synchronized before.
+ */
+struct PreprocessPlan
+{
+	cv::Size picture;///< picture size of the frames.
+	float scale_w = 1.0f;///< scale of width to the network input size.
+	float scale_h = 1.0f;///< scale of height to the network input size.
+	std::vector<void *> device_ptr;///< device buffers of staged images.
+	std::vector<void *> paged_ptr;///< pinned host buffers of staged images.
+	std::vector<cv::cuda::GpuMat> staging;///< GpuMat over device_ptr, uploading into it never reallocates.
+	std::vector<cv::cuda::GpuMat> converted;///< float copies of staging, converting into them never reallocates.
+	std::vector<cv::Mat> input;///< Mat over paged_ptr.
+	std::vector<cv::cuda::GpuMat> gpu_data;///< working images of the pipeline, reset to converted per frame.
+	uint64_t last_used = 0;///< tick of last use, for LRU eviction.
+
+	PreprocessPlan() = default;
+	~PreprocessPlan();
+	PreprocessPlan(const PreprocessPlan &) = delete;
+	PreprocessPlan &operator=(const PreprocessPlan &) = delete;
+};
+
+/**
+ * @brief key of a plan, i.e. frame width, height and type, and the network input size.
+ */
+struct PlanKey
+{
+	int width = 0;
+	int height = 0;
+	int type = 0;
+	int count = 1;///< images per run, batched runs get buffers of their own.
+	int target_width = 0;///< network input width, the scales depend on it.
+	int target_height = 0;
+
+	bool operator==(const PlanKey &other) const
+	{
+		return width == other.width && height == other.height && type == other.type && count == other.count &&
+			   target_width == other.target_width && target_height == other.target_height;
+	}
+};
+
+/**
+ * @brief statistics of a plan cache.
+ */
+struct PlanCacheStats
+{
+	uint64_t hits = 0;
+	uint64_t misses = 0;///< number of plans built.
+	uint64_t evictions = 0;
+	size_t size = 0;///< number of plans cached.
+	size_t capacity = 0;
+};
+
+/**
+ * @brief small LRU cache of preprocessing plans, for cameras switching resolution at runtime.
+ * @details the capacity is small, so plans are kept in a vector and searched linearly, <!--
+ * --> the plan of the previous frame is checked first, thus a steady stream costs one compare.
+ * @note not thread safe, owned by one PreprocessorFactory.
+ */
+class PlanCache final
+{
+public:
+	explicit PlanCache(size_t capacity);
+
+	/**
+	 * @brief find the plan of a key and mark it as most recently used.
+	 * @return plan or nullptr if not cached.
+	 */
+	PreprocessPlan *Find(const PlanKey &key);
+
+	/**
+	 * @brief check whether inserting will evict a plan.
+	 */
+	bool Full() const;
+
+	/**
+	 * @brief insert a plan, the least recently used one is evicted if full.
+	 * @param key key of plan.
+	 * @param plan built plan.
+	 * @return inserted plan.
+	 */
+	PreprocessPlan &Insert(const PlanKey &key, UniqueRef<PreprocessPlan> plan);
+
+	/**
+	 * @brief get statistics.
+	 */
+	PlanCacheStats Stats() const;
+
+private:
+	size_t m_capacity = 1;
+	uint64_t m_tick = 0;
+	size_t m_last = 0;///< index of the plan found last.
+	std::vector<std::pair<PlanKey, UniqueRef<PreprocessPlan>>> m_plans;
+	PlanCacheStats m_stats;
+};
+
 /**
  * @brief this is factory class for preprocessing
  * @details this class contains all worker class for preprocessing purpose.
@@ -69,30 +168,69 @@ public:
 	 * @param output preprocessing results.
 	 */
 	void Run(const std::vector<cv::Mat> &input, SharedRef<ImageBlob> &output);
+	/**
+	 * @brief working function for frames in any supported pixel format.
+	 * @details planar YUV frames are converted and downscaled to TRAIN_SIZE in one pass on host before uploading.
+	 * @param input raw image data.
+	 * @param output preprocessing results.
+	 * @param format pixel layout of input.
+	 * @param mask optional CV_8UC1 ROI mask of TRAIN_SIZE, only used by YUV input.
+	 */
+	void Run(const std::vector<cv::Mat> &input, SharedRef<ImageBlob> &output,
+			 PixelFormat format, const cv::Mat &mask);
+	/**
+	 * @brief get statistics of the plan cache.
+	 */
+	PlanCacheStats CacheStats() const;
+	/**
+	 * @brief set the element type of the image input, NormalizeImage is skipped for UINT8 since the <!--
+	 * --> normalization is folded into the model.
+	 */
+	void SetInputType(TensorType type);
+	/**
+	 * @brief set the network input size of the next frames, plans are cached per size.
+	 */
+	void SetTargetSize(const cv::Size &target);
 
 private:
 	/**
- 	* @brief convert cpu mat to GPU mat pointer
- 	* @param input input raw data.
- 	* @param frames pointer to GpuMat.
+	 * @brief allocate the pinned host buffers and gpu buffers for staging input.
+	 * @param plan plan being built.
+	 * @param size staged image size.
+	 * @param type staged image type.
+	 * @param num number of images.
+	 */
+	void Allocate(PreprocessPlan &plan, const cv::Size &size, int type, size_t num);
+	/**
+	 * @brief get the plan for the input frames, built on first use of a resolution.
+	 * @param input raw image data.
+	 * @param format pixel layout of input.
+	 * @return plan of current resolution.
+	 */
+	PreprocessPlan &AcquirePlan(const std::vector<cv::Mat> &input, PixelFormat format);
+	/**
+ 	* @brief upload the staged images and convert them to float into the buffers of the plan.
+ 	* @param plan plan of current resolution, its gpu_data point to the converted images afterwards.
  	* @param num number of GpuMats.
  	*/
-	void CvtForGpuMat(const std::vector<cv::Mat> &input, std::vector<cv::cuda::GpuMat>& frames, int &num);
+	void CvtForGpuMat(PreprocessPlan &plan, int &num);
 
 public:
 	///@note this CONFIG must be set before actually inferring.
 	bool INIT_FLAG= false;///< indicate initialization status.
-	float SCALE_W= 1.0f;///< indicate scale of width.
-	float SCALE_H = 1.0f;///< indicate scale of height.
+	float SCALE_W= 1.0f;///< indicate scale of width of current frame.
+	float SCALE_H = 1.0f;///< indicate scale of height of current frame.
+	cv::Size m_picture;///< picture size of current frame.
 private:
 //	SharedRef<Factory<PreprocessOp>> m_ops = nullptr;///< worker smart pointer.
 	std::unordered_map<std::string,PreprocessOp*> m_workers;
 	SharedRef<cv::cuda::Stream> m_stream = nullptr;///< parallel support.
 	cudaStream_t m_cuda_stream = nullptr;
 	SharedRef<Config> m_config = nullptr;
-    std::vector<cv::cuda::GpuMat> m_gpu_data;
-	std::vector<void*> m_input_paged_mat;
-	std::vector<cv::Mat> m_input;
+	UniqueRef<PlanCache> m_plans = nullptr;///< staging buffers per resolution.
+	TensorType m_input_type = TensorType::FLOAT32;
+	cv::Size m_target;///< network input size, TARGET_SIZE of the config until changed.
+	YUVResizer m_yuv_resizer;///< fused colour conversion and downscale for YUV input.
 };
 
 /**
@@ -112,9 +250,35 @@ public:
 	 * @param output output preprocessed data.
 	 */
 	void Run(const std::vector<cv::Mat> &input, SharedRef<ImageBlob> &output,SharedRef<cv::cuda::Stream>& stream);
+	/**
+	 * @brief invoking interface function for frames in any supported pixel format.
+	 * @param input raw image data.
+	 * @param output output preprocessed data.
+	 * @param format pixel layout of input.
+	 * @param mask optional CV_8UC1 ROI mask of TRAIN_SIZE, only used by YUV input.
+	 */
+	void Run(const std::vector<cv::Mat> &input, SharedRef<ImageBlob> &output,SharedRef<cv::cuda::Stream>& stream,
+			 PixelFormat format, const cv::Mat &mask);
+	/**
+	 * @brief get statistics of the plan cache, all zero before the first frame.
+	 */
+	PlanCacheStats CacheStats() const;
+	/**
+	 * @brief set the element type of the image input, must be called before the first frame.
+	 */
+	void SetInputType(TensorType type)
+	{
+		m_input_type = type;
+	}
+	/**
+	 * @brief set the network input size of the next frames, may be called at any time.
+	 */
+	void SetTargetSize(const cv::Size &target);
 
 private:
 	SharedRef<PreprocessorFactory> m_preprocess_factory = nullptr;///< worker factory.
 	SharedRef<Config> m_config = nullptr;
+	TensorType m_input_type = TensorType::FLOAT32;
+	cv::Size m_target;///< empty until set, the factory starts with TARGET_SIZE.
 };
 }
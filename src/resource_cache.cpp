@@ -0,0 +1,99 @@
+#include <atomic>
+#include <filesystem>
+#include <sys/stat.h>
+#include "resource_cache.h"
+#include "log.h"
+
+namespace helmet
+{
+
+cv::freetype::FreeType2 &SharedFont::Local() const
+{
+	///@note keyed by id instead of address, a freed font may be followed by another one at the same address.
+	static thread_local std::unordered_map<uint64_t, cv::Ptr<cv::freetype::FreeType2>> faces;
+	auto &face = faces[id];
+	if (!face) {
+		face = cv::freetype::createFreeType2();
+		face->loadFontData(file, 0);
+	}
+	return *face;
+}
+
+ResourceCache &ResourceCache::Instance()
+{
+	static ResourceCache cache;
+	return cache;
+}
+
+int64_t ResourceCache::fileStamp(const std::string &file, std::string &key)
+{
+	std::error_code ec;
+	auto path = std::filesystem::weakly_canonical(file, ec);
+	key = ec ? file : path.string();
+	struct stat statBuf;
+	if (stat(key.c_str(), &statBuf) != 0)return -1;
+	return (int64_t)statBuf.st_mtim.tv_sec * 1000000000 + statBuf.st_mtim.tv_nsec;
+}
+
+SharedRef<Config> ResourceCache::AcquireConfig(const std::string &file)
+{
+	std::string key;
+	auto mtime = fileStamp(file, key);
+	SharedRef<const Config> tmpl;
+	{
+		///@note parsing is done under the lock, concurrent allocations wait for the first one instead of parsing again.
+		std::lock_guard<std::mutex> lock(m_mtx);
+		auto &entry = m_configs[key];
+		if (!entry.value || entry.mtime != mtime) {
+			entry.value = createSharedRef<Config>(0, nullptr, file);
+			entry.mtime = mtime;
+			m_stats.config_misses++;
+		}
+		else {
+			m_stats.config_hits++;
+		}
+		tmpl = entry.value;
+	}
+	return createSharedRef<Config>(*tmpl);
+}
+
+SharedRef<SharedFont> ResourceCache::AcquireFont(const std::string &file)
+{
+	std::string key;
+	auto mtime = fileStamp(file, key);
+	std::lock_guard<std::mutex> lock(m_mtx);
+	auto &entry = m_fonts[key];
+	if (entry.value && entry.mtime == mtime) {
+		m_stats.font_hits++;
+		return entry.value;
+	}
+	static std::atomic<uint64_t> next_id{1};
+	auto font = createSharedRef<SharedFont>();
+	font->file = key;
+	font->id = next_id++;
+	if (mtime < 0) {
+		logStream(LogLevel::WARNING) << "Font file not found: " << file;
+	}
+	else {
+		font->loaded = true;
+	}
+	entry.value = font;
+	entry.mtime = mtime;
+	m_stats.font_misses++;
+	return font;
+}
+
+void ResourceCache::Clear()
+{
+	std::lock_guard<std::mutex> lock(m_mtx);
+	m_configs.clear();
+	m_fonts.clear();
+}
+
+ResourceCache::Stats ResourceCache::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(m_mtx);
+	return m_stats;
+}
+
+}
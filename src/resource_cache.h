@@ -0,0 +1,104 @@
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <opencv2/freetype.hpp>
+#include "config.h"
+#include "util.h"
+
+namespace helmet
+{
+/**
+ * @brief a font shared by all instances.
+ * @details FreeType faces are not thread safe, so only the font file is shared and every drawing thread <!--
+ * --> gets a face of its own from Local(), streams drawing at the same time never wait for each other.
+ */
+struct SharedFont
+{
+	std::string file;///< canonical path of the font file.
+	uint64_t id = 0;///< unique per loaded font, a reloaded file gets new faces.
+	bool loaded = false;///< false if the font file is missing, nothing should be drawn then.
+
+	/**
+	 * @brief get the face of the calling thread, loaded on first use by this thread.
+	 * @note only valid if loaded.
+	 */
+	cv::freetype::FreeType2 &Local() const;
+};
+
+/**
+ * @brief process wide cache of read only resources shared by all instances.
+ * @details entries are keyed by canonical file path and validated against the file modification time, <!--
+ * --> so an edited file is reloaded on the next acquisition while the instances already allocated keep <!--
+ * --> their version.
+ * - config files are parsed once into a template, each instance gets its own copy of the template, which <!--
+ * --> is a plain member wise copy without any file access or parsing, the instance can then modify it freely.
+ * - fonts are checked once and shared, each drawing thread loads its own face.
+ * @example:
+ * @code
+ * 	auto config = ResourceCache::Instance().AcquireConfig("./helmet_detection.yaml");
+ * 	config->INPUT_SHAPE.back() = frame.cols;
+ * @endcode
+ */
+class ResourceCache final
+{
+public:
+	struct Stats
+	{
+		uint64_t config_hits = 0;
+		uint64_t config_misses = 0;///< number of times a config file is parsed.
+		uint64_t font_hits = 0;
+		uint64_t font_misses = 0;///< number of times a font file is loaded.
+	};
+
+public:
+	static ResourceCache &Instance();
+
+	/**
+	 * @brief get a private copy of a parsed config file.
+	 * @param file YAML config file.
+	 * @return config owned by the caller.
+	 */
+	SharedRef<Config> AcquireConfig(const std::string &file);
+
+	/**
+	 * @brief get a shared font.
+	 * @param file TTF font file.
+	 * @return shared font, never nullptr.
+	 */
+	SharedRef<SharedFont> AcquireFont(const std::string &file);
+
+	/**
+	 * @brief drop all cached entries, resources still in use are kept alive by their users.
+	 */
+	void Clear();
+
+	Stats GetStats() const;
+
+private:
+	ResourceCache() = default;
+
+	/**
+	 * @brief get the cache key and modification time of a file.
+	 * @param file file name.
+	 * @param key canonical path.
+	 * @return modification time in ns, -1 if the file does not exist.
+	 */
+	static int64_t fileStamp(const std::string &file, std::string &key);
+
+private:
+	template<typename T>
+	struct Entry
+	{
+		int64_t mtime = -1;
+		SharedRef<T> value = nullptr;
+	};
+
+	mutable std::mutex m_mtx;
+	std::unordered_map<std::string, Entry<const Config>> m_configs;
+	std::unordered_map<std::string, Entry<SharedFont>> m_fonts;
+	Stats m_stats;
+};
+
+}
@@ -0,0 +1,133 @@
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include "score_smoother.h"
+
+namespace helmet
+{
+
+bool parseSmoothMethod(const std::string &name, SmoothMethod &method)
+{
+	std::string lower(name);
+	std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+	if (lower == "none") {
+		method = SmoothMethod::NONE;
+		return true;
+	}
+	if (lower == "ema") {
+		method = SmoothMethod::EMA;
+		return true;
+	}
+	if (lower == "mean") {
+		method = SmoothMethod::MEAN;
+		return true;
+	}
+	return false;
+}
+
+void ScoreSmoother::Configure(size_t cells, size_t capacity, int64_t tau_us)
+{
+	m_cells = cells;
+	m_capacity = std::max<size_t>(1, capacity);
+	m_tau_us = tau_us;
+	m_last_time = -1;
+	m_current.assign(m_cells, 0.0f);
+	m_ema.assign(m_cells, 0.0f);
+	m_ring.assign(m_cells * m_capacity, 0.0f);
+	m_sum.assign(m_cells, 0.0);
+	m_sum_sq.assign(m_cells, 0.0);
+	m_head = 0;
+	m_count = 0;
+}
+
+void ScoreSmoother::Begin()
+{
+	std::fill(m_current.begin(), m_current.end(), 0.0f);
+}
+
+void ScoreSmoother::Add(int cell, float score)
+{
+	if (Valid(cell))m_current[cell] = std::max(m_current[cell], score);
+}
+
+void ScoreSmoother::Commit(int64_t time_us)
+{
+	if (m_cells == 0)return;
+	///@note the weight of a sample grows with the time it stands for, 1 - exp(-dt / tau).
+	///@note the EMA is seeded at 0 and the first sample stands for no time yet, it only starts the clock,
+	/// so a single false positive on the first inference of a stream cannot reach the threshold.
+	float alpha = m_tau_us > 0 ? 0.0f : 1.0f;
+	if (m_last_time >= 0 && m_tau_us > 0) {
+		const double dt = (double)std::max<int64_t>(0, time_us - m_last_time);
+		alpha = (float)(1.0 - std::exp(-dt / (double)m_tau_us));
+	}
+	m_last_time = time_us;
+
+	if (m_count == m_capacity) {
+		const float *oldest = &m_ring[m_head * m_cells];
+		for (size_t c = 0; c < m_cells; ++c) {
+			m_sum[c] -= oldest[c];
+			m_sum_sq[c] -= (double)oldest[c] * oldest[c];
+		}
+		m_head = (m_head + 1) % m_capacity;
+		m_count--;
+	}
+	float *row = &m_ring[((m_head + m_count) % m_capacity) * m_cells];
+	for (size_t c = 0; c < m_cells; ++c) {
+		const float x = m_current[c];
+		row[c] = x;
+		m_sum[c] += x;
+		m_sum_sq[c] += (double)x * x;
+		m_ema[c] += alpha * (x - m_ema[c]);
+	}
+	m_count++;
+}
+
+size_t ScoreSmoother::Cells() const
+{
+	return m_cells;
+}
+
+size_t ScoreSmoother::Count() const
+{
+	return m_count;
+}
+
+bool ScoreSmoother::Valid(int cell) const
+{
+	return cell >= 0 && (size_t)cell < m_cells;
+}
+
+float ScoreSmoother::Ema(int cell) const
+{
+	return Valid(cell) ? m_ema[cell] : 0.0f;
+}
+
+float ScoreSmoother::Mean(int cell) const
+{
+	///@note averaged over the whole window, slots not filled yet count as 0 like the seed of the EMA.
+	return Valid(cell) ? (float)(m_sum[cell] / (double)m_capacity) : 0.0f;
+}
+
+float ScoreSmoother::StdDev(int cell) const
+{
+	if (!Valid(cell) || m_count == 0)return 0.0f;
+	const double mean = m_sum[cell] / (double)m_count;
+	///@note the running sums drift slightly, the variance is clamped at zero.
+	return (float)std::sqrt(std::max(0.0, m_sum_sq[cell] / (double)m_count - mean * mean));
+}
+
+float ScoreSmoother::Score(int cell, SmoothMethod method) const
+{
+	switch (method) {
+	case SmoothMethod::EMA:
+		return Ema(cell);
+	case SmoothMethod::MEAN:
+		return Mean(cell);
+	default:
+		if (!Valid(cell) || m_count == 0)return 0.0f;
+		return m_ring[((m_head + m_count - 1) % m_capacity) * m_cells + cell];
+	}
+}
+
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace helmet
+{
+/**
+ * @brief which smoothed score gates the alarm.
+ */
+enum class SmoothMethod
+{
+	NONE = 0,///< raw per frame scores, a single frame false positive counts.
+	EMA = 1,///< exponential moving average with time constant SMOOTH_TAU_MS.
+	MEAN = 2 ///< mean of the latest SMOOTH_WINDOW inferences.
+};
+
+/**
+ * @brief parse "none", "ema" or "mean", case insensitive.
+ * @return true if parsed.
+ */
+extern bool parseSmoothMethod(const std::string &name, SmoothMethod &method);
+
+/**
+ * @brief temporal smoothing of the target score per grid cell of one stream.
+ * @details every fresh inference gives one sample per cell, the highest target score inside the cell or 0. <!--
+ * --> The samples go into a ring of fixed capacity shared by all cells, with running sums for the window mean <!--
+ * --> and deviation, and into an EMA whose weight follows the time since the previous inference, <!--
+ * --> so the smoothing keeps its time constant when the inference interval changes. <!--
+ * --> Both start from 0, a stream needs several inferences with a target before a cell reaches a threshold. <!--
+ * --> Nothing is allocated after Configure(), a sample costs O(cells).
+ * @example:
+ * @code
+ * 	ScoreSmoother smoother;
+ * 	smoother.Configure(4, 8, 600000);
+ * 	smoother.Begin();
+ * 	smoother.Add(cell, box.score);
+ * 	smoother.Commit(result_time);
+ * 	bool target = smoother.Ema(cell) >= 0.5f;
+ * @endcode
+ */
+class ScoreSmoother final
+{
+public:
+	/**
+	 * @brief allocate the state, which is reset.
+	 * @param cells number of grid cells.
+	 * @param capacity inferences kept in the window.
+	 * @param tau_us EMA time constant, 0 or negative to follow the latest sample.
+	 */
+	void Configure(size_t cells, size_t capacity, int64_t tau_us);
+
+	/**
+	 * @brief start collecting the samples of a fresh inference.
+	 */
+	void Begin();
+
+	/**
+	 * @brief add a target score to a cell, the highest score of the inference is kept.
+	 */
+	void Add(int cell, float score);
+
+	/**
+	 * @brief push the collected samples into the window and the EMA.
+	 * @param time_us time of the inference.
+	 */
+	void Commit(int64_t time_us);
+
+	size_t Cells() const;
+
+	/**
+	 * @brief get the number of inferences in the window.
+	 */
+	size_t Count() const;
+
+	float Ema(int cell) const;
+
+	/**
+	 * @brief get the mean over capacity inferences, 0 for the ones not made yet.
+	 */
+	float Mean(int cell) const;
+	float StdDev(int cell) const;
+
+	/**
+	 * @brief get the smoothed score of a cell.
+	 * @param method EMA or MEAN, NONE gives the latest sample.
+	 */
+	float Score(int cell, SmoothMethod method) const;
+
+private:
+	bool Valid(int cell) const;
+
+private:
+	size_t m_cells = 0;
+	size_t m_capacity = 1;
+	int64_t m_tau_us = 0;
+	int64_t m_last_time = -1;///< time of the latest sample, -1 before the first one.
+	std::vector<float> m_current;///< samples being collected, per cell.
+	std::vector<float> m_ema;///< per cell.
+	std::vector<float> m_ring;///< capacity rows of cells samples each.
+	std::vector<double> m_sum;///< per cell, of the samples in the ring.
+	std::vector<double> m_sum_sq;///< per cell, of the squared samples in the ring.
+	size_t m_head = 0;///< row of the oldest sample.
+	size_t m_count = 0;///< rows in use.
+};
+
+}
@@ -0,0 +1,65 @@
+#include <algorithm>
+#include "temporal_ring.h"
+
+namespace helmet
+{
+
+void TemporalRing::Configure(int length, int stride)
+{
+	m_length = std::max(1, length);
+	m_stride = std::min(std::max(1, stride), m_length);
+	m_slots.resize(m_length);
+	Reset();
+}
+
+bool TemporalRing::Push(const cv::cuda::GpuMat &img, cv::cuda::Stream &stream)
+{
+	if (img.empty())return false;
+	///@note frames of another input size cannot share a clip with the ones held.
+	if (m_size > 0 && m_slots[(m_next + m_length - 1) % m_length].size() != img.size()) {
+		Reset();
+	}
+	///@note copyTo() will not reallocate if size and type are unchanged.
+	img.copyTo(m_slots[m_next], stream);
+	m_next = (m_next + 1) % m_length;
+	if (m_size < m_length) {
+		m_size++;
+		if (m_size < m_length)return false;
+		m_pushed = 0;
+		return true;
+	}
+	return ++m_pushed % m_stride == 0;
+}
+
+void TemporalRing::Clip(std::vector<cv::cuda::GpuMat> &frames) const
+{
+	frames.clear();
+	const int first = m_size < m_length ? 0 : m_next;
+	for (int i = 0; i < m_size; ++i) {
+		frames.push_back(m_slots[(first + i) % m_length]);
+	}
+}
+
+void TemporalRing::Reset()
+{
+	m_next = 0;
+	m_size = 0;
+	m_pushed = 0;
+}
+
+int TemporalRing::Length() const
+{
+	return m_length;
+}
+
+int TemporalRing::Stride() const
+{
+	return m_stride;
+}
+
+int TemporalRing::Size() const
+{
+	return m_size;
+}
+
+}
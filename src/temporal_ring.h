@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <opencv2/core/cuda.hpp>
+
+namespace helmet
+{
+/**
+ * @brief ring of the latest preprocessed frames of one stream, fed to the network as one clip.
+ * @details every sampled frame is preprocessed once and copied into the oldest slot, the slots are <!--
+ * --> preallocated on the first frame and reused. Once the ring holds length frames a clip is due, <!--
+ * --> then again every stride frames, so consecutive clips overlap by length - stride frames <!--
+ * --> without preprocessing any frame twice.
+ * @note not thread safe, one ring belongs to one stream.
+ * @example:
+ * @code
+ * 	TemporalRing ring;
+ * 	ring.Configure(8, 4);
+ * 	if (ring.Push(blob->m_gpu_data[0], stream)) {
+ * 		ring.Clip(clip_blob->m_gpu_data);
+ * 		// infer the 8 frames, oldest first.
+ * 	}
+ * @endcode
+ */
+class TemporalRing final
+{
+public:
+	/**
+	 * @brief set clip length and stride, clears the ring.
+	 * @param length frames per clip, at least 1.
+	 * @param stride new frames between two clips, clamped to [1, length].
+	 */
+	void Configure(int length, int stride);
+
+	/**
+	 * @brief copy a preprocessed frame into the ring.
+	 * @param img preprocessed frame, a buffer of the preprocessor reused by the next frame.
+	 * @param stream stream the copy is queued on.
+	 * @return true if a clip is due.
+	 * @note a frame of another size than the ones held restarts the ring.
+	 */
+	bool Push(const cv::cuda::GpuMat &img, cv::cuda::Stream &stream);
+
+	/**
+	 * @brief get the frames of the ring, oldest first.
+	 * @param frames headers of the slots, no data is copied.
+	 */
+	void Clip(std::vector<cv::cuda::GpuMat> &frames) const;
+
+	/**
+	 * @brief drop the frames held, the slots are kept.
+	 */
+	void Reset();
+
+	int Length() const;
+
+	int Stride() const;
+
+	/**
+	 * @brief get the number of frames held, up to Length().
+	 */
+	int Size() const;
+
+private:
+	std::vector<cv::cuda::GpuMat> m_slots;
+	int m_length = 1;
+	int m_stride = 1;
+	int m_next = 0;///< slot of the next frame, the oldest one once full.
+	int m_size = 0;
+	int64_t m_pushed = 0;///< frames pushed since the ring became full.
+};
+
+}
@@ -0,0 +1,340 @@
+#include <algorithm>
+#include <cctype>
+#include <sstream>
+#include "tensor_binding.h"
+#include "log.h"
+
+namespace helmet
+{
+
+size_t dataTypeSize(nvinfer1::DataType dtype)
+{
+	switch (dtype) {
+		case nvinfer1::DataType::kFLOAT:
+		case nvinfer1::DataType::kINT32:
+			return 4;
+		case nvinfer1::DataType::kHALF:
+			return 2;
+		case nvinfer1::DataType::kINT8:
+		case nvinfer1::DataType::kUINT8:
+		case nvinfer1::DataType::kBOOL:
+			return 1;
+		default:
+			return 0;
+	}
+}
+
+std::string dimsString(const nvinfer1::Dims &dims)
+{
+	std::stringstream ss;
+	ss << "[";
+	for (int i = 0; i < dims.nbDims; ++i) {
+		ss << (i ? "," : "") << dims.d[i];
+	}
+	ss << "]";
+	return ss.str();
+}
+
+/**
+ * @brief get the number of elements of a shape, 0 if any dimension is unknown.
+ */
+static size_t volume(const nvinfer1::Dims &dims)
+{
+	size_t n = 1;
+	for (int i = 0; i < dims.nbDims; ++i) {
+		n *= (size_t)std::max<int64_t>(0, dims.d[i]);
+	}
+	return n;
+}
+
+static bool sameDims(const nvinfer1::Dims &a, const nvinfer1::Dims &b)
+{
+	if (a.nbDims != b.nbDims)return false;
+	for (int i = 0; i < a.nbDims; ++i) {
+		if (a.d[i] != b.d[i])return false;
+	}
+	return true;
+}
+
+bool TensorBinding::Dynamic() const
+{
+	for (int i = 0; i < dims.nbDims; ++i) {
+		if (dims.d[i] < 0)return true;
+	}
+	return false;
+}
+
+size_t TensorBinding::Elements() const
+{
+	return std::min(volume(shape), capacity);
+}
+
+void *TensorBindings::OutputAllocator::reallocateOutput(const char *name, void *memory, uint64_t size,
+														uint64_t alignment) noexcept
+{
+	auto *t = m_owner.FindOutput(name);
+	if (!t)return nullptr;
+	const size_t elements = (size + t->elem_size - 1) / t->elem_size;
+	if (t->device && elements <= t->capacity)return t->device;
+	///@note cudaMalloc() is aligned to 256 bytes, which covers the alignment TensorRT asks for.
+	logStream(LogLevel::WARNING) << "Output " << name << " grows to " << size << " bytes" << std::endl;
+	if (t->device)cudaFree(t->device);
+	if (t->host)cudaFreeHost(t->host);
+	t->device = nullptr;
+	t->host = nullptr;
+	t->capacity = 0;
+	if (cudaMalloc(&t->device, elements * t->elem_size) != cudaSuccess ||
+		cudaMallocHost(&t->host, elements * t->elem_size) != cudaSuccess) {
+		logStream(LogLevel::ERROR) << "Allocate memory failed for tensor " << name << std::endl;
+		return nullptr;
+	}
+	t->capacity = elements;
+	return t->device;
+}
+
+void TensorBindings::OutputAllocator::notifyShape(const char *name, const nvinfer1::Dims &dims) noexcept
+{
+	if (auto *t = m_owner.FindOutput(name))t->shape = dims;
+}
+
+TensorBindings::~TensorBindings()
+{
+	for (auto &t : m_tensors) {
+		if (t.device)cudaFree(t.device);
+		if (t.host)cudaFreeHost(t.host);
+	}
+}
+
+bool TensorBindings::Load(nvinfer1::ICudaEngine *engine, nvinfer1::IExecutionContext *context, int profile,
+						  cudaStream_t stream, const std::vector<std::string> &output_names,
+						  const std::vector<std::vector<int>> &output_shapes)
+{
+	m_context = context;
+	const int profiles = std::max(1, engine->getNbOptimizationProfiles());
+	m_profile = std::min(std::max(profile, 0), profiles - 1);
+	if (m_profile != profile) {
+		logStream(LogLevel::WARNING) << "The engine has " << profiles << " profiles, using profile " << m_profile << std::endl;
+	}
+	if (m_profile > 0 && !context->setOptimizationProfileAsync(m_profile, stream)) {
+		logStream(LogLevel::ERROR) << "Cannot select optimization profile " << m_profile << std::endl;
+		return false;
+	}
+
+	const int num = engine->getNbIOTensors();
+	m_tensors.resize(num);
+	for (int i = 0; i < num; ++i) {
+		auto &t = m_tensors[i];
+		t.name = engine->getIOTensorName(i);
+		t.input = engine->getTensorIOMode(t.name.c_str()) == nvinfer1::TensorIOMode::kINPUT;
+		t.dtype = engine->getTensorDataType(t.name.c_str());
+		t.elem_size = dataTypeSize(t.dtype);
+		if (t.elem_size == 0) {
+			logStream(LogLevel::WARNING) << "Unknown data type of tensor " << t.name << ", reserving 8 bytes per element." << std::endl;
+			t.elem_size = 8;
+		}
+		t.dims = engine->getTensorShape(t.name.c_str());
+		if (!t.input) {
+			t.role = TensorRole::OUTPUT;
+			continue;
+		}
+		if (t.Dynamic()) {
+			t.min = engine->getProfileShape(t.name.c_str(), m_profile, nvinfer1::OptProfileSelector::kMIN);
+			t.opt = engine->getProfileShape(t.name.c_str(), m_profile, nvinfer1::OptProfileSelector::kOPT);
+			t.max = engine->getProfileShape(t.name.c_str(), m_profile, nvinfer1::OptProfileSelector::kMAX);
+			///@note the largest shapes are set first, so the outputs resolve to their largest shapes too.
+			context->setInputShape(t.name.c_str(), t.max);
+		}
+		else {
+			t.min = t.opt = t.max = t.dims;
+		}
+		std::string lower(t.name);
+		std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+		if ((t.dims.nbDims == 4 || t.dims.nbDims == 5) && !m_image)t.role = TensorRole::IMAGE;
+		else if (lower.find("scale") != std::string::npos)t.role = TensorRole::SCALE_FACTOR;
+		else if (lower.find("shape") != std::string::npos)t.role = TensorRole::IM_SHAPE;
+		else t.role = TensorRole::OTHER;
+		if (t.role == TensorRole::IMAGE)m_image = &t;
+	}
+
+	for (auto &t : m_tensors) {
+		if (!t.input) {
+			t.max = context->getTensorShape(t.name.c_str());
+			for (int j = 0; j < t.max.nbDims; ++j) {
+				t.data_dependent |= t.max.d[j] < 0;
+			}
+		}
+		t.shape = t.max;
+		t.capacity = volume(t.max);
+		if (t.data_dependent) {
+			///@note the bound of the largest inputs, TensorRT writes through m_allocator and reports the shape.
+			const int64_t bytes = context->getMaxOutputSize(t.name.c_str());
+			const auto it = std::find(output_names.begin(), output_names.end(), t.name);
+			const size_t k = it - output_names.begin();
+			if (bytes >= 0) {
+				t.capacity = ((size_t)bytes + t.elem_size - 1) / t.elem_size;
+			}
+			else if (it != output_names.end() && k < output_shapes.size() && !output_shapes[k].empty()) {
+				size_t per = 1;
+				for (auto d : output_shapes[k]) {
+					per *= (size_t)std::max(0, d);
+				}
+				const size_t batch = m_image && m_image->max.nbDims > 0 ? (size_t)m_image->max.d[0] : 1;
+				t.capacity = per * batch;
+				logStream(LogLevel::WARNING) << "TensorRT cannot bound output " << t.name << ", reserving "
+											 << batch << " x " << per << " elements from OUTPUT_SHAPES" << std::endl;
+			}
+			else {
+				t.capacity = 0;
+				logStream(LogLevel::WARNING) << "TensorRT cannot bound output " << t.name
+											 << ", it is allocated on the first call" << std::endl;
+			}
+			context->setOutputAllocator(t.name.c_str(), &m_allocator);
+			if (t.capacity == 0)continue;
+		}
+		if (cudaMalloc(&t.device, t.capacity * t.elem_size) != cudaSuccess) {
+			logStream(LogLevel::ERROR) << "Allocate memory failed for tensor " << t.name << std::endl;
+			return false;
+		}
+		if (t.input) {
+			///@note inputs nothing writes into stay zero.
+			cudaMemset(t.device, 0, t.capacity * t.elem_size);
+		}
+		else if (cudaMallocHost(&t.host, t.capacity * t.elem_size) != cudaSuccess) {
+			logStream(LogLevel::ERROR) << "Allocate host memory failed for tensor " << t.name << std::endl;
+			return false;
+		}
+		if (!t.data_dependent)context->setTensorAddress(t.name.c_str(), t.device);
+	}
+
+	m_outputs.clear();
+	for (const auto &name : output_names) {
+		auto it = std::find_if(m_tensors.begin(), m_tensors.end(),
+							   [&](const TensorBinding &t) { return !t.input && t.name == name; });
+		if (it == m_tensors.end()) {
+			logStream(LogLevel::ERROR) << "Output " << name << " is not in the engine." << std::endl;
+			return false;
+		}
+		m_outputs.push_back(&*it);
+	}
+	m_batch = m_image && m_image->max.nbDims > 0 ? (int)m_image->max.d[0] : 1;
+	return true;
+}
+
+nvinfer1::Dims TensorBindings::ShapeOf(const TensorBinding &binding, int batch, int height, int width) const
+{
+	auto shape = binding.dims;
+	const bool image = binding.role == TensorRole::IMAGE;
+	const int rank = shape.nbDims;
+	if (image && rank == 5) {
+		///@note a clip input [N,T,C,H,W] takes the images as clips of T frames, T is batch if dynamic.
+		if (shape.d[1] < 0)shape.d[1] = batch;
+		batch = (batch + (int)shape.d[1] - 1) / std::max(1, (int)shape.d[1]);
+	}
+	else if (!image && m_image && m_image->dims.nbDims == 5) {
+		const int length = m_image->dims.d[1] < 0 ? batch : (int)m_image->dims.d[1];
+		batch = (batch + length - 1) / std::max(1, length);
+	}
+	for (int j = 0; j < rank; ++j) {
+		if (shape.d[j] >= 0)continue;
+		if (j == 0)shape.d[j] = batch;
+		else if (image && j == rank - 2)shape.d[j] = height;
+		else if (image && j == rank - 1)shape.d[j] = width;
+		else shape.d[j] = binding.opt.d[j];
+	}
+	return shape;
+}
+
+bool TensorBindings::SetShapes(int batch, int height, int width)
+{
+	if (!m_context)return false;
+	bool changed = false;
+	for (auto &t : m_tensors) {
+		if (!t.input)continue;
+		const auto shape = ShapeOf(t, batch, height, width);
+		for (int j = 0; j < shape.nbDims; ++j) {
+			if (shape.d[j] < t.min.d[j] || shape.d[j] > t.max.d[j]) {
+				logStream(LogLevel::ERROR) << "Shape " << dimsString(shape) << " of " << t.name << " is out of "
+										   << dimsString(t.min) << " - " << dimsString(t.max) << std::endl;
+				return false;
+			}
+		}
+		changed |= !sameDims(shape, t.shape);
+	}
+	if (!changed)return true;
+	for (auto &t : m_tensors) {
+		if (!t.input)continue;
+		t.shape = ShapeOf(t, batch, height, width);
+		if (t.Dynamic())m_context->setInputShape(t.name.c_str(), t.shape);
+	}
+	for (auto &t : m_tensors) {
+		if (!t.input && !t.data_dependent)t.shape = m_context->getTensorShape(t.name.c_str());
+	}
+	m_batch = m_image && m_image->shape.nbDims > 0 ? (int)m_image->shape.d[0] : batch;
+	return true;
+}
+
+TensorBinding *TensorBindings::FindOutput(const char *name)
+{
+	for (auto &t : m_tensors) {
+		if (!t.input && t.name == name)return &t;
+	}
+	return nullptr;
+}
+
+TensorBinding *TensorBindings::Find(TensorRole role)
+{
+	for (auto &t : m_tensors) {
+		if (t.input && t.role == role)return &t;
+	}
+	return nullptr;
+}
+
+const std::vector<TensorBinding *> &TensorBindings::Outputs() const
+{
+	return m_outputs;
+}
+
+int TensorBindings::MaxBatch() const
+{
+	if (!m_image || m_image->max.nbDims == 0)return 1;
+	if (m_image->max.nbDims == 5)return std::max(1, (int)(m_image->max.d[0] * m_image->max.d[1]));
+	return std::max(1, (int)m_image->max.d[0]);
+}
+
+int TensorBindings::Batch() const
+{
+	return m_batch;
+}
+
+int TensorBindings::ClipLength() const
+{
+	if (!m_image || m_image->shape.nbDims != 5)return 1;
+	return std::max(1, (int)m_image->shape.d[1]);
+}
+
+bool TensorBindings::DynamicBatch() const
+{
+	if (!m_image || m_image->dims.nbDims == 0)return false;
+	return m_image->dims.d[0] < 0 || (m_image->dims.nbDims == 5 && m_image->dims.d[1] < 0);
+}
+
+std::string TensorBindings::Describe() const
+{
+	static const char *roles[] = {"image", "im_shape", "scale_factor", "other", "output"};
+	std::stringstream ss;
+	ss << "profile " << m_profile;
+	for (const auto &t : m_tensors) {
+		ss << "; " << (t.input ? "input " : "output ") << t.name << " (" << roles[(int)t.role] << ") "
+		   << dimsString(t.dims) << " x" << t.elem_size << "B";
+		if (t.input && t.Dynamic()) {
+			ss << " min " << dimsString(t.min) << " opt " << dimsString(t.opt) << " max " << dimsString(t.max);
+		}
+		else if (!t.input) {
+			ss << " max " << dimsString(t.max);
+			if (t.data_dependent)ss << " data dependent, " << t.capacity << " reserved";
+		}
+	}
+	return ss.str();
+}
+
+}
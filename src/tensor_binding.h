@@ -0,0 +1,193 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <NvInfer.h>
+#include <cuda_runtime_api.h>
+
+namespace helmet
+{
+/**
+ * @brief what an engine tensor is used for, found from its rank and name.
+ */
+enum class TensorRole
+{
+	IMAGE = 0,///< the 4-D [N,C,H,W] or clip [N,T,C,H,W] input fed by the preprocessor.
+	IM_SHAPE = 1,///< [N,2] input holding the network input size, i.e. "im_shape".
+	SCALE_FACTOR = 2,///< [N,2] input holding the resize factors, i.e. "scale_factor".
+	OTHER = 3,///< any other input, zero filled.
+	OUTPUT = 4
+};
+
+/**
+ * @brief one I/O tensor of an engine and its buffers.
+ */
+struct TensorBinding
+{
+	std::string name;
+	bool input = false;
+	TensorRole role = TensorRole::OTHER;
+	nvinfer1::DataType dtype = nvinfer1::DataType::kFLOAT;
+	size_t elem_size = 4;///< bytes per element.
+	nvinfer1::Dims dims;///< as built, -1 for dynamic dimensions.
+	nvinfer1::Dims min;///< inputs only, smallest shape of the profile, equal to dims if static.
+	nvinfer1::Dims opt;///< inputs only, shape the profile is tuned for.
+	nvinfer1::Dims max;///< largest shape of the profile, for outputs as resolved from the largest inputs.
+	nvinfer1::Dims shape;///< shape of the latest call, reported by TensorRT after enqueue if data dependent.
+	size_t capacity = 0;///< elements allocated, enough for max.
+	bool data_dependent = false;///< outputs only, the shape is only known after enqueue, e.g. the boxes kept by NMS.
+	void *device = nullptr;
+	void *host = nullptr;///< pinned copy, outputs only.
+
+	/**
+	 * @brief check whether any dimension is only known per call.
+	 */
+	bool Dynamic() const;
+
+	/**
+	 * @brief get the number of elements of the latest call, clamped to capacity, 0 if not known yet.
+	 */
+	size_t Elements() const;
+};
+
+/**
+ * @brief I/O tensors of an engine, introspected instead of taken from the config by position.
+ * @details Load() reads name, data type, shape and optimization profile range of every I/O tensor, <!--
+ * --> allocates device memory for the largest shape of the profile, i.e. the maximum batch and resolution, <!--
+ * --> and binds it to the execution context, so one allocation serves every shape within the profile. <!--
+ * --> SetShapes() sets the actual batch and resolution of a call on the context and resolves the output <!--
+ * --> shapes, so only the produced elements are copied back.
+ * @example:
+ * @code
+ * 	TensorBindings bindings;
+ * 	bindings.Load(engine, context, 0, stream, config->OUTPUT_NAMES);
+ * 	bindings.SetShapes(2, 608, 608);
+ * 	context->enqueueV3(stream);
+ * 	for (auto &out : bindings.Outputs()) copy out.Elements() elements of out.device.
+ * @endcode
+ */
+class TensorBindings final
+{
+public:
+	TensorBindings() = default;
+
+	/**
+	 * @brief free the buffers, the stream using them must be synchronized.
+	 */
+	~TensorBindings();
+
+	TensorBindings(const TensorBindings &) = delete;
+	TensorBindings &operator=(const TensorBindings &) = delete;
+
+	/**
+	 * @brief introspect the engine, allocate and bind every I/O tensor.
+	 * @param engine deserialized engine.
+	 * @param context execution context of the engine.
+	 * @param profile optimization profile, clamped to the profiles of the engine.
+	 * @param stream stream the profile is switched on.
+	 * @param output_names outputs copied back, in this order; other outputs are bound but not copied.
+	 * @param output_shapes per image bounds of data dependent outputs, aligned with output_names, may be empty; <!--
+	 * --> only used if TensorRT cannot bound them.
+	 * @return false if allocation failed or a named output is not in the engine.
+	 */
+	bool Load(nvinfer1::ICudaEngine *engine, nvinfer1::IExecutionContext *context, int profile, cudaStream_t stream,
+			  const std::vector<std::string> &output_names, const std::vector<std::vector<int>> &output_shapes = {});
+
+	/**
+	 * @brief set the shapes of the next call.
+	 * @param batch images per call, split into clips of T frames for a clip input.
+	 * @param height image input height.
+	 * @param width image input width.
+	 * @return false if the shapes are outside the profile, the previous shapes are kept then.
+	 */
+	bool SetShapes(int batch, int height, int width);
+
+	/**
+	 * @brief get an input by role.
+	 * @return nullptr if the engine has none.
+	 */
+	TensorBinding *Find(TensorRole role);
+
+	/**
+	 * @brief get the outputs to be copied back, in the order of output_names.
+	 */
+	const std::vector<TensorBinding *> &Outputs() const;
+
+	/**
+	 * @brief get the largest number of images per call, N * T for a clip input, 1 without an image input.
+	 */
+	int MaxBatch() const;
+
+	/**
+	 * @brief get the leading dimension of the latest call, images or clips, what the outputs are batched by.
+	 */
+	int Batch() const;
+
+	/**
+	 * @brief get the frames per clip of the latest call, T of a clip input, 1 otherwise.
+	 */
+	int ClipLength() const;
+
+	/**
+	 * @brief check whether the images per call of the image input are dynamic.
+	 */
+	bool DynamicBatch() const;
+
+	/**
+	 * @brief get a readable summary of every tensor, for logging.
+	 */
+	std::string Describe() const;
+
+private:
+	/**
+	 * @brief hands the buffers of data dependent outputs to TensorRT, grows them if needed and records their shapes.
+	 */
+	class OutputAllocator final : public nvinfer1::IOutputAllocator
+	{
+	public:
+		explicit OutputAllocator(TensorBindings &owner)
+			: m_owner(owner)
+		{
+		}
+
+		void *reallocateOutput(const char *name, void *memory, uint64_t size, uint64_t alignment) noexcept override;
+
+		void notifyShape(const char *name, const nvinfer1::Dims &dims) noexcept override;
+
+	private:
+		TensorBindings &m_owner;
+	};
+
+	/**
+	 * @brief build the shape of an input for the given batch and resolution.
+	 */
+	nvinfer1::Dims ShapeOf(const TensorBinding &binding, int batch, int height, int width) const;
+
+	/**
+	 * @brief get an output by name.
+	 * @return nullptr if the engine has none.
+	 */
+	TensorBinding *FindOutput(const char *name);
+
+private:
+	nvinfer1::IExecutionContext *m_context = nullptr;
+	std::vector<TensorBinding> m_tensors;
+	std::vector<TensorBinding *> m_outputs;
+	TensorBinding *m_image = nullptr;
+	int m_profile = 0;
+	int m_batch = 1;
+	OutputAllocator m_allocator{*this};
+};
+
+/**
+ * @brief get the size of an engine data type.
+ * @return bytes per element, 0 if unknown.
+ */
+extern size_t dataTypeSize(nvinfer1::DataType dtype);
+
+/**
+ * @brief format dims as "[1,3,608,608]".
+ */
+extern std::string dimsString(const nvinfer1::Dims &dims);
+
+}
@@ -0,0 +1,150 @@
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+#include "tensor_pack.h"
+
+namespace helmet
+{
+
+bool parseTensorType(const std::string &name, TensorType &type)
+{
+	std::string lower(name);
+	std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+	if (lower == "float32" || lower == "float") {
+		type = TensorType::FLOAT32;
+		return true;
+	}
+	if (lower == "float16" || lower == "half") {
+		type = TensorType::FLOAT16;
+		return true;
+	}
+	if (lower == "uint8") {
+		type = TensorType::UINT8;
+		return true;
+	}
+	return false;
+}
+
+size_t tensorTypeSize(TensorType type)
+{
+	switch (type) {
+		case TensorType::FLOAT16:
+			return 2;
+		case TensorType::UINT8:
+			return 1;
+		default:
+			return 4;
+	}
+}
+
+const char *tensorTypeName(TensorType type)
+{
+	switch (type) {
+		case TensorType::FLOAT16:
+			return "float16";
+		case TensorType::UINT8:
+			return "uint8";
+		default:
+			return "float32";
+	}
+}
+
+/**
+ * @brief scalar float to half, round to nearest even, overflow to infinity.
+ */
+static uint16_t floatToHalfScalar(float value)
+{
+	uint32_t f;
+	std::memcpy(&f, &value, sizeof(f));
+	const uint32_t sign = (f >> 16) & 0x8000u;
+	const uint32_t abs = f & 0x7fffffffu;
+	if (abs >= 0x7f800000u) {
+		///@note infinity stays infinity, NaN keeps a quiet payload.
+		return (uint16_t)(sign | 0x7c00u | (abs > 0x7f800000u ? 0x0200u : 0u));
+	}
+	if (abs >= 0x477ff000u) {
+		return (uint16_t)(sign | 0x7c00u);
+	}
+	if (abs < 0x38800000u) {
+		///@note subnormal half, shift the mantissa with the implicit bit and round.
+		if (abs < 0x33000000u)return (uint16_t)sign;
+		const uint32_t exp = abs >> 23;
+		const uint32_t mant = (abs & 0x7fffffu) | 0x800000u;
+		const uint32_t shift = 126u - exp;
+		uint32_t h = mant >> shift;
+		const uint32_t rem = mant & ((1u << shift) - 1u);
+		const uint32_t half = 1u << (shift - 1u);
+		if (rem > half || (rem == half && (h & 1u)))h++;
+		return (uint16_t)(sign | h);
+	}
+	uint32_t h = ((abs - 0x38000000u) >> 13);
+	const uint32_t rem = abs & 0x1fffu;
+	if (rem > 0x1000u || (rem == 0x1000u && (h & 1u)))h++;
+	return (uint16_t)(sign | h);
+}
+
+float halfToFloat(uint16_t h)
+{
+	const uint32_t sign = (uint32_t)(h & 0x8000u) << 16;
+	uint32_t exp = (h >> 10) & 0x1fu;
+	uint32_t mant = h & 0x3ffu;
+	uint32_t f;
+	if (exp == 0) {
+		if (mant == 0) {
+			f = sign;
+		}
+		else {
+			///@note normalize the subnormal.
+			exp = 113;
+			while (!(mant & 0x400u)) {
+				mant <<= 1;
+				exp--;
+			}
+			f = sign | (exp << 23) | ((mant & 0x3ffu) << 13);
+		}
+	}
+	else if (exp == 0x1f) {
+		f = sign | 0x7f800000u | (mant << 13);
+	}
+	else {
+		f = sign | ((exp + 112u) << 23) | (mant << 13);
+	}
+	float value;
+	std::memcpy(&value, &f, sizeof(value));
+	return value;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx,f16c")))
+static size_t floatToHalfF16C(const float *src, uint16_t *dst, size_t n)
+{
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		__m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT);
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), h);
+	}
+	return i;
+}
+#endif
+
+void floatToHalf(const float *src, uint16_t *dst, size_t n)
+{
+	size_t i = 0;
+#if defined(__x86_64__) || defined(__i386__)
+	static const bool f16c = __builtin_cpu_supports("f16c") && __builtin_cpu_supports("avx");
+	if (f16c)i = floatToHalfF16C(src, dst, n);
+#elif defined(__aarch64__)
+	for (; i < n; ++i) {
+		__fp16 h = (__fp16)src[i];
+		std::memcpy(dst + i, &h, sizeof(h));
+	}
+#endif
+	for (; i < n; ++i) {
+		dst[i] = floatToHalfScalar(src[i]);
+	}
+}
+
+}
@@ -0,0 +1,57 @@
+#include <cuda_fp16.h>
+#include "tensor_pack.h"
+
+namespace helmet
+{
+
+template<typename T>
+__device__ T castElement(float value);
+
+template<>
+__device__ __half castElement<__half>(float value)
+{
+	return __float2half_rn(value);
+}
+
+template<>
+__device__ unsigned char castElement<unsigned char>(float value)
+{
+	return (unsigned char)fminf(fmaxf(rintf(value), 0.0f), 255.0f);
+}
+
+/**
+ * @brief one thread per pixel, reads the interleaved pixel once and writes one element per plane.
+ */
+template<typename T>
+__global__ void packPlanarKernel(const float *src, size_t step, int width, int height, T *dst)
+{
+	const int x = blockIdx.x * blockDim.x + threadIdx.x;
+	const int y = blockIdx.y * blockDim.y + threadIdx.y;
+	if (x >= width || y >= height)return;
+	const float *row = reinterpret_cast<const float *>(reinterpret_cast<const char *>(src) + y * step);
+	const size_t plane = (size_t)width * height;
+	const size_t k = (size_t)y * width + x;
+	dst[k] = castElement<T>(row[3 * x]);
+	dst[plane + k] = castElement<T>(row[3 * x + 1]);
+	dst[2 * plane + k] = castElement<T>(row[3 * x + 2]);
+}
+
+cudaError_t packPlanarOnGpu(const float *src, size_t step, int width, int height,
+							TensorType type, void *dst, cudaStream_t stream)
+{
+	const dim3 block(32, 8);
+	const dim3 grid((width + block.x - 1) / block.x, (height + block.y - 1) / block.y);
+	if (type == TensorType::FLOAT16) {
+		packPlanarKernel<__half><<<grid, block, 0, stream>>>(src, step, width, height, static_cast<__half *>(dst));
+	}
+	else if (type == TensorType::UINT8) {
+		packPlanarKernel<unsigned char><<<grid, block, 0, stream>>>(src, step, width, height,
+																	static_cast<unsigned char *>(dst));
+	}
+	else {
+		return cudaErrorInvalidValue;
+	}
+	return cudaGetLastError();
+}
+
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <cuda_runtime_api.h>
+
+namespace helmet
+{
+/**
+ * @brief element type of the image input tensor.
+ */
+enum class TensorType
+{
+	FLOAT32 = 0,///< normalized float, the default of exported models.
+	FLOAT16 = 1,///< normalized half precision float.
+	UINT8 = 2 ///< raw pixels, the normalization is folded into the model.
+};
+
+/**
+ * @brief parse a tensor type name, i.e. "float32", "float16" or "uint8".
+ * @param name type name, case insensitive.
+ * @param type parsed type, unchanged if the name is unknown.
+ * @return true if parsed.
+ */
+extern bool parseTensorType(const std::string &name, TensorType &type);
+
+/**
+ * @brief get the size in bytes of one element.
+ */
+extern size_t tensorTypeSize(TensorType type);
+
+/**
+ * @brief get the name of a tensor type.
+ */
+extern const char *tensorTypeName(TensorType type);
+
+/**
+ * @brief convert float to IEEE half precision on CPU.
+ * @details F16C is used if the CPU supports it, selected at runtime, thus the build flags are unchanged; <!--
+ * --> the native __fp16 conversion is used on aarch64, otherwise a scalar round to nearest even.
+ * @param src input floats.
+ * @param dst output halves.
+ * @param n number of elements.
+ */
+extern void floatToHalf(const float *src, uint16_t *dst, size_t n);
+
+/**
+ * @brief convert IEEE half precision to float on CPU, mainly for checking.
+ * @param h half precision bits.
+ * @return float value.
+ */
+extern float halfToFloat(uint16_t h);
+
+/**
+ * @brief pack an interleaved 3 channel float image on GPU into a planar [C,H,W] tensor.
+ * @details FLOAT16 converts with round to nearest, UINT8 rounds and saturates, i.e. the input is expected <!--
+ * --> not normalized. The channel order is kept.
+ * @param src device pointer of a CV_32FC3 image.
+ * @param step row pitch of src in bytes.
+ * @param width image width.
+ * @param height image height.
+ * @param type FLOAT16 or UINT8, FLOAT32 is split by OpenCV instead.
+ * @param dst device pointer of the tensor, 3 * width * height elements of type.
+ * @param stream cuda stream.
+ * @return cuda error of the launch.
+ */
+extern cudaError_t packPlanarOnGpu(const float *src, size_t step, int width, int height,
+								   TensorType type, void *dst, cudaStream_t stream);
+
+}
@@ -0,0 +1,189 @@
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include "trace.h"
+
+namespace helmet
+{
+
+/**
+ * @brief buffer and name of the current thread, the buffer is retired when the thread exits.
+ */
+struct TraceLocal
+{
+	TraceBuffer *buf = nullptr;
+	std::string name;
+
+	~TraceLocal()
+	{
+		if (buf)Tracer::Instance().Retire(buf);
+	}
+};
+
+static thread_local TraceLocal t_local;
+
+Tracer &Tracer::Instance()
+{
+	static Tracer tracer;
+	return tracer;
+}
+
+Tracer::Tracer()
+{
+	m_epoch = std::chrono::steady_clock::now();
+}
+
+Tracer::~Tracer()
+{
+	///@note threads still running at exit stop recording new rings, the ones recording are read safely.
+	SetEnabled(false);
+	if (!m_export_file.empty()) {
+		Export(m_export_file);
+	}
+}
+
+void Tracer::SetEnabled(bool enable)
+{
+	m_enabled.store(enable, std::memory_order_relaxed);
+}
+
+void Tracer::SetSampling(int every_n)
+{
+	m_sampling.store(every_n > 0 ? every_n : 1, std::memory_order_relaxed);
+}
+
+void Tracer::SetBufferCapacity(size_t events)
+{
+	std::lock_guard<std::mutex> lock(m_mtx);
+	m_capacity = events > 0 ? events : 1;
+}
+
+void Tracer::SetExportFile(const std::string &file)
+{
+	std::lock_guard<std::mutex> lock(m_mtx);
+	m_export_file = file;
+}
+
+TraceBuffer *Tracer::Local()
+{
+	auto &local = t_local;
+	if (local.buf)return local.buf;
+	auto buf = createSharedRef<TraceBuffer>();
+	std::lock_guard<std::mutex> lock(m_mtx);
+	///@note the ring of the earliest exited thread is reused, its events are dropped.
+	auto it = std::find_if(m_buffers.begin(), m_buffers.end(),
+						   [](const SharedRef<TraceBuffer> &b) { return b->retired; });
+	if (it != m_buffers.end()) {
+		buf->events = std::move((*it)->events);
+		m_buffers.erase(it);
+	}
+	buf->tid = m_next_tid++;
+	buf->name = local.name.empty() ? "thread-" + std::to_string(buf->tid) : local.name;
+	///@note the slots of a reused ring hold older sequence numbers only, they never match the new events.
+	if (buf->events.size() != m_capacity) {
+		buf->events = std::vector<TraceEvent>(m_capacity);
+	}
+	m_buffers.push_back(buf);
+	local.buf = buf.get();
+	return local.buf;
+}
+
+void Tracer::Retire(TraceBuffer *buf)
+{
+	std::lock_guard<std::mutex> lock(m_mtx);
+	auto it = std::find_if(m_buffers.begin(), m_buffers.end(),
+						   [buf](const SharedRef<TraceBuffer> &b) { return b.get() == buf; });
+	if (it == m_buffers.end())return;
+	if ((*it)->written.load(std::memory_order_relaxed) == 0) {
+		m_buffers.erase(it);
+		return;
+	}
+	(*it)->retired = true;
+}
+
+void Tracer::SetThreadName(const std::string &name)
+{
+	auto &local = t_local;
+	local.name = name;
+	if (!local.buf)return;
+	std::lock_guard<std::mutex> lock(m_mtx);
+	local.buf->name = name;
+}
+
+void Tracer::Record(const char *name, uint64_t ts, uint64_t dur, int stream, int64_t frame)
+{
+	auto *buf = t_local.buf;
+	if (!buf) {
+		if (!Enabled())return;
+		buf = Local();
+	}
+	auto n = buf->written.load(std::memory_order_relaxed);
+	auto &ev = buf->events[n % buf->events.size()];
+	ev.seq.store(2 * n + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	ev.name.store(name, std::memory_order_relaxed);
+	ev.ts.store(ts, std::memory_order_relaxed);
+	ev.dur.store(dur, std::memory_order_relaxed);
+	ev.stream.store(stream, std::memory_order_relaxed);
+	ev.frame.store(frame, std::memory_order_relaxed);
+	ev.seq.store(2 * n + 2, std::memory_order_release);
+	buf->written.store(n + 1, std::memory_order_release);
+}
+
+void Tracer::Export(std::ostream &os)
+{
+	std::lock_guard<std::mutex> lock(m_mtx);
+	os << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	bool first = true;
+	for (const auto &buf : m_buffers) {
+		if (!first)os << ",";
+		first = false;
+		os << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buf->tid
+		   << ",\"args\":{\"name\":\"" << buf->name << "\"}}";
+		auto written = buf->written.load(std::memory_order_acquire);
+		auto cap = buf->events.size();
+		auto begin = std::max(written > cap ? written - cap : 0, buf->cleared.load(std::memory_order_relaxed));
+		for (auto i = begin; i < written; ++i) {
+			const auto &ev = buf->events[i % cap];
+			///@note a slot already holding a newer event, or being written, is skipped.
+			const auto seq = ev.seq.load(std::memory_order_acquire);
+			if (seq != 2 * i + 2)continue;
+			const char *name = ev.name.load(std::memory_order_relaxed);
+			const auto ts = ev.ts.load(std::memory_order_relaxed);
+			const auto dur = ev.dur.load(std::memory_order_relaxed);
+			const int stream = ev.stream.load(std::memory_order_relaxed);
+			const auto frame = ev.frame.load(std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (ev.seq.load(std::memory_order_relaxed) != seq || !name)continue;
+			os << ",{\"name\":\"" << name << "\",\"cat\":\"stream" << stream
+			   << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buf->tid
+			   << ",\"ts\":" << ts << ",\"dur\":" << dur
+			   << ",\"args\":{\"stream\":" << stream << ",\"frame\":" << frame << "}}";
+		}
+	}
+	os << "]}" << std::endl;
+}
+
+bool Tracer::Export(const std::string &file)
+{
+	std::ofstream out(file, std::ios::out | std::ios::trunc);
+	if (!out) {
+		std::cerr << "Cannot write trace to: " << file << std::endl;
+		return false;
+	}
+	Export(out);
+	return true;
+}
+
+void Tracer::Clear()
+{
+	std::lock_guard<std::mutex> lock(m_mtx);
+	m_buffers.erase(std::remove_if(m_buffers.begin(), m_buffers.end(),
+								   [](const SharedRef<TraceBuffer> &b) { return b->retired; }), m_buffers.end());
+	///@note written belongs to the owner thread, only the watermark the exporter starts from is moved.
+	for (auto &buf : m_buffers) {
+		buf->cleared.store(buf->written.load(std::memory_order_acquire), std::memory_order_relaxed);
+	}
+}
+
+}
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "util.h"
+
+namespace helmet
+{
+/**
+ * @brief one complete event, i.e. begin timestamp plus duration.
+ * @details the slot is guarded by a sequence number like a seqlock, so the exporter can read it while <!--
+ * --> the owner overwrites it: a copy is only kept if seq was 2n+2 for the expected event n before and after.
+ */
+struct TraceEvent
+{
+	std::atomic<uint64_t> seq{0};///< 2n+1 while event n is being written, 2n+2 once it is complete.
+	std::atomic<const char *> name{nullptr};///< static string, e.g. stage name.
+	std::atomic<uint64_t> ts{0};///< begin timestamp in us since tracer epoch.
+	std::atomic<uint64_t> dur{0};///< duration in us.
+	std::atomic_int stream{-1};///< stream id, -1 if unknown.
+	std::atomic<int64_t> frame{-1};///< frame index, -1 if unknown.
+};
+
+/**
+ * @brief per thread event buffer, written by its owner thread only.
+ * @details this is a fixed size ring, the oldest events are overwritten if it is full, thus memory is bounded.
+ */
+struct TraceBuffer
+{
+	int tid = 0;///< sequential thread id used in trace file.
+	std::string name;///< thread name shown in trace viewer.
+	std::vector<TraceEvent> events;
+	std::atomic<uint64_t> written = 0;///< total events ever written, only the owner changes it.
+	std::atomic<uint64_t> cleared = 0;///< events before this one were dropped by Clear().
+	bool retired = false;///< the owner thread exited, guarded by the tracer lock.
+};
+
+struct TraceLocal;
+
+/**
+ * @brief process wide tracer exporting Chrome trace-event JSON, which can be loaded by Perfetto or chrome://tracing.
+ * @details events are recorded into thread local ring buffers without any lock, the registry lock is only taken <!--
+ * --> once per thread on its first event and while exporting. Tracing can be switched on and off at runtime and <!--
+ * --> sampled by frame index. A ring is only allocated on the first event a thread records while tracing is on. <!--
+ * --> The ring of an exited thread is kept for export until a new thread needs one, then it is reused, so <!--
+ * --> memory is bounded by the threads tracing at the same time.
+ * @note exporting and clearing while streams are running is allowed, events overwritten during the export are <!--
+ * --> skipped instead of torn, and clearing only moves a watermark, the writers' indices are never touched.
+ * @example:
+ * @code
+ * 	Tracer::Instance().SetSampling(10);
+ * 	Tracer::Instance().SetEnabled(true);
+ * 	...
+ * 	Tracer::Instance().Export("trace.json");
+ * @endcode
+ */
+class Tracer final
+{
+public:
+	static Tracer &Instance();
+
+	/**
+	 * @brief export the events if an export file is set.
+	 */
+	~Tracer();
+
+	/**
+	 * @brief switch tracing on or off.
+	 */
+	void SetEnabled(bool enable);
+
+	/**
+	 * @brief query tracing switch, this is cheap enough for hot path.
+	 */
+	bool Enabled() const
+	{
+		return m_enabled.load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * @brief only trace one in every n frames.
+	 * @param every_n sampling interval, 1 to trace every frame.
+	 */
+	void SetSampling(int every_n);
+
+	/**
+	 * @brief check whether a frame should be traced.
+	 * @param frame frame index, events not bound to a frame are always traced.
+	 * @return true if tracing is on and the frame is sampled.
+	 */
+	bool Sampled(int64_t frame) const
+	{
+		if (!Enabled())return false;
+		return frame < 0 || frame % m_sampling.load(std::memory_order_relaxed) == 0;
+	}
+
+	/**
+	 * @brief set capacity of buffers created afterwards.
+	 * @param events number of events per thread.
+	 */
+	void SetBufferCapacity(size_t events);
+
+	/**
+	 * @brief set the file events are exported to at exit.
+	 * @param file JSON file, empty to disable exporting at exit.
+	 */
+	void SetExportFile(const std::string &file);
+
+	/**
+	 * @brief name the current thread in trace viewer, no buffer is allocated for it.
+	 * @param name thread name.
+	 */
+	void SetThreadName(const std::string &name);
+
+	/**
+	 * @brief record a complete event on current thread.
+	 * @param name static event name.
+	 * @param ts begin timestamp from Now().
+	 * @param dur duration in us.
+	 * @param stream stream id.
+	 * @param frame frame index.
+	 */
+	void Record(const char *name, uint64_t ts, uint64_t dur, int stream, int64_t frame);
+
+	/**
+	 * @brief write all buffered events as Chrome trace-event JSON.
+	 * @param os output stream.
+	 */
+	void Export(std::ostream &os);
+
+	/**
+	 * @brief write all buffered events to a file.
+	 * @param file JSON file.
+	 * @return true if written.
+	 */
+	bool Export(const std::string &file);
+
+	/**
+	 * @brief drop all buffered events and the buffers of exited threads.
+	 */
+	void Clear();
+
+	/**
+	 * @brief get timestamp.
+	 * @return us since tracer epoch.
+	 */
+	uint64_t Now() const
+	{
+		return std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::steady_clock::now() - m_epoch).count();
+	}
+
+private:
+	Tracer();
+
+	/**
+	 * @brief get buffer of current thread, created on first use.
+	 */
+	TraceBuffer *Local();
+
+	/**
+	 * @brief mark the buffer of an exiting thread for reuse, dropped at once if it holds no event.
+	 */
+	void Retire(TraceBuffer *buf);
+
+	friend struct TraceLocal;
+
+private:
+	std::atomic_bool m_enabled = false;
+	std::atomic_int m_sampling = 1;
+	std::chrono::steady_clock::time_point m_epoch;
+	std::mutex m_mtx;
+	std::vector<SharedRef<TraceBuffer>> m_buffers;///< buffers outlive their threads until reused.
+	size_t m_capacity = 16384;
+	int m_next_tid = 1;
+	std::string m_export_file;
+};
+
+}
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 #include <NvInferPlugin.h>
@@ -5,6 +6,8 @@
 #include <opencv2/cudaarithm.hpp>
 #include "trt_deploy.h"
 #include "util.h"
+#include "latency_stats.h"
+#include "log.h"
 #include <opencv2/core/cuda.hpp>
 #include <thread>
 
@@ -21,10 +24,48 @@ std::atomic_int m_thread_num = 0;
 
 void Logger::log(nvinfer1::ILogger::Severity severity, const char *msg) noexcept
 {
-	if (severity == Severity::kINFO||severity==Severity::kVERBOSE||severity==Severity::kWARNING){
-		std::cout << msg << std::endl;
-	}else{
-		std::cerr<<msg<<std::endl;
+	LogLevel level = LogLevel::FATAL;
+	switch (severity) {
+		case Severity::kVERBOSE:
+			level = LogLevel::VERBOSE;
+			break;
+		case Severity::kINFO:
+			level = LogLevel::INFO;
+			break;
+		case Severity::kWARNING:
+			level = LogLevel::WARNING;
+			break;
+		case Severity::kERROR:
+			level = LogLevel::ERROR;
+			break;
+		default:
+			break;
+	}
+	///@note checked before formatting, TensorRT is quite verbose.
+	if (!AsyncLogger::Instance().Enabled(level))return;
+	AsyncLogger::Instance().Write(level, msg);
+}
+
+/**
+ * @brief map the engine data type of the image input.
+ * @param dtype engine data type.
+ * @param type mapped type.
+ * @return false if the type cannot be fed by the preprocessor.
+ */
+static bool toTensorType(nvinfer1::DataType dtype, TensorType &type)
+{
+	switch (dtype) {
+		case nvinfer1::DataType::kFLOAT:
+			type = TensorType::FLOAT32;
+			return true;
+		case nvinfer1::DataType::kHALF:
+			type = TensorType::FLOAT16;
+			return true;
+		case nvinfer1::DataType::kUINT8:
+			type = TensorType::UINT8;
+			return true;
+		default:
+			return false;
 	}
 }
 
@@ -35,6 +76,10 @@ TrtDeploy::TrtDeploy(SharedRef<Config> &config, int gpuID)
 	m_cuda_alloc_status = CudaMemAllocStatus::NON_ALLOC;
 	m_curr_fps = 0.0f;
 	m_gpu_id = gpuID;
+	m_input_size = cv::Size(m_config->TARGET_SIZE[m_config->TARGET_SIZE.size() - 1],
+							m_config->TARGET_SIZE[m_config->TARGET_SIZE.size() - 2]);
+	///@note created up front so thresholds can be set before the first inference, its worker is still lazy.
+	m_postprocessor = createSharedRef<Postprocessor>(m_config);
 	{
 		std::lock_guard<std::mutex> lock(m_mtx);
 		m_thread_num++;
@@ -43,13 +88,8 @@ TrtDeploy::TrtDeploy(SharedRef<Config> &config, int gpuID)
 
 TrtDeploy::~TrtDeploy()
 {
+	///@note the buffers are freed by m_bindings once the stream is done with them.
 	cudaStreamSynchronize(m_stream);
-	for (auto &i : m_device_ptr) {
-		cudaFree(i);
-	}
-	for (auto &i : m_host_ptr) {
-		cudaFreeHost(i);
-	}
 	if (m_execution_context) {
 		delete m_execution_context;
 		m_execution_context = nullptr;
@@ -62,24 +102,22 @@ TrtDeploy::~TrtDeploy()
 		delete m_runtime;
 		m_runtime = nullptr;
 	}
+	int remaining = 0;
 	{
 		std::lock_guard<std::mutex> lock(m_mtx);
-		m_thread_num--;
-		std::cout << "Current remaining runtime ref count: " << m_thread_num << std::endl;
-		if (m_thread_num == 0) {
-
-			std::cout << "Free the runtime done..." << std::endl;
-		}
+		remaining = --m_thread_num;
 	}
-	std::cout << "Thread: " << std::this_thread::get_id() <<
-			  " TensorRT Backend Deconstructed..." << std::endl;
+	///@note logged out of the lock, other instances may be destructing at the same time.
+	logStream(LogLevel::INFO) << "Current remaining runtime ref count: " << remaining;
+	if (remaining == 0) {
+		logStream(LogLevel::INFO) << "Free the runtime done...";
+	}
+	logStream(LogLevel::INFO) << "Thread: " << std::this_thread::get_id() << " TensorRT Backend Deconstructed...";
 
 }
 
 void TrtDeploy::Infer(const cv::Mat &img, SharedRef<TrtResults> &result)
 {
-//        std::chrono::high_resolution_clock::time_point curr_time =
-//                std::chrono::high_resolution_clock::now();
 	if (!INIT_FLAG) {
 		Init(m_config->MODEL_NAME);
 		INIT_FLAG = true;
@@ -88,20 +126,135 @@ void TrtDeploy::Infer(const cv::Mat &img, SharedRef<TrtResults> &result)
 	auto blob = createSharedRef<ImageBlob>();
 	std::vector<cv::Mat> temp;
 	temp.push_back(img);
-	m_preprocessor->Run(temp, blob, m_thread_stream);
-//        auto dur = std::chrono::high_resolution_clock::now() - curr_time;
-//        curr_time = std::chrono::high_resolution_clock::now();
-//        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(dur).count();
-//        std::cout << "Thread: " << std::this_thread::get_id() << " Pre taken: " << ms << "ms" << std::endl;
+	{
+		StageTimer timer(Stage::PREPROCESS);
+		m_preprocessor->Run(temp, blob, m_thread_stream);
+	}
+	StageTimer timer(Stage::INFER);
+	if (m_ring.Length() > 1) {
+		InferClip(blob, result);
+		return;
+	}
+	InferResults(blob, result);
+}
+
+void TrtDeploy::Infer(const cv::Mat &img, PixelFormat format, const cv::Mat &mask, SharedRef<TrtResults> &result)
+{
+	if (!INIT_FLAG) {
+		Init(m_config->MODEL_NAME);
+		INIT_FLAG = true;
+	}
 
+	auto blob = createSharedRef<ImageBlob>();
+	std::vector<cv::Mat> temp;
+	temp.push_back(img);
+	{
+		StageTimer timer(Stage::PREPROCESS);
+		m_preprocessor->Run(temp, blob, m_thread_stream, format, mask);
+	}
+	StageTimer timer(Stage::INFER);
+	if (m_ring.Length() > 1) {
+		InferClip(blob, result);
+		return;
+	}
 	InferResults(blob, result);
 }
 
+void TrtDeploy::InferClip(SharedRef<ImageBlob> &data, SharedRef<TrtResults> &res)
+{
+	if (data->m_gpu_data.empty() || !m_ring.Push(data->m_gpu_data[0], *m_thread_stream))return;
+	if (!m_clip_blob) {
+		m_clip_blob = createSharedRef<ImageBlob>();
+	}
+	if (!m_batch_result) {
+		m_batch_result = createSharedRef<TrtResults>(m_config);
+	}
+	m_ring.Clip(m_clip_blob->m_gpu_data);
+	InferResults(m_clip_blob, m_batch_result);
+	///@note a static batch runs more items than the clip fills, the result is the item of the newest frame.
+	const int length = m_bindings.ClipLength();
+	const int item = (m_ring.Size() + length - 1) / length - 1;
+	Scatter(m_batch_result, &res, 1, (size_t)std::max(0, item));
+}
+
+void TrtDeploy::InferBatch(const std::vector<cv::Mat> &imgs, std::vector<SharedRef<TrtResults>> &results)
+{
+	if (!INIT_FLAG) {
+		Init(m_config->MODEL_NAME);
+		INIT_FLAG = true;
+	}
+	if (!m_batch_result) {
+		m_batch_result = createSharedRef<TrtResults>(m_config);
+	}
+	const size_t batch = std::max(1, m_max_batch);
+	std::vector<cv::Mat> chunk;
+	for (size_t first = 0; first < imgs.size(); first += batch) {
+		const size_t count = std::min(batch, imgs.size() - first);
+		chunk.assign(imgs.begin() + first, imgs.begin() + first + count);
+		auto blob = createSharedRef<ImageBlob>();
+		{
+			StageTimer timer(Stage::PREPROCESS);
+			m_preprocessor->Run(chunk, blob, m_thread_stream);
+		}
+		StageTimer timer(Stage::INFER);
+		InferResults(blob, m_batch_result);
+		Scatter(m_batch_result, results.data() + first, count);
+	}
+}
+
+void TrtDeploy::Scatter(const SharedRef<TrtResults> &batch, SharedRef<TrtResults> *results, size_t count, size_t first)
+{
+	///@note rows decoded by the postprocessor per image.
+	const size_t det_rows = 100;
+	const auto &names = m_config->OUTPUT_NAMES;
+	const bool by_count = m_config->NMS_MODE != "host" && names.size() > 1;
+	std::vector<float> data;
+	std::vector<float> counts;
+	if (by_count)batch->Get(names[1], counts);
+	for (size_t i = 0; i < count; ++i) {
+		results[i]->Clear();
+	}
+	for (size_t o = 0; o < names.size(); ++o) {
+		batch->Get(names[o], data);
+		if (by_count && o == 0) {
+			///@note multiclass_nms3 concatenates the kept boxes of all images, the counts give the split.
+			const size_t total_rows = data.size() / 6;
+			const size_t item_rows = std::max(det_rows, total_rows / (size_t)std::max(1, m_run_batch));
+			size_t offset = 0;
+			for (size_t i = 0; i < first + count; ++i) {
+				size_t num = i < counts.size() ? (size_t)std::max(0.0f, counts[i]) : 0;
+				num = std::min({num, item_rows, total_rows - std::min(offset, total_rows)});
+				if (i < first) {
+					offset += num;
+					continue;
+				}
+				std::vector<float> item(item_rows * 6, 0.0f);
+				std::copy_n(data.begin() + std::min(offset, total_rows) * 6, num * 6, item.begin());
+				for (size_t j = num; j < item_rows; ++j) {
+					item[j * 6] = -1.0f;
+				}
+				offset += num;
+				results[i - first]->Set(std::make_pair(names[o], std::move(item)));
+			}
+			continue;
+		}
+		const size_t per = data.size() / (size_t)std::max(1, m_run_batch);
+		for (size_t i = 0; i < count; ++i) {
+			const size_t k = std::min(first + i, (size_t)std::max(1, m_run_batch) - 1);
+			std::vector<float> item(data.begin() + k * per, data.begin() + (k + 1) * per);
+			results[i]->Set(std::make_pair(names[o], std::move(item)));
+		}
+	}
+	for (size_t i = 0; i < count; ++i) {
+		results[i]->Stamp(batch->Time(), batch->InputSize());
+	}
+}
+
 void TrtDeploy::Init(const std::string &model_file)
 {
 	std::ifstream ai_model(model_file, std::ios::in | std::ios::binary);
 	if (!ai_model) {
-		std::cerr << "Read serialized file: " << model_file << " failed" << std::endl;
+		logStream(LogLevel::ERROR) << "Read serialized file: " << model_file << " failed" << std::endl;
 		m_model_load_status = ModelLoadStatus::LOADED_FAILED;
 		return;
 	}
@@ -109,11 +262,12 @@ void TrtDeploy::Init(const std::string &model_file)
 	std::vector<char> buf(mSize);
 	ai_model.read(&buf[0], mSize);
 	ai_model.close();
-	std::cout << "Model size: " << mSize << std::endl;
+	logStream(LogLevel::INFO) << "Model size: " << mSize << std::endl;
 	m_config->MODEL_NAME = model_file;
 	m_model_load_status = ModelLoadStatus::LOADED_SUCCESS;
 	if (!m_preprocessor) {
 		m_preprocessor = createSharedRef<Preprocessor>(m_config);
+		m_preprocessor->SetTargetSize(m_input_size);
 	}
 	if (!m_postprocessor) {
 		m_postprocessor = createSharedRef<Postprocessor>(m_config);
@@ -127,59 +281,10 @@ void TrtDeploy::Init(const std::string &model_file)
 			m_engine = m_runtime->deserializeCudaEngine((void *)&buf[0],
 														mSize);
 		if (!m_execution_context)m_execution_context = m_engine->createExecutionContext();
-		printf("Logger: %p; Runtime: %p; Engine: %p; Context: %p\n",
-			   &m_logger, &m_runtime, &m_engine, &m_execution_context);
-	}
-
-	///note the target size should match the model input.
-	std::vector<int> input_size;
-	int in_size = 1;
-	auto entry_num = m_config->INPUT_NAME.size();
-	auto out_num = m_config->OUTPUT_NAMES.size();
-	for (int i = 0; i < entry_num; ++i) {
-		auto in_dims = m_engine->getTensorShape(m_config->INPUT_NAME[i].c_str());
-		int curr = 1;
-		for (int j = 0; j < in_dims.nbDims; ++j) {
-			curr *= in_dims.d[j];
-		}
-		in_size *= curr;
-		input_size.push_back(curr);
-	}
-	m_host_size.resize(out_num, 0);
-	m_host_ptr.resize(out_num, nullptr);
-	m_device_ptr.resize(entry_num + out_num, nullptr);//with input pointer, thus+1.
-	for (int i = 0; i < out_num; ++i) {
-		auto out_dims_i = m_engine->getTensorShape(m_config->OUTPUT_NAMES[i].c_str());
-		int out_size = 1;
-		for (int j = 0; j < out_dims_i.nbDims; ++j) {
-			if (out_dims_i.d[j] > 0)out_size *= out_dims_i.d[j];
-			else out_size *= -out_dims_i.d[j];
-		}
-		cudaMallocHost(&m_host_ptr[i], out_size * sizeof(float));
-		m_host_size[i] = out_size;
+		logStream(LogLevel::VERBOSE) << "Logger: " << m_logger.get() << "; Runtime: " << m_runtime
+									 << "; Engine: " << m_engine << "; Context: " << m_execution_context;
 	}
 
-	cudaError_t state;
-	for (int i = 0; i < entry_num; ++i) {
-		state = cudaMalloc(&m_device_ptr[i],
-						   input_size[i] * sizeof(float));
-		if (state) {
-			std::cout << "Allocate memory failed" << std::endl;
-			m_cuda_alloc_status = CudaMemAllocStatus::ALLOC_FAILED;
-			return;
-		}
-	}
-	for (auto i = entry_num; i < entry_num + out_num; ++i) {
-		state = cudaMalloc(&m_device_ptr[i],
-						   m_host_size[i - entry_num] * sizeof(float));
-		if (state) {
-			std::cout << "Allocate memory failed" << std::endl;
-			m_cuda_alloc_status = CudaMemAllocStatus::ALLOC_FAILED;
-			return;
-		}
-	}
-	m_cuda_alloc_status = CudaMemAllocStatus::ALLOC_SUCCESS;
-
 	if (!m_thread_stream) {
 		m_thread_stream = createSharedRef<cv::cuda::Stream>(cudaStreamNonBlocking);
 	}
@@ -187,46 +292,116 @@ void TrtDeploy::Init(const std::string &model_file)
 		m_stream = static_cast<cudaStream_t>(m_thread_stream->cudaPtr());
 	}
 
-	for (int i = 0; i < entry_num; ++i) {
-		m_execution_context->setTensorAddress(m_config->INPUT_NAME[i].c_str(),
-											  m_device_ptr[i]);
+	///@note inputs and outputs are introspected from the engine, INPUT_NAME is not used to find them.
+	if (!m_bindings.Load(m_engine, m_execution_context, m_config->OPT_PROFILE, m_stream,
+						 m_config->OUTPUT_NAMES, m_config->OUTPUT_SHAPES)) {
+		m_cuda_alloc_status = CudaMemAllocStatus::ALLOC_FAILED;
+		return;
+	}
+	logStream(LogLevel::INFO) << "Engine tensors: " << m_bindings.Describe() << std::endl;
+	auto *image = m_bindings.Find(TensorRole::IMAGE);
+	if (!image) {
+		logStream(LogLevel::ERROR) << "The engine has no 4-D image input." << std::endl;
+		m_cuda_alloc_status = CudaMemAllocStatus::ALLOC_FAILED;
+		return;
 	}
-	for (int i = 0; i < out_num; ++i) {
-		m_execution_context->setTensorAddress(m_config->OUTPUT_NAMES[i].c_str(),
-											  m_device_ptr[i + entry_num]);
 
+	///@note the element type of the image input comes from the engine, the config only cross checks it.
+	if (!toTensorType(image->dtype, m_input_type)) {
+		logStream(LogLevel::ERROR) << "Not supported data type of input: " << image->name << ", using float32." << std::endl;
+		m_input_type = TensorType::FLOAT32;
+	}
+	TensorType expected = m_input_type;
+	if (m_config->INPUT_DTYPE != "auto" && parseTensorType(m_config->INPUT_DTYPE, expected) &&
+		expected != m_input_type) {
+		logStream(LogLevel::WARNING) << "Input dtype in config file is " << m_config->INPUT_DTYPE
+									 << " but the engine takes " << tensorTypeName(m_input_type) << std::endl;
 	}
+	logStream(LogLevel::INFO) << "Image input: " << image->name << " dtype: " << tensorTypeName(m_input_type) << std::endl;
+	m_preprocessor->SetInputType(m_input_type);
 
-	int w = m_config->TARGET_SIZE[m_config->TARGET_SIZE.size() - 1];
-	int h = m_config->TARGET_SIZE[m_config->TARGET_SIZE.size() - 2];
-	for (int i = 0; i < m_config->INPUT_NAME.size(); ++i) {
-		auto *ptr = (float *)m_device_ptr[i];
-		if (i == 0) {
-			for (int k = 0; k < m_config->TRIGGER_LEN; ++k) {
-				cv::cuda::GpuMat temp(1, 2, CV_32FC1, ptr + k * 2);
-				m_im_shape.emplace_back(temp);
-			}
-		}
-		else if (i == 1) {
-			for (int k = 0; k < m_config->TRIGGER_LEN; ++k) {
-				for (int j = 0; j < 3; ++j) {
-					m_cv_data.emplace_back(cv::Size(w, h),
-										   CV_32FC1, ptr + j * w * h + k * 3 * w * h);
-				}
-			}
+	///@note the target size should be within the resolution range of the profile, SetInputSize() may change it later.
+	int w = m_input_size.width;
+	int h = m_input_size.height;
+	m_max_batch = m_bindings.MaxBatch();
+	if (!m_bindings.SetShapes(m_max_batch, h, w)) {
+		logStream(LogLevel::ERROR) << "Target size " << w << "x" << h << " does not fit the engine." << std::endl;
+		m_cuda_alloc_status = CudaMemAllocStatus::ALLOC_FAILED;
+		return;
+	}
+	m_run_batch = m_bindings.Batch();
+	m_cuda_alloc_status = CudaMemAllocStatus::ALLOC_SUCCESS;
+
+	///@note a clip is one enqueue, so it is bounded by the images one call takes.
+	int length = (int)std::max(1u, m_config->TRIGGER_LEN);
+	if (length > m_max_batch) {
+		logStream(LogLevel::WARNING) << "Trigger length " << length << " exceeds the " << m_max_batch
+									 << " images the engine takes per call, using " << m_max_batch << std::endl;
+		length = m_max_batch;
+	}
+	m_ring.Configure(length, (int)m_config->TRIGGER_STRIDE);
+
+	m_im_shape.clear();
+	m_cv_data.clear();
+	m_scale_factor.clear();
+	if (auto *t = m_bindings.Find(TensorRole::IM_SHAPE)) {
+		///@note a clip engine has one row per clip, not per image.
+		for (int k = 0; k < m_max_batch && (size_t)(k + 1) * 2 <= t->capacity; ++k) {
+			cv::cuda::GpuMat temp(1, 2, CV_32FC1, (float *)t->device + k * 2);
+			m_im_shape.emplace_back(temp);
 		}
-		else if (i == 2) {
-			for (int k = 0; k < m_config->TRIGGER_LEN; ++k) {
-				cv::cuda::GpuMat temp(cv::Size(2, 1), CV_32FC1, ptr + k * 2);
-				m_scale_factor.emplace_back(temp);
-			}
+	}
+	BindImageViews(h, w);
+	if (auto *t = m_bindings.Find(TensorRole::SCALE_FACTOR)) {
+		for (int k = 0; k < m_max_batch && (size_t)(k + 1) * 2 <= t->capacity; ++k) {
+			cv::cuda::GpuMat temp(cv::Size(2, 1), CV_32FC1, (float *)t->device + k * 2);
+			m_scale_factor.emplace_back(temp);
 		}
-		else {
-			std::cerr << "Not supported inputs..." << std::endl;
+	}
+}
+
+void TrtDeploy::BindImageViews(int height, int width)
+{
+	m_cv_data.clear();
+	m_view_size = cv::Size(width, height);
+	auto *image = m_bindings.Find(TensorRole::IMAGE);
+	///@note narrower types are packed by a kernel instead of being split into float views.
+	if (!image || m_input_type != TensorType::FLOAT32)return;
+	auto *ptr = (float *)image->device;
+	const size_t plane = (size_t)width * height;
+	for (int k = 0; k < m_max_batch && (size_t)(k + 1) * 3 * plane <= image->capacity; ++k) {
+		for (int j = 0; j < 3; ++j) {
+			m_cv_data.emplace_back(m_view_size, CV_32FC1, ptr + j * plane + k * 3 * plane);
 		}
 	}
 }
 
+bool TrtDeploy::SetInputSize(int height, int width)
+{
+	if (height <= 0 || width <= 0) {
+		logStream(LogLevel::ERROR) << "Invalid input size " << width << "x" << height << std::endl;
+		return false;
+	}
+	const cv::Size size(width, height);
+	if (size == m_input_size)return true;
+	///@note before the engine is loaded Init() checks the size against the profile.
+	if (m_cuda_alloc_status == CudaMemAllocStatus::ALLOC_SUCCESS &&
+		!m_bindings.SetShapes(m_bindings.DynamicBatch() ? 1 : m_max_batch, height, width)) {
+		logStream(LogLevel::ERROR) << "Input size " << width << "x" << height << " does not fit the engine, keeping "
+								   << m_input_size.width << "x" << m_input_size.height << std::endl;
+		return false;
+	}
+	m_input_size = size;
+	if (m_preprocessor)m_preprocessor->SetTargetSize(size);
+	logStream(LogLevel::INFO) << "Input size set to " << width << "x" << height << std::endl;
+	return true;
+}
+
+cv::Size TrtDeploy::InputSize() const
+{
+	return m_input_size;
+}
+
 TrtDeploy::ModelLoadStatus TrtDeploy::LoadStatus()
 {
 	return m_model_load_status;
@@ -237,54 +412,108 @@ TrtDeploy::CudaMemAllocStatus TrtDeploy::MemAllocStatus()
 	return m_cuda_alloc_status;
 }
 
-void TrtDeploy::Warmup(SharedRef<TrtResults> &res)
+void TrtDeploy::Warmup(SharedRef<TrtResults> &res, int times)
 {
 	cv::Mat img = cv::Mat::ones(cv::Size(m_config->INPUT_SHAPE[m_config->INPUT_SHAPE.size() - 1],
 										 m_config->INPUT_SHAPE[m_config->INPUT_SHAPE.size() - 2]), CV_8UC3);
-	for (int i = 0; i < 10; i++)
+	///@note frames are only pushed into a clip until it is due, each round fills a whole clip.
+	const int frames = times * std::max(1, m_ring.Length());
+	for (int i = 0; i < frames; i++)
 		Infer(img, res);
 }
 
+bool TrtDeploy::Prepare(int times)
+{
+	if (!INIT_FLAG) {
+		Init(m_config->MODEL_NAME);
+		INIT_FLAG = true;
+	}
+	if (m_model_load_status != ModelLoadStatus::LOADED_SUCCESS ||
+		m_cuda_alloc_status == CudaMemAllocStatus::ALLOC_FAILED) {
+		return false;
+	}
+	///@note results of warm up are thrown away, the stream's results and alarm state are not touched.
+	auto res = createSharedRef<TrtResults>(m_config);
+	Warmup(res, std::max(times, 1));
+	///@note the warm up frames must not be the start of the stream's first clip.
+	m_ring.Reset();
+	return true;
+}
+
 void TrtDeploy::InferResults(SharedRef<ImageBlob> &data, SharedRef<TrtResults> &res)
 {
 
 	res->Clear();
 
-	for (int i = 0; i < data->m_gpu_data.size(); ++i) {
-		cv::cuda::split(data->m_gpu_data[i], &m_cv_data[3 * i], *m_thread_stream);
+	///@note a dynamic batch runs only the images given, a static one always runs its full batch.
+	const int count = (int)std::min(data->m_gpu_data.size(), (size_t)m_max_batch);
+	///@note the size of this call is the one the images were preprocessed to, not a member.
+	int w = m_input_size.width;
+	int h = m_input_size.height;
+	if (count > 0) {
+		w = data->m_gpu_data[0].cols;
+		h = data->m_gpu_data[0].rows;
+	}
+	if (!m_bindings.SetShapes(m_bindings.DynamicBatch() ? std::max(count, 1) : m_max_batch, h, w)) {
+		return;
+	}
+	m_run_batch = m_bindings.Batch();
+	if (m_view_size != cv::Size(w, h)) {
+		BindImageViews(h, w);
+	}
+
+	auto *image = m_bindings.Find(TensorRole::IMAGE);
+	for (int i = 0; i < count; ++i) {
+		if (m_input_type == TensorType::FLOAT32) {
+			cv::cuda::split(data->m_gpu_data[i], &m_cv_data[3 * i], *m_thread_stream);
+			continue;
+		}
+		const auto &img = data->m_gpu_data[i];
+		const size_t bytes = (size_t)3 * img.cols * img.rows * tensorTypeSize(m_input_type);
+		auto state = packPlanarOnGpu(img.ptr<float>(), img.step, img.cols, img.rows, m_input_type,
+									 static_cast<char *>(image->device) + i * bytes, m_stream);
+		if (state) {
+			logStream(LogLevel::ERROR) << "Pack input failed: " << cudaGetErrorString(state) << std::endl;
+		}
 	}
-	std::vector<float> shape = {static_cast<float>(m_config->TARGET_SIZE[0]),
-								static_cast<float>(m_config->TARGET_SIZE[1])};
+	///@note boxes stay in network coordinates, the postprocessor maps them back with the same size.
+	std::vector<float> shape = {static_cast<float>(h), static_cast<float>(w)};
 	std::vector<float> scale = {1.0f, 1.0f};
-	for (auto &item : m_im_shape) {
-		item.upload(shape, *m_thread_stream);
+	for (size_t k = 0; k < m_im_shape.size() && (int)k < m_run_batch; ++k) {
+		m_im_shape[k].upload(shape, *m_thread_stream);
 	}
-	for (auto &item : m_scale_factor) {
-		item.upload(scale, *m_thread_stream);
+	for (size_t k = 0; k < m_scale_factor.size() && (int)k < m_run_batch; ++k) {
+		m_scale_factor[k].upload(scale, *m_thread_stream);
 	}
-//        std::chrono::high_resolution_clock::time_point curr_time =
-//                std::chrono::high_resolution_clock::now();
 	m_execution_context->enqueueV3(m_stream);
-//        auto dur = std::chrono::high_resolution_clock::now() - curr_time;
-//        curr_time = std::chrono::high_resolution_clock::now();
-//        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(dur).count();
-//        std::cout << "Thread: " << std::this_thread::get_id() << " enqueue taken: " << ms << "ms" << std::endl;
-
-	auto entry = m_config->INPUT_NAME.size();
-	for (int i = 0; i < m_config->OUTPUT_NAMES.size(); ++i) {
-		auto state = cudaMemcpyAsync(m_host_ptr[i], m_device_ptr[i + entry],
-									 m_host_size[i] * sizeof(float),
+
+	///@note only the elements the call produced are copied back, not the capacity of the profile.
+	const auto &outputs = m_bindings.Outputs();
+	for (auto *out : outputs) {
+		auto state = cudaMemcpyAsync(out->host, out->device, out->Elements() * out->elem_size,
 									 cudaMemcpyDeviceToHost, m_stream);
 		if (state) {
-			std::cout << "Transmit to host failed." << std::endl;
+			logStream(LogLevel::ERROR) << "Transmit to host failed." << std::endl;
 		}
 	}
-//        cudaStreamSynchronize(m_stream);
-	for (int i = 0; i < m_host_size.size(); ++i) {
-		std::vector<float> temp(m_host_size[i], 0.0);
-		memcpy(temp.data(), m_host_ptr[i], sizeof(float) * m_host_size[i]);
+	cudaStreamSynchronize(m_stream);
+	for (size_t i = 0; i < outputs.size(); ++i) {
+		const auto *out = outputs[i];
+		std::vector<float> temp(out->Elements(), 0.0f);
+		if (out->dtype == nvinfer1::DataType::kINT32) {
+			///@note integer outputs, e.g. the box counts of multiclass_nms3, are converted instead of reinterpreted.
+			const auto *src = static_cast<const int32_t *>(out->host);
+			std::transform(src, src + temp.size(), temp.begin(), [](int32_t v) { return (float)v; });
+		}
+		else if (out->dtype == nvinfer1::DataType::kFLOAT) {
+			memcpy(temp.data(), out->host, sizeof(float) * temp.size());
+		}
+		else {
+			logStream(LogLevel::ERROR) << "Not supported data type of output: " << out->name << std::endl;
+		}
 		res->Set(std::make_pair(m_config->OUTPUT_NAMES[i], temp));
 	}
+	res->Stamp(steadyMicros(), cv::Size(w, h));
 }
 
 void TrtDeploy::Postprocessing(const SharedRef<TrtResults> &res, cv::Mat &img, int &alarm)
@@ -292,4 +521,26 @@ void TrtDeploy::Postprocessing(const SharedRef<TrtResults> &res, cv::Mat &img, i
 	m_postprocessor->Run(res, img, alarm);
 }
 
+void TrtDeploy::Detections(std::vector<Box> &dets) const
+{
+	m_postprocessor->Detections(dets);
+}
+
+void TrtDeploy::SetThresholds(float score_threshold, int alarm_count)
+{
+	m_postprocessor->SetThresholds(score_threshold, alarm_count);
+}
+
+PlanCacheStats TrtDeploy::CacheStats() const
+{
+	if (!m_preprocessor)return {};
+	return m_preprocessor->CacheStats();
+}
+
+void TrtDeploy::Postprocessing(const SharedRef<TrtResults> &res, const cv::Size &frame, int &alarm)
+{
+	if (!m_postprocessor)return;
+	m_postprocessor->Run(res, frame, alarm);
+}
+
 }
@@ -6,6 +6,9 @@
 #include "preprocessor.h"
 #include "postprocessor.h"
 #include "trt_deployresult.h"
+#include "tensor_pack.h"
+#include "tensor_binding.h"
+#include "temporal_ring.h"
 #include "util.h"
 
 namespace helmet
@@ -71,17 +74,49 @@ public:
 public:
 	/**
 	 * @brief This method is used as infer function, its input is images data.
+	 * @details with TRIGGER_LEN > 1 the frame is added to the clip of the stream and result is only <!--
+	 * --> overwritten when a clip is due, see InferClip().
 	 * @param img inout images, for videos, it should be parsed.
 	 * @param result inference results.
 	 */
 	virtual void Infer(const cv::Mat &img, SharedRef<TrtResults> &result);
 
+	/**
+	 * @brief infer function for frames in any supported pixel format.
+	 * @param img input image, planar YUV frames have height*3/2 rows.
+	 * @param format pixel layout of img.
+	 * @param mask optional CV_8UC1 ROI mask of TRAIN_SIZE, applied while converting YUV frames.
+	 * @param result inference results.
+	 */
+	virtual void Infer(const cv::Mat &img, PixelFormat format, const cv::Mat &mask, SharedRef<TrtResults> &result);
+
+	/**
+	 * @brief infer frames of several streams together, the results are scattered back per frame.
+	 * @details frames are run in chunks of the engine batch size, each chunk is one preprocessing and <!--
+	 * --> one enqueue. The outputs are sliced per image: with model NMS the detections are split by the <!--
+	 * --> per image counts of the second output and padded like single frame outputs, otherwise every <!--
+	 * --> output is split evenly along its batch dimension.
+	 * @param imgs BGR frames of the same size.
+	 * @param results one result per frame, overwritten.
+	 */
+	virtual void InferBatch(const std::vector<cv::Mat> &imgs, std::vector<SharedRef<TrtResults>> &results);
+
 	/**
 	 * @brief inference for fake data.
 	 * @details the main purpose of this function is to test the whole pipeline's capability.
 	 * @param res inference results.
+	 * @param times number of inferences.
+	 */
+	virtual void Warmup(SharedRef<TrtResults> &res, int times = 10);
+
+	/**
+	 * @brief do everything the first frame would do, i.e. load the model, allocate buffers, <!--
+	 * --> build the preprocessing plan at INPUT_SHAPE and run warm up inferences.
+	 * @details meant to be called off the stream thread, the instance must not be used by others meanwhile.
+	 * @param times number of warm up inferences, at least one is run to build the preprocessing plan.
+	 * @return true if the backend is ready, false if loading or allocation failed.
 	 */
-	virtual void Warmup(SharedRef<TrtResults> &res);
+	bool Prepare(int times);
 
 	/**
 	 * @brief This is the post processing function, you can implement the real worker as Postprocessor object.
@@ -93,6 +128,44 @@ public:
 	 */
 	void Postprocessing(const SharedRef<TrtResults> &res, cv::Mat &img, int &alarm);
 
+	/**
+	 * @brief post processing without drawing, only the alarm is updated.
+	 * @param res inference results.
+	 * @param frame size of input images.
+	 * @param alarm output alarm.
+	 */
+	void Postprocessing(const SharedRef<TrtResults> &res, const cv::Size &frame, int &alarm);
+
+	/**
+	 * @brief get the valid boxes of the latest postprocessing, in raw image coordinates.
+	 */
+	void Detections(std::vector<Box> &dets) const;
+
+	/**
+	 * @brief update the postprocessing thresholds which can be changed at runtime.
+	 * @param score_threshold minimal score of a valid box.
+	 * @param alarm_count accumulated count to raise an alarm.
+	 */
+	void SetThresholds(float score_threshold, int alarm_count);
+
+	/**
+	 * @brief change the network input size of the next frames, within the resolution range of the profile.
+	 * @param height network input height.
+	 * @param width network input width.
+	 * @return false if the size does not fit the engine, the current size is kept then.
+	 */
+	bool SetInputSize(int height, int width);
+
+	/**
+	 * @brief get the network input size of the next frames, TARGET_SIZE of the config until changed.
+	 */
+	cv::Size InputSize() const;
+
+	/**
+	 * @brief get statistics of the per resolution preprocessing plans.
+	 */
+	PlanCacheStats CacheStats() const;
+
 protected:
 	/**
 	 * @brief internal infer function with gpu input.
@@ -101,6 +174,25 @@ protected:
 	 */
 	void InferResults(SharedRef<ImageBlob> &data, SharedRef<TrtResults> &res);
 
+	/**
+	 * @brief add a preprocessed frame to the clip of the stream and infer the clip when it is due.
+	 * @details the latest TRIGGER_LEN frames are kept preprocessed in m_ring and run as one enqueue every <!--
+	 * --> TRIGGER_STRIDE frames. An engine taking frames as its batch gives the newest frame its result, <!--
+	 * --> a clip engine [N,T,C,H,W] gives the clip one result.
+	 * @param data preprocessed frame.
+	 * @param res output results, untouched if no clip is due.
+	 */
+	void InferClip(SharedRef<ImageBlob> &data, SharedRef<TrtResults> &res);
+
+	/**
+	 * @brief slice batched outputs into per image results.
+	 * @param batch results of one enqueue.
+	 * @param results first result of the chunk.
+	 * @param count number of images in the chunk.
+	 * @param first item of the batch scattered into results[0].
+	 */
+	void Scatter(const SharedRef<TrtResults> &batch, SharedRef<TrtResults> *results, size_t count, size_t first = 0);
+
 	/**
 	 * @brief initialization of all necessary staff.
 	 * @details including allocating memory on gpu / init objects / set input and output.
@@ -122,6 +214,11 @@ protected:
 	 */
 	CudaMemAllocStatus MemAllocStatus();
 
+	/**
+	 * @brief map the float planes of every image of the image input for the given size.
+	 */
+	void BindImageViews(int height, int width);
+
 protected:
 	bool INIT_FLAG = false; ///< to indicate the system has initialized.
 	SharedRef<Preprocessor> m_preprocessor = nullptr; ///< preprocessor object.
@@ -134,10 +231,10 @@ protected:
 	nvinfer1::IExecutionContext *m_execution_context = nullptr; ///< cuda context.
 	cudaStream_t m_stream = nullptr; ///< for parallel purpose.
 	SharedRef<cv::cuda::Stream> m_thread_stream = nullptr;
-	std::vector<void *> m_device_ptr; ///< pointer to states on GPU side.
-	std::vector<void *> m_host_ptr;
-	std::vector<int> m_host_size;
+	TensorBindings m_bindings;///< I/O tensors introspected from the engine and their buffers.
 	std::vector<cv::cuda::GpuMat> m_cv_data;///< directly map from opencv GpuMat to TensorRT.
+	cv::Size m_view_size;///< input size m_cv_data is mapped for.
+	cv::Size m_input_size;///< network input size of the next frames, the config stays read only.
 	std::vector<cv::cuda::GpuMat> m_im_shape;
 	std::vector<cv::cuda::GpuMat> m_scale_factor;
 
@@ -145,6 +242,12 @@ protected:
 	CudaMemAllocStatus m_cuda_alloc_status; ///< allocation of memory for cuda.
 	SharedRef<Config> m_config;
 	int m_gpu_id = 0;
+	TensorType m_input_type = TensorType::FLOAT32;///< element type of the image input.
+	int m_max_batch = 1;///< images per enqueue at most, the largest batch of the optimization profile.
+	int m_run_batch = 1;///< images of the latest enqueue, what batched outputs are divided by.
+	SharedRef<TrtResults> m_batch_result = nullptr;///< outputs of a batched enqueue before scattering.
+	TemporalRing m_ring;///< latest preprocessed frames of the stream, TRIGGER_LEN > 1 only.
+	SharedRef<ImageBlob> m_clip_blob = nullptr;///< headers of m_ring in temporal order.
 
 	float m_curr_fps; ///< Frame per Second.
 
@@ -28,5 +28,27 @@ void TrtResults::Clear()
 {
 	m_res.clear();
 }
+
+void TrtResults::Stamp(int64_t time_us, const cv::Size &input)
+{
+	m_time = time_us;
+	m_input_size = input;
+	m_sequence++;
+}
+
+int64_t TrtResults::Time() const
+{
+	return m_time;
+}
+
+uint64_t TrtResults::Sequence() const
+{
+	return m_sequence;
+}
+
+cv::Size TrtResults::InputSize() const
+{
+	return m_input_size;
+}
 }
 
@@ -47,9 +47,30 @@ public:
 	 * @brief clear the map.
 	 */
 	void Clear();
+	/**
+	 * @brief mark the results as fresh, called once the outputs of an inference are set.
+	 * @param time_us time of the inference, see steadyMicros().
+	 * @param input network input size the outputs refer to, boxes are scaled back from it.
+	 */
+	void Stamp(int64_t time_us, const cv::Size &input = cv::Size());
+	/**
+	 * @brief get the time of the latest inference, -1 before the first one.
+	 */
+	int64_t Time() const;
+	/**
+	 * @brief get the number of inferences stamped, tells fresh results from reused ones.
+	 */
+	uint64_t Sequence() const;
+	/**
+	 * @brief get the network input size of the latest inference, empty if not recorded.
+	 */
+	cv::Size InputSize() const;
 private:
 	std::unordered_map<std::string, std::vector<float>> m_res;///< map for storing the current inference data.
 	SharedRef<Config> m_config = nullptr;
+	int64_t m_time = -1;
+	uint64_t m_sequence = 0;
+	cv::Size m_input_size;
 };
 
 }
@@ -88,6 +88,12 @@ void plotBox(cv::Mat &img, int x0, int y0, int x1, int y1, std::vector<unsigned
 			 cv::Point(x1, y1), cv::Scalar(color[0], color[1], color[2]),
 			 thickness);
 }
+int64_t steadyMicros()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
 int round2int(float num)
 {
 	if (num > 0)
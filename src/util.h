@@ -92,6 +92,12 @@ namespace helmet {
 
     extern std::vector<std::string> parseNames(const std::string &names, char delim);
 
+    /**
+     * @brief monotonic time, used to stamp results and alarm evidence.
+     * @return microseconds of the steady clock.
+     */
+    extern int64_t steadyMicros();
+
 /**
  * @brief This is a factory class used as a design pattern.
  * @details This class can serve as a simple implementation of factory pattern, one can register a derived class with given names, and afterwards the registered class can be initialized.
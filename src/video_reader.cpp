@@ -0,0 +1,215 @@
+#include <iostream>
+#include <opencv2/videoio/registry.hpp>
+#include "video_reader.h"
+#include "log.h"
+#include "placement.h"
+
+namespace helmet
+{
+
+/**
+ * @brief build a GStreamer pipeline which scales while decoding and outputs planar YUV.
+ * @param file video file or rtsp url.
+ * @param size output size.
+ * @param format NV12 or I420.
+ * @return pipeline description for cv::VideoCapture with cv::CAP_GSTREAMER.
+ */
+static std::string makeScaledDecodePipeline(const std::string &file, const cv::Size &size, PixelFormat format)
+{
+	std::stringstream pipeline;
+	if (file.rfind("rtsp://", 0) == 0) {
+		pipeline << "rtspsrc location=\"" << file << "\" latency=0 ! decodebin";
+	}
+	else {
+		pipeline << "filesrc location=\"" << file << "\" ! decodebin";
+	}
+	///@note scale in the native decoder format first, videoconvert is a pass through for NV12 decoders.
+	pipeline << " ! videoscale ! videoconvert ! video/x-raw,format="
+			 << (format == PixelFormat::I420 ? "I420" : "NV12")
+			 << ",width=" << size.width << ",height=" << size.height
+			 << " ! appsink sync=false";
+	return pipeline.str();
+}
+
+PrefetchVideoReader::PrefetchVideoReader(size_t lookahead)
+{
+	m_ring.resize(lookahead > 0 ? lookahead : 1);
+}
+
+PrefetchVideoReader::~PrefetchVideoReader()
+{
+	Release();
+}
+
+bool PrefetchVideoReader::Open(const std::string &file)
+{
+	Release();
+	m_cap.open(file);
+	if (!m_cap.isOpened()) {
+		logStream(LogLevel::ERROR) << "Cannot open video source: " << file << std::endl;
+		return false;
+	}
+	m_format = PixelFormat::BGR;
+	Start();
+	return true;
+}
+
+bool PrefetchVideoReader::Open(const std::string &file, const cv::Size &decode_size, PixelFormat format)
+{
+	Release();
+	if (format != PixelFormat::BGR && cv::videoio_registry::hasBackend(cv::CAP_GSTREAMER)) {
+		m_cap.open(makeScaledDecodePipeline(file, decode_size, format), cv::CAP_GSTREAMER);
+	}
+	if (!m_cap.isOpened()) {
+		logStream(LogLevel::ERROR) << "Decode-time scaling is not supported for: " << file << ", fallback to BGR..." << std::endl;
+		return Open(file);
+	}
+	m_format = format;
+	Start();
+	return true;
+}
+
+PixelFormat PrefetchVideoReader::GetPixelFormat() const
+{
+	return m_format;
+}
+
+void PrefetchVideoReader::Start()
+{
+	m_fps = m_cap.get(cv::CAP_PROP_FPS);
+	m_width = m_cap.get(cv::CAP_PROP_FRAME_WIDTH);
+	m_height = m_cap.get(cv::CAP_PROP_FRAME_HEIGHT);
+	m_frame_count = m_cap.get(cv::CAP_PROP_FRAME_COUNT);
+	m_head = 0;
+	m_count = 0;
+	m_grabbed = 0;
+	m_retrieved = 0;
+	m_skipped = 0;
+	m_stop = false;
+	m_eof = false;
+	m_opened = true;
+	m_thread = std::thread(&PrefetchVideoReader::Loop, this);
+}
+
+bool PrefetchVideoReader::IsOpened() const
+{
+	return m_opened;
+}
+
+void PrefetchVideoReader::SetDecodeInterval(int interval)
+{
+	m_interval = interval > 0 ? interval : 1;
+}
+
+void PrefetchVideoReader::Loop()
+{
+	Tracer::Instance().SetThreadName("decode");
+	const auto cap = m_ring.size();
+	int64_t index = 0;
+	while (true) {
+		size_t tail;
+		{
+			std::unique_lock<std::mutex> lock(m_mtx);
+			m_not_full.wait(lock, [&] { return m_stop || m_count < cap; });
+			if (m_stop)break;
+			tail = (m_head + m_count) % cap;
+		}
+		///@note the tail slot is invisible to consumer until m_count is increased, so no lock is needed here.
+		auto &slot = m_ring[tail];
+		{
+			StreamScope scope(m_stats.load(), index);
+			StageTimer timer(Stage::DECODE);
+			if (!m_cap.grab()) {
+				break;
+			}
+			m_grabbed++;
+			const int interval = m_interval;
+			slot.index = index;
+			slot.decoded = (index % interval == 0);
+			if (slot.decoded) {
+				slot.decoded = m_cap.retrieve(slot.img) && !slot.img.empty();
+				m_retrieved++;
+			}
+			else {
+				m_skipped++;
+			}
+		}
+		index++;
+		{
+			std::lock_guard<std::mutex> lock(m_mtx);
+			m_count++;
+		}
+		m_not_empty.notify_one();
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_mtx);
+		m_eof = true;
+	}
+	m_not_empty.notify_all();
+}
+
+bool PrefetchVideoReader::Read(Frame &frame)
+{
+	if (!m_opened)return false;
+	std::unique_lock<std::mutex> lock(m_mtx);
+	m_not_empty.wait(lock, [this] { return m_count > 0 || m_eof; });
+	if (m_count == 0)return false;
+	auto &slot = m_ring[m_head];
+	std::swap(frame.img, slot.img);
+	frame.index = slot.index;
+	frame.decoded = slot.decoded;
+	m_head = (m_head + 1) % m_ring.size();
+	m_count--;
+	lock.unlock();
+	m_not_full.notify_one();
+	return true;
+}
+
+double PrefetchVideoReader::Get(int prop) const
+{
+	switch (prop) {
+		case cv::CAP_PROP_FPS:return m_fps;
+		case cv::CAP_PROP_FRAME_WIDTH:return m_width;
+		case cv::CAP_PROP_FRAME_HEIGHT:return m_height;
+		case cv::CAP_PROP_FRAME_COUNT:return m_frame_count;
+		default:return 0.0;
+	}
+}
+
+void PrefetchVideoReader::Release()
+{
+	if (!m_opened)return;
+	{
+		std::lock_guard<std::mutex> lock(m_mtx);
+		m_stop = true;
+	}
+	m_not_full.notify_all();
+	if (m_thread.joinable()) {
+		m_thread.join();
+	}
+	m_cap.release();
+	m_opened = false;
+}
+
+PrefetchVideoReader::Stats PrefetchVideoReader::GetStats() const
+{
+	Stats stats;
+	stats.grabbed = m_grabbed;
+	stats.retrieved = m_retrieved;
+	stats.skipped = m_skipped;
+	return stats;
+}
+
+void PrefetchVideoReader::SetLatencyStats(const SharedRef<StreamLatency> &stats)
+{
+	m_stats_ref = stats;
+	m_stats = stats.get();
+}
+
+bool PrefetchVideoReader::SetAffinity(const std::vector<int> &cpus)
+{
+	if (!m_opened || !m_thread.joinable())return false;
+	return pinThread(m_thread.native_handle(), cpus);
+}
+
+}
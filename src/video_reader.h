@@ -0,0 +1,184 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <opencv2/videoio.hpp>
+#include "util.h"
+#include "latency_stats.h"
+#include "yuv_convert.h"
+
+namespace helmet
+{
+/**
+ * @brief prefetching video reader, decoding frames on its own thread ahead of the consumer.
+ * @details the decode thread keeps a small lookahead ring of frames. Frames which will not be analysed or <!--
+ * --> displayed are only grab()'ed, i.e. demuxed and counted without paying for retrieve(), the <!--
+ * --> decoded frame buffers are recycled between the ring and the consumer.
+ * @note Read() is expected to be called from a single consumer thread.
+ * @example:
+ * @code
+ * 	PrefetchVideoReader reader(4);
+ * 	reader.Open("in.mp4");
+ * 	reader.SetDecodeInterval(3);//only every 3rd frame is retrieved.
+ * 	PrefetchVideoReader::Frame frame;
+ * 	while (reader.Read(frame)) {
+ * 		if (frame.decoded) Process_Algorithm(model, frame.img);
+ * 		else Skip_Algorithm(model);
+ * 	}
+ * @endcode
+ */
+class PrefetchVideoReader final
+{
+public:
+	/**
+	 * @brief one entry of the lookahead ring.
+	 */
+	struct Frame
+	{
+		cv::Mat img;///< decoded image, empty if the frame is only grabbed.
+		int64_t index = -1;///< frame index in the video, start from 0.
+		bool decoded = false;///< true if the frame is retrieved.
+	};
+
+	/**
+	 * @brief counters of the reader, all values are accumulated since Open().
+	 */
+	struct Stats
+	{
+		uint64_t grabbed = 0;///< frames demuxed from the source.
+		uint64_t retrieved = 0;///< frames fully decoded.
+		uint64_t skipped = 0;///< frames only grabbed, not decoded.
+	};
+
+public:
+	/**
+	 * @brief constructor.
+	 * @param lookahead number of frames the decode thread may run ahead of consumer.
+	 */
+	explicit PrefetchVideoReader(size_t lookahead = 4);
+
+	/**
+	 * @brief stop and join the decode thread.
+	 */
+	~PrefetchVideoReader();
+
+	/**
+	 * @brief open the video source and start the decode thread.
+	 * @param file video file or url.
+	 * @return true if the source is opened.
+	 */
+	bool Open(const std::string &file);
+
+	/**
+	 * @brief open the video source with decode-time downscaling.
+	 * @details if OpenCV is built with GStreamer, the source is decoded through a pipeline scaling to decode_size <!--
+	 * --> and delivering planar YUV, thus neither full resolution colour conversion nor copy happens. Otherwise <!--
+	 * --> the source is opened as usual, check GetPixelFormat() for the actual layout of frames.
+	 * @param file video file or rtsp url.
+	 * @param decode_size size of decoded frames.
+	 * @param format NV12 or I420.
+	 * @return true if the source is opened.
+	 */
+	bool Open(const std::string &file, const cv::Size &decode_size, PixelFormat format);
+
+	/**
+	 * @brief get the pixel layout of decoded frames.
+	 * @return pixel format.
+	 */
+	PixelFormat GetPixelFormat() const;
+
+	/**
+	 * @brief query the reader status.
+	 * @return true if the source is opened.
+	 */
+	bool IsOpened() const;
+
+	/**
+	 * @brief set which frames should be fully decoded.
+	 * @details frame with index i is retrieved only if i % interval == 0, 1 means every frame is decoded.
+	 * @param interval decode interval, should be positive.
+	 */
+	void SetDecodeInterval(int interval);
+
+	/**
+	 * @brief get next frame, blocking until it is available.
+	 * @details the buffer inside frame is swapped back into the ring for reuse.
+	 * @param frame output frame.
+	 * @return false if the end of source is reached.
+	 */
+	bool Read(Frame &frame);
+
+	/**
+	 * @brief get source property, cached at Open() since cv::VideoCapture is owned by decode thread.
+	 * @param prop one of cv::CAP_PROP_FPS, cv::CAP_PROP_FRAME_WIDTH, cv::CAP_PROP_FRAME_HEIGHT, cv::CAP_PROP_FRAME_COUNT.
+	 * @return property value, 0 if not cached.
+	 */
+	double Get(int prop) const;
+
+	/**
+	 * @brief stop decoding and close the source.
+	 */
+	void Release();
+
+	/**
+	 * @brief get the current counters.
+	 * @return snapshot of reader counters.
+	 */
+	Stats GetStats() const;
+
+	/**
+	 * @brief record the decode latency of each frame into given stream statistics.
+	 * @param stats stream statistics, nullptr to stop recording.
+	 */
+	void SetLatencyStats(const SharedRef<StreamLatency> &stats);
+
+	/**
+	 * @brief pin the decode thread, e.g. to the CPUs given by GetPlacement_Algorithm.
+	 * @param cpus CPU ids.
+	 * @return true if pinned, false if not opened or pinning failed.
+	 */
+	bool SetAffinity(const std::vector<int> &cpus);
+
+private:
+	/**
+	 * @brief cache source properties and start the decode thread, m_cap must be opened.
+	 */
+	void Start();
+
+	/**
+	 * @brief decode thread main loop.
+	 */
+	void Loop();
+
+private:
+	cv::VideoCapture m_cap;
+	std::thread m_thread;
+	mutable std::mutex m_mtx;
+	std::condition_variable m_not_empty;
+	std::condition_variable m_not_full;
+	SharedRef<StreamLatency> m_stats_ref = nullptr;
+	std::atomic<StreamLatency *> m_stats = nullptr;
+	std::vector<Frame> m_ring;///< lookahead ring, owns the recycled buffers.
+	size_t m_head = 0;///< index of the oldest frame.
+	size_t m_count = 0;///< number of frames ready.
+	bool m_stop = false;
+	bool m_eof = false;
+	bool m_opened = false;
+	std::atomic_int m_interval = 1;
+	PixelFormat m_format = PixelFormat::BGR;
+
+	double m_fps = 0.0;
+	double m_width = 0.0;
+	double m_height = 0.0;
+	double m_frame_count = 0.0;
+
+	std::atomic<uint64_t> m_grabbed = 0;
+	std::atomic<uint64_t> m_retrieved = 0;
+	std::atomic<uint64_t> m_skipped = 0;
+};
+
+}
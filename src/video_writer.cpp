@@ -0,0 +1,145 @@
+#include <iostream>
+#include "video_writer.h"
+#include "log.h"
+#include "placement.h"
+
+namespace helmet
+{
+
+AsyncVideoWriter::AsyncVideoWriter(size_t capacity, DropPolicy policy)
+{
+	m_capacity = capacity > 0 ? capacity : 1;
+	m_policy = policy;
+	m_free.reserve(m_capacity);
+}
+
+AsyncVideoWriter::~AsyncVideoWriter()
+{
+	Release();
+}
+
+bool AsyncVideoWriter::Open(const std::string &file, int fourcc, double fps, const cv::Size &size)
+{
+	Release();
+	m_writer.open(file, fourcc, fps, size);
+	if (!m_writer.isOpened()) {
+		logStream(LogLevel::ERROR) << "Cannot open video writer for: " << file << std::endl;
+		return false;
+	}
+	m_queued = 0;
+	m_written = 0;
+	m_dropped = 0;
+	m_stop = false;
+	m_opened = true;
+	m_thread = std::thread(&AsyncVideoWriter::Loop, this);
+	return true;
+}
+
+bool AsyncVideoWriter::IsOpened() const
+{
+	return m_opened;
+}
+
+bool AsyncVideoWriter::Write(const cv::Mat &frame)
+{
+	if (!m_opened || frame.empty())return false;
+
+	cv::Mat buf;
+	{
+		std::unique_lock<std::mutex> lock(m_mtx);
+		if (m_free.empty() && m_queue.size() + 1 > m_capacity) {
+			if (m_policy == DropPolicy::DROP_NEWEST) {
+				m_dropped++;
+				return false;
+			}
+			else if (m_policy == DropPolicy::DROP_OLDEST && !m_queue.empty()) {
+				///@note reuse the buffer of oldest frame, so the pool never grows.
+				buf = std::move(m_queue.front());
+				m_queue.pop_front();
+				m_dropped++;
+			}
+			else {
+				m_not_full.wait(lock, [this] { return m_stop || !m_free.empty(); });
+				if (m_stop)return false;
+			}
+		}
+		if (buf.empty() && !m_free.empty()) {
+			buf = std::move(m_free.back());
+			m_free.pop_back();
+		}
+	}
+	///@note the copy is done outside the lock, copyTo() will not reallocate if size and type are unchanged.
+	frame.copyTo(buf);
+	{
+		std::lock_guard<std::mutex> lock(m_mtx);
+		m_queue.push_back(std::move(buf));
+	}
+	m_queued++;
+	m_not_empty.notify_one();
+	return true;
+}
+
+void AsyncVideoWriter::Loop()
+{
+	Tracer::Instance().SetThreadName("encode");
+	while (true) {
+		cv::Mat buf;
+		{
+			std::unique_lock<std::mutex> lock(m_mtx);
+			m_not_empty.wait(lock, [this] { return m_stop || !m_queue.empty(); });
+			if (m_queue.empty())break;
+			buf = std::move(m_queue.front());
+			m_queue.pop_front();
+		}
+		{
+			StreamScope scope(m_stats.load(), (int64_t)m_written.load());
+			StageTimer timer(Stage::ENCODE);
+			m_writer.write(buf);
+		}
+		m_written++;
+		{
+			std::lock_guard<std::mutex> lock(m_mtx);
+			m_free.push_back(std::move(buf));
+		}
+		m_not_full.notify_one();
+	}
+}
+
+void AsyncVideoWriter::Release()
+{
+	if (!m_opened)return;
+	{
+		std::lock_guard<std::mutex> lock(m_mtx);
+		m_stop = true;
+	}
+	m_not_empty.notify_all();
+	m_not_full.notify_all();
+	if (m_thread.joinable()) {
+		m_thread.join();
+	}
+	m_writer.release();
+	m_opened = false;
+}
+
+AsyncVideoWriter::Stats AsyncVideoWriter::GetStats() const
+{
+	Stats stats;
+	stats.queued = m_queued;
+	stats.written = m_written;
+	stats.dropped = m_dropped;
+	return stats;
+}
+
+void AsyncVideoWriter::SetLatencyStats(const SharedRef<StreamLatency> &stats)
+{
+	m_stats_ref = stats;
+	m_stats = stats.get();
+}
+
+bool AsyncVideoWriter::SetAffinity(const std::vector<int> &cpus)
+{
+	if (!m_opened || !m_thread.joinable())return false;
+	return pinThread(m_thread.native_handle(), cpus);
+}
+
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <opencv2/videoio.hpp>
+#include "util.h"
+#include "latency_stats.h"
+
+namespace helmet
+{
+/**
+ * @brief asynchronous video writer, moving the encoding off the processing thread.
+ * @details frames are copied into buffers taken from a fixed pool and handed to a background thread which owns <!--
+ * --> the cv::VideoWriter, the buffers are recycled once encoded, thus no allocation happens per frame.
+ * @note Write() is expected to be called from a single producer thread.
+ * @example:
+ * @code
+ * 	AsyncVideoWriter vw(8, AsyncVideoWriter::DropPolicy::DROP_OLDEST);
+ * 	vw.Open("out.mp4", cv::VideoWriter::fourcc('m', 'p', '4', 'v'), 25.0, cv::Size(1920, 1080));
+ * 	while (...) {
+ * 		Process_Algorithm(model, img);
+ * 		vw.Write(img);
+ * 	}
+ * 	vw.Release();
+ * @endcode
+ */
+class AsyncVideoWriter final
+{
+public:
+	enum class DropPolicy
+	{
+		DROP_NEWEST = 0,///< discard the incoming frame if the queue is full.
+		DROP_OLDEST = 1,///< discard the oldest queued frame to make room for the incoming one.
+		BLOCK = 2 ///< wait for the encoder, never drop frames.
+	};
+
+	/**
+	 * @brief counters of the writer, all values are accumulated since Open().
+	 */
+	struct Stats
+	{
+		uint64_t queued = 0;///< frames accepted into the queue.
+		uint64_t written = 0;///< frames handed to the encoder.
+		uint64_t dropped = 0;///< frames discarded by the drop policy.
+	};
+
+public:
+	/**
+	 * @brief constructor.
+	 * @param capacity maximum number of frames waiting for encoding, also the size of buffer pool.
+	 * @param policy behaviour when the queue is full.
+	 */
+	explicit AsyncVideoWriter(size_t capacity = 8, DropPolicy policy = DropPolicy::DROP_OLDEST);
+
+	/**
+	 * @brief flush the pending frames and join the encoder thread.
+	 */
+	~AsyncVideoWriter();
+
+	/**
+	 * @brief open the underlying video writer and start the encoder thread.
+	 * @param file output video file.
+	 * @param fourcc codec, see cv::VideoWriter::fourcc.
+	 * @param fps frame rate of output video.
+	 * @param size frame size of output video.
+	 * @return true if the writer is opened.
+	 */
+	bool Open(const std::string &file, int fourcc, double fps, const cv::Size &size);
+
+	/**
+	 * @brief query the writer status.
+	 * @return true if the writer is opened.
+	 */
+	bool IsOpened() const;
+
+	/**
+	 * @brief queue one frame for encoding.
+	 * @param frame frame to be written, it is copied so the caller can reuse it immediately.
+	 * @return false if the frame is dropped.
+	 */
+	bool Write(const cv::Mat &frame);
+
+	/**
+	 * @brief encode all pending frames and close the writer.
+	 */
+	void Release();
+
+	/**
+	 * @brief get the current counters.
+	 * @return snapshot of writer counters.
+	 */
+	Stats GetStats() const;
+
+	/**
+	 * @brief record the encode latency of each frame into given stream statistics.
+	 * @param stats stream statistics, nullptr to stop recording.
+	 */
+	void SetLatencyStats(const SharedRef<StreamLatency> &stats);
+
+	/**
+	 * @brief pin the encoder thread, e.g. to the CPUs given by GetPlacement_Algorithm.
+	 * @param cpus CPU ids.
+	 * @return true if pinned, false if not opened or pinning failed.
+	 */
+	bool SetAffinity(const std::vector<int> &cpus);
+
+private:
+	/**
+	 * @brief encoder thread main loop.
+	 */
+	void Loop();
+
+private:
+	cv::VideoWriter m_writer;
+	std::thread m_thread;
+	mutable std::mutex m_mtx;
+	std::condition_variable m_not_empty;
+	std::condition_variable m_not_full;
+	SharedRef<StreamLatency> m_stats_ref = nullptr;
+	std::atomic<StreamLatency *> m_stats = nullptr;
+	std::deque<cv::Mat> m_queue;///< frames waiting for encoding.
+	std::vector<cv::Mat> m_free;///< recycled frame buffers.
+	size_t m_capacity = 8;
+	DropPolicy m_policy = DropPolicy::DROP_OLDEST;
+	bool m_stop = false;
+	bool m_opened = false;
+
+	std::atomic<uint64_t> m_queued = 0;
+	std::atomic<uint64_t> m_written = 0;
+	std::atomic<uint64_t> m_dropped = 0;
+};
+
+}
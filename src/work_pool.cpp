@@ -0,0 +1,172 @@
+#include "work_pool.h"
+#include "placement.h"
+
+namespace helmet
+{
+
+std::atomic_uint WorkPool::s_initial = 0;
+
+WorkPool &WorkPool::Instance()
+{
+	static WorkPool pool;
+	return pool;
+}
+
+void WorkPool::Configure(unsigned int threads)
+{
+	s_initial = threads;
+}
+
+WorkPool::WorkPool()
+{
+	Start(s_initial.load());
+}
+
+WorkPool::~WorkPool()
+{
+	Stop();
+}
+
+void WorkPool::SetThreads(unsigned int threads)
+{
+	if (threads == 0)threads = std::max(1u, std::thread::hardware_concurrency());
+	if (threads == m_threads.load())return;
+	Stop();
+	Start(threads);
+}
+
+void WorkPool::SetAffinity(const std::vector<std::vector<int>> &cpus)
+{
+	std::lock_guard<std::mutex> lock(m_affinity_mtx);
+	m_affinity = cpus;
+	if (m_affinity.empty())return;
+	for (size_t i = 0; i < m_workers.size(); ++i) {
+		pinThread(m_workers[i].native_handle(), m_affinity[i % m_affinity.size()]);
+	}
+}
+
+unsigned int WorkPool::Threads() const
+{
+	return m_threads.load(std::memory_order_relaxed);
+}
+
+void WorkPool::AddStream()
+{
+	m_streams.fetch_add(1, std::memory_order_relaxed);
+}
+
+void WorkPool::RemoveStream()
+{
+	m_streams.fetch_sub(1, std::memory_order_relaxed);
+}
+
+unsigned int WorkPool::Width() const
+{
+	const unsigned int threads = m_threads.load(std::memory_order_relaxed);
+	const unsigned int streams = std::max(1u, m_streams.load(std::memory_order_relaxed));
+	return std::max(1u, threads / streams);
+}
+
+void WorkPool::Start(unsigned int threads)
+{
+	if (threads == 0)threads = std::max(1u, std::thread::hardware_concurrency());
+	m_stop = false;
+	m_threads = threads;
+	///@note the calling thread of each loop takes part, so one worker less is started.
+	const unsigned int workers = threads - 1;
+	m_queues.clear();
+	for (unsigned int i = 0; i < workers; ++i) {
+		m_queues.push_back(createUniqueRef<Queue>());
+	}
+	for (unsigned int i = 0; i < workers; ++i) {
+		m_workers.emplace_back(&WorkPool::Loop, this, (size_t)i);
+	}
+	std::lock_guard<std::mutex> lock(m_affinity_mtx);
+	if (!m_affinity.empty()) {
+		for (size_t i = 0; i < m_workers.size(); ++i) {
+			pinThread(m_workers[i].native_handle(), m_affinity[i % m_affinity.size()]);
+		}
+	}
+}
+
+void WorkPool::Stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mtx);
+		m_stop = true;
+	}
+	m_wake.notify_all();
+	for (auto &t : m_workers) {
+		if (t.joinable())t.join();
+	}
+	m_workers.clear();
+	m_queues.clear();
+	m_pending = 0;
+	m_threads = 1;
+}
+
+void WorkPool::Run(const SharedRef<WorkJob> &job, int helpers)
+{
+	const auto queues = m_queues.size();
+	helpers = std::min(helpers, (int)queues);
+	for (int i = 0; i < helpers; ++i) {
+		auto &q = *m_queues[m_next_queue.fetch_add(1, std::memory_order_relaxed) % queues];
+		std::lock_guard<std::mutex> lock(q.mtx);
+		q.tokens.push_back(job);
+	}
+	if (helpers > 0) {
+		{
+			///@note taken under the lock, so a worker checking before sleeping never misses the tokens.
+			std::lock_guard<std::mutex> lock(m_mtx);
+			m_pending.fetch_add(helpers);
+		}
+		if (helpers == 1)m_wake.notify_one();
+		else m_wake.notify_all();
+	}
+	job->Drain();
+	///@note bands claimed by helpers are short, spinning is cheaper than sleeping.
+	while (job->done.load(std::memory_order_acquire) < job->bands) {
+		std::this_thread::yield();
+	}
+}
+
+SharedRef<WorkJob> WorkPool::Take(size_t index)
+{
+	{
+		auto &own = *m_queues[index];
+		std::lock_guard<std::mutex> lock(own.mtx);
+		if (!own.tokens.empty()) {
+			auto job = std::move(own.tokens.back());
+			own.tokens.pop_back();
+			return job;
+		}
+	}
+	for (size_t k = 1; k < m_queues.size(); ++k) {
+		auto &other = *m_queues[(index + k) % m_queues.size()];
+		std::lock_guard<std::mutex> lock(other.mtx);
+		if (!other.tokens.empty()) {
+			auto job = std::move(other.tokens.front());
+			other.tokens.pop_front();
+			return job;
+		}
+	}
+	return nullptr;
+}
+
+void WorkPool::Loop(size_t index)
+{
+	while (true) {
+		auto job = Take(index);
+		if (job) {
+			m_pending.fetch_sub(1);
+			///@note the job may be finished already, then no band is left and nothing is called.
+			job->Drain();
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(m_mtx);
+		m_wake.wait(lock, [this] { return m_stop || m_pending.load() > 0; });
+		if (m_stop)return;
+	}
+}
+
+}
@@ -0,0 +1,195 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "util.h"
+
+namespace helmet
+{
+/**
+ * @brief one parallel loop split into bands, shared by the caller and the workers helping it.
+ * @note the body lives on the caller's stack, it is only called for bands claimed before the caller returns.
+ */
+struct WorkJob
+{
+	void (*invoke)(void *body, int begin, int end) = nullptr;
+	void *body = nullptr;
+	int begin = 0;
+	int end = 0;
+	int grain = 1;///< rows per band.
+	int bands = 0;
+	std::atomic_int next = 0;///< next band to be claimed.
+	std::atomic_int done = 0;///< bands finished.
+
+	/**
+	 * @brief claim and run bands until none is left.
+	 */
+	void Drain()
+	{
+		int b;
+		while ((b = next.fetch_add(1, std::memory_order_relaxed)) < bands) {
+			const int first = begin + b * grain;
+			invoke(body, first, std::min(first + grain, end));
+			done.fetch_add(1, std::memory_order_release);
+		}
+	}
+};
+
+/**
+ * @brief process wide work stealing pool for intra frame parallelism on CPU.
+ * @details a parallel loop is split into row bands. The caller posts help tokens to the workers' deques <!--
+ * --> and runs bands itself, every helper claims bands from the same job until none is left, so a slow band <!--
+ * --> never stalls the others. An idle worker pops its own deque first and steals from the others after.
+ * @details the number of bands adapts to load: the pool's threads are shared among the registered streams, <!--
+ * --> so a single stream gets all cores for latency, while with as many streams as cores each frame runs <!--
+ * --> inline on its stream thread and nothing is posted.
+ * @example:
+ * @code
+ * 	WorkPool::Instance().ParallelFor(0, img.rows, 16, [&](int begin, int end) {
+ * 		for (int r = begin; r < end; ++r) ...
+ * 	});
+ * @endcode
+ */
+class WorkPool final
+{
+public:
+	static WorkPool &Instance();
+
+	/**
+	 * @brief set the number of threads the pool is created with, ignored once the pool exists.
+	 * @param threads number of threads, 0 for hardware concurrency.
+	 */
+	static void Configure(unsigned int threads);
+
+	~WorkPool();
+
+	WorkPool(const WorkPool &) = delete;
+	WorkPool &operator=(const WorkPool &) = delete;
+
+	/**
+	 * @brief set the number of threads, including the calling thread of each loop.
+	 * @param threads number of threads, 0 for hardware concurrency, 1 runs everything inline.
+	 * @warning must not be called while a loop is running.
+	 */
+	void SetThreads(unsigned int threads);
+
+	/**
+	 * @brief pin the workers, worker i runs on cpus[i % cpus.size()].
+	 * @param cpus CPU sets, e.g. one per NUMA node, empty to leave the workers unpinned.
+	 * @note kept for the workers started later by SetThreads().
+	 */
+	void SetAffinity(const std::vector<std::vector<int>> &cpus);
+
+	/**
+	 * @brief get the number of threads, including the calling thread.
+	 */
+	unsigned int Threads() const;
+
+	/**
+	 * @brief register or unregister a stream sharing the pool.
+	 */
+	void AddStream();
+	void RemoveStream();
+
+	/**
+	 * @brief get the number of threads one loop may use now.
+	 */
+	unsigned int Width() const;
+
+	/**
+	 * @brief run func(begin, end) over [begin, end) in bands of at least min_grain rows, <!--
+	 * --> only the last band may be shorter.
+	 * @param begin first row.
+	 * @param end one past the last row.
+	 * @param min_grain minimal rows per band.
+	 * @param func callable taking (int band_begin, int band_end).
+	 */
+	template<typename FUNC>
+	void ParallelFor(int begin, int end, int min_grain, FUNC &&func)
+	{
+		if (end <= begin)return;
+		const int rows = end - begin;
+		const int width = (int)std::min<unsigned int>(Width(), (unsigned int)std::max(1, rows / std::max(1, min_grain)));
+		if (width <= 1) {
+			func(begin, end);
+			return;
+		}
+		auto job = createSharedRef<WorkJob>();
+		job->invoke = [](void *body, int b, int e) { (*static_cast<std::remove_reference_t<FUNC> *>(body))(b, e); };
+		job->body = &func;
+		job->begin = begin;
+		job->end = end;
+		///@note a few bands per thread, so helpers arriving late still find work, but none below min_grain.
+		job->bands = std::max(width, std::min(rows / std::max(1, min_grain), width * 4));
+		job->grain = (rows + job->bands - 1) / job->bands;
+		job->bands = (rows + job->grain - 1) / job->grain;
+		Run(job, width - 1);
+	}
+
+private:
+	WorkPool();
+
+	/**
+	 * @brief post helpers, run bands on the calling thread and wait for all bands.
+	 */
+	void Run(const SharedRef<WorkJob> &job, int helpers);
+
+	/**
+	 * @brief worker main loop.
+	 */
+	void Loop(size_t index);
+
+	/**
+	 * @brief pop from own deque or steal from others.
+	 */
+	SharedRef<WorkJob> Take(size_t index);
+
+	void Start(unsigned int threads);
+	void Stop();
+
+private:
+	struct Queue
+	{
+		std::mutex mtx;
+		std::deque<SharedRef<WorkJob>> tokens;
+	};
+
+	std::vector<UniqueRef<Queue>> m_queues;///< one per worker.
+	std::vector<std::thread> m_workers;
+	std::vector<std::vector<int>> m_affinity;
+	std::mutex m_affinity_mtx;
+	std::atomic_uint m_threads = 1;
+	std::atomic_uint m_streams = 0;
+	std::atomic_uint m_next_queue = 0;///< round robin posting.
+	std::atomic_int m_pending = 0;///< tokens posted and not taken.
+	std::mutex m_mtx;///< guards sleeping.
+	std::condition_variable m_wake;
+	bool m_stop = false;
+	static std::atomic_uint s_initial;///< threads the pool is created with.
+};
+
+/**
+ * @brief RAII registration of a stream in WorkPool.
+ */
+class WorkPoolStream final
+{
+public:
+	WorkPoolStream()
+	{
+		WorkPool::Instance().AddStream();
+	}
+	~WorkPoolStream()
+	{
+		WorkPool::Instance().RemoveStream();
+	}
+	WorkPoolStream(const WorkPoolStream &) = delete;
+	WorkPoolStream &operator=(const WorkPoolStream &) = delete;
+};
+
+}
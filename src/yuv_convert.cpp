@@ -0,0 +1,143 @@
+#include <algorithm>
+#include <cassert>
+#include "yuv_convert.h"
+#include "work_pool.h"
+
+namespace helmet
+{
+namespace
+{
+///@note fixed point BT.601 coefficients, identical to OpenCV's YUV420 to RGB conversion.
+constexpr int YUV_SHIFT = 20;
+constexpr int YUV_CY = 1220542;
+constexpr int YUV_CUB = 2116026;
+constexpr int YUV_CUG = -409993;
+constexpr int YUV_CVG = -852492;
+constexpr int YUV_CVR = 1673527;
+constexpr int WEIGHT_SHIFT = 11;
+
+inline unsigned char saturate(int v)
+{
+	return (unsigned char)(v < 0 ? 0 : (v > 255 ? 255 : v));
+}
+
+inline void yuv2bgr(int y, int u, int v, unsigned char *out)
+{
+	const int yy = std::max(0, y - 16) * YUV_CY;
+	const int uu = u - 128;
+	const int vv = v - 128;
+	const int half = 1 << (YUV_SHIFT - 1);
+	out[0] = saturate((yy + YUV_CUB * uu + half) >> YUV_SHIFT);
+	out[1] = saturate((yy + YUV_CVG * vv + YUV_CUG * uu + half) >> YUV_SHIFT);
+	out[2] = saturate((yy + YUV_CVR * vv + half) >> YUV_SHIFT);
+}
+}
+
+cv::Size getPictureSize(const cv::Mat &frame, PixelFormat format)
+{
+	if (format == PixelFormat::BGR)return frame.size();
+	return {frame.cols, frame.rows * 2 / 3};
+}
+
+void YUVResizer::BuildTables(const cv::Size &src, const cv::Size &dst, int interp)
+{
+	if (src == m_src_size && dst == m_dst_size && interp == m_interp)return;
+	m_src_size = src;
+	m_dst_size = dst;
+	m_interp = interp;
+	const float fx = (float)src.width / (float)dst.width;
+	const float fy = (float)src.height / (float)dst.height;
+	const bool linear = interp == cv::INTER_LINEAR;
+
+	auto build = [&](int dst_len, int src_len, float f,
+					 std::vector<int> &i0, std::vector<int> &i1, std::vector<short> &w) {
+		i0.resize(dst_len);
+		i1.resize(dst_len);
+		w.resize(dst_len);
+		for (int i = 0; i < dst_len; ++i) {
+			if (linear) {
+				float s = std::max(0.0f, ((float)i + 0.5f) * f - 0.5f);
+				int s0 = std::min((int)s, src_len - 1);
+				i0[i] = s0;
+				i1[i] = std::min(s0 + 1, src_len - 1);
+				w[i] = (short)((s - (float)s0) * (1 << WEIGHT_SHIFT));
+			}
+			else {
+				///@note same rounding as cv::resize() with cv::INTER_NEAREST.
+				i0[i] = std::min((int)((float)i * f), src_len - 1);
+				i1[i] = i0[i];
+				w[i] = 0;
+			}
+		}
+	};
+	build(dst.width, src.width, fx, m_x0, m_x1, m_wx);
+	build(dst.height, src.height, fy, m_y0, m_y1, m_wy);
+	m_cx.resize(dst.width);
+	for (int i = 0; i < dst.width; ++i) {
+		m_cx[i] = std::min(m_x0[i] + (m_wx[i] >= (1 << (WEIGHT_SHIFT - 1))), src.width - 1) / 2;
+	}
+}
+
+void YUVResizer::Run(const cv::Mat &yuv, PixelFormat format, cv::Mat &dst, const cv::Mat &mask, int interp)
+{
+	assert(format == PixelFormat::NV12 || format == PixelFormat::I420);
+	assert(yuv.type() == CV_8UC1 && yuv.isContinuous() && dst.type() == CV_8UC3);
+	const auto src = getPictureSize(yuv, format);
+	const auto size = dst.size();
+	const bool has_mask = !mask.empty();
+	assert(!has_mask || (mask.type() == CV_8UC1 && mask.size() == size));
+	BuildTables(src, size, interp);
+
+	const unsigned char *y_plane = yuv.data;
+	const unsigned char *u_plane = y_plane + (size_t)src.width * src.height;
+	const unsigned char *v_plane = u_plane + (size_t)(src.width / 2) * (src.height / 2);
+	const bool nv12 = format == PixelFormat::NV12;
+	const bool linear = m_interp == cv::INTER_LINEAR;
+
+	///@note rows are independent, bands are spread over the shared pool.
+	WorkPool::Instance().ParallelFor(0, size.height, 16, [&](int begin, int end) {
+	for (int r = begin; r < end; ++r) {
+		auto *out = dst.ptr<unsigned char>(r);
+		const auto *m = has_mask ? mask.ptr<unsigned char>(r) : nullptr;
+		const int sy0 = m_y0[r];
+		const int sy1 = m_y1[r];
+		const int wy = m_wy[r];
+		const int cy = std::min(sy0 + (wy >= (1 << (WEIGHT_SHIFT - 1))), src.height - 1) / 2;
+		const auto *y_row0 = y_plane + (size_t)sy0 * src.width;
+		const auto *y_row1 = y_plane + (size_t)sy1 * src.width;
+		const auto *uv_row = u_plane + (size_t)cy * src.width;
+		const auto *u_row = u_plane + (size_t)cy * (src.width / 2);
+		const auto *v_row = v_plane + (size_t)cy * (src.width / 2);
+		for (int c = 0; c < size.width; ++c, out += 3) {
+			if (m && !m[c]) {
+				out[0] = out[1] = out[2] = 0;
+				continue;
+			}
+			int y;
+			if (linear) {
+				const int x0 = m_x0[c], x1 = m_x1[c], wx = m_wx[c];
+				const int top = y_row0[x0] * ((1 << WEIGHT_SHIFT) - wx) + y_row0[x1] * wx;
+				const int bottom = y_row1[x0] * ((1 << WEIGHT_SHIFT) - wx) + y_row1[x1] * wx;
+				y = (top * ((1 << WEIGHT_SHIFT) - wy) + bottom * wy + (1 << (2 * WEIGHT_SHIFT - 1)))
+					>> (2 * WEIGHT_SHIFT);
+			}
+			else {
+				y = y_row0[m_x0[c]];
+			}
+			const int cx = m_cx[c];
+			int u, v;
+			if (nv12) {
+				u = uv_row[2 * cx];
+				v = uv_row[2 * cx + 1];
+			}
+			else {
+				u = u_row[cx];
+				v = v_row[cx];
+			}
+			yuv2bgr(y, u, v, out);
+		}
+	}
+	});
+}
+
+}
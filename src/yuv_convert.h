@@ -0,0 +1,69 @@
+#pragma once
+
+#include <vector>
+#include <opencv2/imgproc.hpp>
+#include "util.h"
+
+namespace helmet
+{
+/**
+ * @brief pixel layout of input frames.
+ * @note planar YUV frames are stored as a single channel cv::Mat with height*3/2 rows, same as OpenCV convention.
+ */
+enum class PixelFormat
+{
+	BGR = 0,///< packed 8 bit BGR, i.e. CV_8UC3.
+	NV12 = 1,///< Y plane followed by interleaved UV plane, 4:2:0 subsampled.
+	I420 = 2 ///< Y plane followed by U plane and V plane, 4:2:0 subsampled.
+};
+
+/**
+ * @brief get the size of the picture stored in a frame.
+ * @param frame input frame.
+ * @param format pixel layout of frame.
+ * @return picture size, i.e. the size of Y plane for YUV frames.
+ */
+extern cv::Size getPictureSize(const cv::Mat &frame, PixelFormat format);
+
+/**
+ * @brief fused colour conversion and downscale from planar YUV to packed 8 bit 3 channels image.
+ * @details only the sampled source pixels are converted, thus for 1080p to 608x608 roughly 1/5 of the <!--
+ * --> colour conversion work of cv::cvtColor() followed by cv::resize() is done. BT.601 limited range is <!--
+ * --> used as cv::COLOR_YUV2BGR_NV12 does.
+ * @note the output channel order is BGR, the same as frames fed by the BGR input path.
+ * @note the sampling tables are cached, the object should be reused across frames of the same stream.
+ */
+class YUVResizer final
+{
+public:
+	/**
+	 * @brief convert and resize one frame.
+	 * @param yuv input frame, CV_8UC1 with height*3/2 rows.
+	 * @param format NV12 or I420.
+	 * @param dst output image, must be allocated as CV_8UC3 of target size, can be a header over pinned memory.
+	 * @param mask optional CV_8UC1 mask of target size, output pixels with zero mask are set to zero.
+	 * @param interp cv::INTER_NEAREST or cv::INTER_LINEAR, the latter only interpolates luma.
+	 */
+	void Run(const cv::Mat &yuv, PixelFormat format, cv::Mat &dst,
+			 const cv::Mat &mask = cv::Mat(), int interp = cv::INTER_NEAREST);
+
+private:
+	/**
+	 * @brief rebuild the sampling tables if the source or target size changes.
+	 */
+	void BuildTables(const cv::Size &src, const cv::Size &dst, int interp);
+
+private:
+	cv::Size m_src_size;
+	cv::Size m_dst_size;
+	int m_interp = -1;
+	std::vector<int> m_x0;///< left source column for each target column.
+	std::vector<int> m_x1;///< right source column, used by bilinear.
+	std::vector<short> m_wx;///< weight of right column, in 1/2048.
+	std::vector<int> m_y0;///< top source row for each target row.
+	std::vector<int> m_y1;///< bottom source row, used by bilinear.
+	std::vector<short> m_wy;///< weight of bottom row, in 1/2048.
+	std::vector<int> m_cx;///< chroma column for each target column.
+};
+
+}
@@ -0,0 +1,122 @@
+#include <string>
+#include "alarm_engine.h"
+#include "test_util.h"
+
+using namespace helmet;
+
+static const int64_t MS = 1000;
+
+static AlarmParams testParams()
+{
+	AlarmParams params;
+	params.window_us = 1000 * MS;
+	params.on_ratio = 0.6f;
+	params.off_ratio = 0.3f;
+	params.min_evidence = 3;
+	params.cooldown_us = 3000 * MS;
+	return params;
+}
+
+/**
+ * @brief add one inference every 100 ms from begin to end, positive or not, and evaluate after each.
+ * @return number of alarms raised.
+ */
+static int feed(AlarmEngine &engine, int64_t begin_ms, int64_t end_ms, bool positive)
+{
+	int alarms = 0;
+	for (int64_t t = begin_ms; t < end_ms; t += 100) {
+		engine.Begin();
+		if (positive)engine.Mark(0);
+		engine.Commit(t * MS);
+		alarms += engine.Evaluate(t * MS) ? 1 : 0;
+	}
+	return alarms;
+}
+
+/**
+ * @brief evidence older than the window is forgotten, also without new inferences.
+ */
+static void testWindowExpiry()
+{
+	AlarmWindow window(64);
+	for (int i = 0; i < 10; ++i) {
+		window.Add(i * 100 * MS, i % 2 == 0);
+	}
+	expect(window.Total() == 10 && window.Positives() == 5, "window holds all evidence");
+	window.Expire(1450 * MS, 1000 * MS);
+	expect(window.Total() == 5 && window.Positives() == 2, "evidence before 450 ms expired, " +
+		   std::to_string(window.Total()) + " left");
+	window.Expire(2000 * MS, 1000 * MS);
+	expect(window.Total() == 0 && window.Ratio() == 0.0f, "all evidence expired");
+
+	AlarmWindow small(4);
+	for (int i = 0; i < 6; ++i) {
+		small.Add(i * MS, i < 2);
+	}
+	expect(small.Total() == 4 && small.Positives() == 0, "a full ring forgets the oldest evidence");
+}
+
+/**
+ * @brief a region needs min_evidence inferences and on_ratio before it switches on.
+ */
+static void testMinEvidence()
+{
+	AlarmEngine engine;
+	engine.Configure(testParams(), 1, 1, 64);
+	expect(feed(engine, 0, 200, true) == 0 && !engine.Active(0), "no alarm before min evidence");
+	expect(feed(engine, 200, 300, true) == 1 && engine.Active(0), "alarm at min evidence");
+}
+
+/**
+ * @brief an active region alarms again only every cooldown, and switches off once the window drains.
+ */
+static void testCooldown()
+{
+	AlarmEngine engine;
+	engine.Configure(testParams(), 1, 1, 64);
+	///@note positive for 5 s: alarms at 200 ms, 3200 ms.
+	expect(feed(engine, 0, 5000, true) == 2, "one alarm per cooldown while on");
+	///@note negative inferences drain the window until the ratio drops to off_ratio.
+	expect(feed(engine, 5000, 6000, false) == 0 && !engine.Active(0), "region off after the window drained");
+	///@note switching on again alarms at once if the cooldown has passed since the last alarm.
+	expect(feed(engine, 6000, 7000, true) >= 1, "alarm after switching on again");
+
+	AlarmEngine early;
+	early.Configure(testParams(), 1, 1, 64);
+	feed(early, 0, 1000, true);
+	feed(early, 1000, 2000, false);
+	expect(feed(early, 2000, 2900, true) == 0, "no alarm within the cooldown after switching on again");
+}
+
+/**
+ * @brief without new inferences the window expires on Evaluate() and the region switches off.
+ */
+static void testExpiryWithoutInference()
+{
+	AlarmEngine engine;
+	engine.Configure(testParams(), 2, 2, 64);
+	feed(engine, 0, 1000, true);
+	expect(engine.Active(0) && !engine.Active(1), "only the marked region is on");
+	engine.Evaluate(1500 * MS);
+	expect(engine.Active(0), "still on within the window");
+	engine.Evaluate(3000 * MS);
+	expect(!engine.Active(0) && engine.Ratio(0) == 0.0f, "off once the evidence expired");
+}
+
+static void testGridCell()
+{
+	expect(gridCell(0, 0, 640, 480, 2, 2) == 0, "top left cell");
+	expect(gridCell(639, 479, 640, 480, 2, 2) == 3, "bottom right cell");
+	expect(gridCell(-10, 900, 640, 480, 2, 2) == 2, "points outside the frame are clamped");
+	expect(gridCell(10, 10, 0, 480, 2, 2) == 0, "empty frame");
+}
+
+int main(int argc, char **argv)
+{
+	testWindowExpiry();
+	testMinEvidence();
+	testCooldown();
+	testExpiryWithoutInference();
+	testGridCell();
+	return testResult();
+}
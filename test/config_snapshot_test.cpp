@@ -0,0 +1,84 @@
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include "config_snapshot.h"
+#include "test_util.h"
+
+using namespace helmet;
+
+/**
+ * @brief snapshot whose fields are written together, a torn read would show them apart.
+ */
+struct Pair
+{
+	int64_t a = 0;
+	int64_t b = 0;
+	std::vector<int64_t> payload;///< freed snapshots are caught by sanitizers.
+};
+
+/**
+ * @brief readers see complete snapshots with non decreasing versions while writers publish.
+ */
+static void testConcurrentUpdates()
+{
+	RcuCell<Pair> cell(createUniqueRef<Pair>());
+	std::atomic_bool stop(false);
+	std::atomic_int torn(0);
+	std::atomic_int backwards(0);
+	std::vector<std::thread> readers;
+	for (int r = 0; r < 4; ++r) {
+		readers.emplace_back([&]() {
+			int64_t last = 0;
+			while (!stop.load()) {
+				RcuCell<Pair>::ReadGuard snap(cell);
+				if (snap->a != snap->b || snap->payload.size() != (size_t)(snap->a % 16))torn++;
+				if (snap->a < last)backwards++;
+				last = snap->a;
+			}
+		});
+	}
+	std::vector<std::thread> writers;
+	for (int w = 0; w < 2; ++w) {
+		writers.emplace_back([&]() {
+			for (int i = 0; i < 5000; ++i) {
+				cell.Update([](Pair &next) {
+					next.a++;
+					next.payload.assign((size_t)(next.a % 16), next.a);
+					next.b = next.a;
+				});
+			}
+		});
+	}
+	for (auto &t : writers) {
+		t.join();
+	}
+	stop = true;
+	for (auto &t : readers) {
+		t.join();
+	}
+	RcuCell<Pair>::ReadGuard snap(cell);
+	expect(torn == 0, std::to_string(torn.load()) + " torn reads");
+	expect(backwards == 0, std::to_string(backwards.load()) + " reads went back in time");
+	expect(snap->a == 10000 && snap->b == 10000, "no update lost, " + std::to_string(snap->a));
+}
+
+/**
+ * @brief Publish() replaces the snapshot, Copy() gives a private copy.
+ */
+static void testPublishAndCopy()
+{
+	RcuCell<Pair> cell(createUniqueRef<Pair>());
+	auto next = cell.Copy();
+	next->a = next->b = 7;
+	expect(RcuCell<Pair>::ReadGuard(cell)->a == 0, "copy is private");
+	cell.Publish(std::move(next));
+	expect(RcuCell<Pair>::ReadGuard(cell)->a == 7, "published snapshot read");
+}
+
+int main(int argc, char **argv)
+{
+	testConcurrentUpdates();
+	testPublishAndCopy();
+	return testResult();
+}
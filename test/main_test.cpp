@@ -1,5 +1,178 @@
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <yaml-cpp/yaml.h>
+#include "config.h"
+#include "latency_stats.h"
+#include "mock_deploy.h"
+#include "model.h"
+#include "postprocessor.h"
+#include "trt_deployresult.h"
+#include "test_util.h"
 
+using namespace helmet;
 
-int main(int argc, char** argv){
+/**
+ * @brief load the shipped config and reduce it to one scripted target box and the count alarm.
+ */
+static SharedRef<Config> testConfig(const std::string &file)
+{
+	auto config = createSharedRef<Config>(0, nullptr, file);
+	config->BACKEND = "mock";
+	config->NMS_MODE = "model";
+	config->OUTPUT_SHAPES = {{100, 6}, {1}};
+	config->TARGET_SIZE = {608, 608};
+	config->TARGET_CLASS = 0;
+	config->SCORE_THRESHOLD = 0.6f;
+	config->ALARM_MODE = "count";
+	config->ALARM_COUNT = 2;
+	config->SMOOTH_METHOD = "none";
+	config->TRIGGER_LEN = 1;
+	config->MOCK_DETS = {0, 0.9f, 100, 120, 180, 300};
+	config->MOCK_LATENCY_MS = 0.0f;
+	return config;
+}
 
-}
\ No newline at end of file
+/**
+ * @brief MOCK_PATTERN drives the count alarm: +2 per frame with a target, -1 without, alarm above 2 * ALARM_COUNT.
+ */
+static void testMockAlarmSequence(const std::string &file)
+{
+	auto config = testConfig(file);
+	config->MOCK_PATTERN = "10";
+	auto deploy = createSharedRef<MockDeploy>(config);
+	auto res = createSharedRef<TrtResults>(config);
+	///@note twice as wide as TARGET_SIZE, boxes are scaled back by 2 horizontally.
+	cv::Mat frame(608, 1216, CV_8UC3, cv::Scalar::all(0));
+
+	const std::string expected = "00000010000000";
+	std::string alarms;
+	std::vector<Box> dets;
+	for (size_t i = 0; i < expected.size(); ++i) {
+		deploy->Infer(frame, res);
+		int alarm = 0;
+		deploy->Postprocessing(res, frame.size(), alarm);
+		alarms += alarm ? '1' : '0';
+		deploy->Detections(dets);
+		expect(dets.size() == (i % 2 == 0 ? 1u : 0u), "mock frame " + std::to_string(i) + " boxes");
+	}
+	expect(alarms == expected, "alarm sequence " + alarms + ", expected " + expected);
+	expect(deploy->Calls() == expected.size(), "mock inference count");
+}
+
+/**
+ * @brief multiclass_nms3 style outputs are decoded, thresholded and scaled to the raw frame.
+ */
+static void testDecode(const std::string &file)
+{
+	auto config = testConfig(file);
+	Postprocessor post(config);
+	auto res = createSharedRef<TrtResults>(config);
+	const cv::Size frame(1216, 304);
+	const std::vector<float> rows = {0, 0.9f, 100, 120, 180, 300,
+									 1, 0.3f, 300, 120, 380, 300};
+
+	std::vector<float> dets(100 * 6, 0.0f);
+	for (size_t j = 0; j < 100; ++j) {
+		dets[j * 6] = -1.0f;
+	}
+	std::copy(rows.begin(), rows.end(), dets.begin());
+	res->Set(std::make_pair(config->OUTPUT_NAMES[0], dets));
+	res->Set(std::make_pair(config->OUTPUT_NAMES[1], std::vector<float>{2.0f}));
+	res->Stamp(steadyMicros());
+	int alarm = 0;
+	std::vector<Box> boxes;
+	post.Run(res, frame, alarm);
+	post.Detections(boxes);
+	expect(boxes.size() == 1, "decoded boxes above the score threshold");
+	if (boxes.size() == 1) {
+		const auto &b = boxes[0];
+		expect(b.class_id == 0 && b.x_min == 200 && b.y_min == 60 && b.x_max == 360 && b.y_max == 150,
+			   "decoded box scaled to the raw frame");
+	}
+
+	///@note a data dependent output holds only the kept rows.
+	res->Set(std::make_pair(config->OUTPUT_NAMES[0], rows));
+	res->Stamp(steadyMicros());
+	post.Run(res, frame, alarm);
+	post.Detections(boxes);
+	expect(boxes.size() == 1, "decoded boxes of a data dependent output");
+
+	res->Clear();
+	post.Run(res, frame, alarm);
+	post.Detections(boxes);
+	expect(boxes.empty() && alarm == 0, "no boxes without outputs");
+}
+
+/**
+ * @brief frames passed through during a slow Prepare_Algorithm keep the cadence, so a caller decoding <!--
+ * --> only every Frameinterval-th frame gets all of them inferred once the backend is ready.
+ * @note Allocate_Algorithm reads ./helmet_detection.yaml, it is written from the shipped config.
+ */
+static void testPassThroughCadence(const std::string &file)
+{
+	auto yaml = YAML::LoadFile(file);
+	auto node = yaml["MODEL"];
+	node["BACKEND"] = "mock";
+	node["MOCK_PATTERN"] = "1";
+	node["MOCK_LATENCY_MS"] = 40.0f;
+	node["WARMUP_NUM"] = 5;
+	node["SAMPLE_DATA"] = 3;
+	node["PASS_THROUGH"] = true;
+	node["TIMING"] = true;
+	node["TIMING_FILE"] = "";
+	node["TRACE"] = false;
+	node["EVIDENCE"] = false;
+	node["PLACEMENT"] = "none";
+	{
+		std::ofstream out("./helmet_detection.yaml", std::ios::out | std::ios::trunc);
+		out << yaml;
+	}
+
+	cv::Mat frame(360, 640, CV_8UC3, cv::Scalar::all(0));
+	cvModel *models = Allocate_Algorithm(frame, IA_TYPE_PEOPLEHELME_DETECTION, 0);
+	SetPara_Algorithm(models, IA_TYPE_PEOPLEHELME_DETECTION);
+	UpdateParams_Algorithm(models);
+	Prepare_Algorithm(models, -1);
+	const int interval = models->Frameinterval;
+
+	///@note like main.cpp in headless mode, only every interval-th frame is decoded, the others are skipped.
+	int passed = 0;
+	int decoded = 0;
+	long inferred = 0;
+	bool ready = false;
+	for (int i = 0; i < 2000 && decoded < 10; ++i) {
+		if (!ready && IsReady_Algorithm(models) == READY_OK) {
+			ready = true;
+			inferred = GetLatency_Algorithm(models, (int)Stage::INFER, nullptr);
+		}
+		if (i % interval != 0) {
+			Skip_Algorithm(models);
+			continue;
+		}
+		Process_Algorithm(models, frame);
+		if (ready)decoded++;
+		else {
+			passed++;
+			std::this_thread::sleep_for(std::chrono::milliseconds(7));
+		}
+	}
+	inferred = GetLatency_Algorithm(models, (int)Stage::INFER, nullptr) - inferred;
+	expect(passed > 0, "frames passed through while preparing");
+	expect(decoded == 10, "backend ready after preparing");
+	expect(inferred == decoded, "inferred " + std::to_string(inferred) + " of " + std::to_string(decoded) +
+								" decoded frames after " + std::to_string(passed) + " passed through");
+	Destroy_Algorithm(models);
+}
+
+int main(int argc, char **argv)
+{
+	const std::string file = argc > 1 ? argv[1] : "../config/helmet_detection.yaml";
+	testMockAlarmSequence(file);
+	testDecode(file);
+	testPassThroughCadence(file);
+	return testResult();
+}
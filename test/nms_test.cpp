@@ -0,0 +1,89 @@
+#include <random>
+#include <string>
+#include "nms.h"
+#include "test_util.h"
+
+using namespace helmet;
+
+/**
+ * @brief random boxes clustered around a few objects, with duplicated scores and boxes touching the IoU threshold.
+ */
+static void genBoxes(int num, int classes, unsigned int seed, BoxesSoA &boxes)
+{
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<float> uni(0.0f, 1.0f);
+	std::normal_distribution<float> jitter(0.0f, 8.0f);
+	boxes.Clear();
+	for (int i = 0; i < num; ++i) {
+		const float cx = 50.0f + (float)(i % 13) * 40.0f + jitter(rng);
+		const float cy = 50.0f + (float)(i % 7) * 60.0f + jitter(rng);
+		const float w = 20.0f + uni(rng) * 80.0f;
+		const float h = 20.0f + uni(rng) * 100.0f;
+		///@note quantized scores give ties, which must be broken by index in every kernel.
+		const float score = (float)(int)(uni(rng) * 20.0f) / 20.0f;
+		boxes.Push(cx - w / 2, cy - h / 2, cx + w / 2, cy + h / 2, score, (int)(uni(rng) * classes));
+	}
+	///@note two boxes at exactly half overlap: inter 50, union 100.
+	boxes.Push(0.0f, 0.0f, 10.0f, 7.5f, 0.99f, 0);
+	boxes.Push(0.0f, 2.5f, 10.0f, 10.0f, 0.98f, 0);
+}
+
+/**
+ * @brief every kernel the CPU supports keeps the same boxes as the scalar one.
+ */
+static void testKernelsAgree()
+{
+	NmsParams params;
+	params.score_threshold = 0.1f;
+	params.pre_top_k = 0;
+	params.top_k = 0;
+	BoxesSoA boxes;
+	HostNms scalar, vector;
+	expect(scalar.SetKernel(NmsKernel::SCALAR), "scalar kernel always supported");
+	std::vector<int> expected, keep;
+	for (int num : {1, 3, 7, 8, 9, 17, 100, 1000}) {
+		for (float iou : {0.3f, 0.45f, 0.5f, 0.7f}) {
+			params.iou_threshold = iou;
+			genBoxes(num, 3, (unsigned int)num, boxes);
+			scalar.Run(boxes, params, expected);
+			for (auto kernel : {NmsKernel::SSE, NmsKernel::AVX}) {
+				if (!vector.SetKernel(kernel)) {
+					std::cout << "Kernel " << (int)kernel << " not supported, skipped." << std::endl;
+					continue;
+				}
+				vector.Run(boxes, params, keep);
+				expect(keep == expected, "kernel " + std::to_string((int)kernel) + " at " + std::to_string(num) +
+										 " boxes, iou " + std::to_string(iou) + ": " + std::to_string(keep.size()) +
+										 " vs " + std::to_string(expected.size()) + " kept");
+			}
+		}
+	}
+}
+
+/**
+ * @brief the division free test keeps a box at exactly the IoU threshold, classes never suppress each other.
+ */
+static void testThresholdAndClasses()
+{
+	NmsParams params;
+	params.iou_threshold = 0.5f;
+	BoxesSoA boxes;
+	boxes.Push(0.0f, 0.0f, 10.0f, 7.5f, 0.9f, 0);
+	boxes.Push(0.0f, 2.5f, 10.0f, 10.0f, 0.8f, 0);
+	boxes.Push(0.0f, 0.0f, 10.0f, 7.5f, 0.7f, 1);
+	boxes.Push(0.0f, 0.0f, 10.0f, 7.6f, 0.6f, 0);
+	HostNms nms;
+	std::vector<int> keep;
+	nms.Run(boxes, params, keep);
+	expect(keep == std::vector<int>({0, 1, 2}), "iou == threshold kept, other class kept, duplicate suppressed");
+	params.top_k = 1;
+	nms.Run(boxes, params, keep);
+	expect(keep == std::vector<int>({0}), "top k");
+}
+
+int main(int argc, char **argv)
+{
+	testKernelsAgree();
+	testThresholdAndClasses();
+	return testResult();
+}
@@ -0,0 +1,39 @@
+#include <string>
+#include <vector>
+#include "placement.h"
+#include "test_util.h"
+
+using namespace helmet;
+
+/**
+ * @brief lists as found in /sys/devices/system/cpu and /sys/devices/system/node.
+ */
+static void testWellFormed()
+{
+	std::vector<int> cpus;
+	expect(parseCpuList("0-3,8,10-11", cpus) && cpus == std::vector<int>({0, 1, 2, 3, 8, 10, 11}), "ranges and ids");
+	expect(parseCpuList("0-3,8,10-11\n", cpus) && cpus.size() == 7, "trailing newline of sysfs");
+	expect(parseCpuList(" 4 , 2-3 ", cpus) && cpus == std::vector<int>({2, 3, 4}), "blanks around items");
+	expect(parseCpuList("5,1-6,3", cpus) && cpus == std::vector<int>({1, 2, 3, 4, 5, 6}), "sorted and unique");
+	expect(parseCpuList("", cpus) && cpus.empty(), "empty list");
+	expect(parseCpuList("1,,2", cpus) && cpus == std::vector<int>({1, 2}), "empty items skipped");
+}
+
+/**
+ * @brief malformed lists are rejected instead of parsed partially, huge ranges are not expanded.
+ */
+static void testMalformed()
+{
+	std::vector<int> cpus;
+	for (const std::string text : {"a", "1x", "x1", "1-", "-1", "-", "1-2-3", "3-1", "1--2", "1 2", "1-a",
+								   "0-999999999", "99999999999999999999", "1.5", "+1", "0x10"}) {
+		expect(!parseCpuList(text, cpus), "\"" + text + "\" rejected");
+	}
+}
+
+int main(int argc, char **argv)
+{
+	testWellFormed();
+	testMalformed();
+	return testResult();
+}
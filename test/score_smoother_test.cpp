@@ -0,0 +1,80 @@
+#include <algorithm>
+#include <string>
+#include "score_smoother.h"
+#include "test_util.h"
+
+using namespace helmet;
+
+static const int64_t INTERVAL_US = 100000;
+
+/**
+ * @brief feed one spike of score on the first inference, then clean inferences.
+ * @return highest smoothed score of the cell seen after any inference.
+ */
+static float spikePeak(SmoothMethod method, float score)
+{
+	ScoreSmoother smoother;
+	smoother.Configure(1, 8, 600000);
+	float peak = 0.0f;
+	for (int i = 0; i < 10; ++i) {
+		smoother.Begin();
+		if (i == 0)smoother.Add(0, score);
+		smoother.Commit(i * INTERVAL_US);
+		peak = std::max(peak, smoother.Score(0, method));
+	}
+	return peak;
+}
+
+/**
+ * @brief a single false positive on the first frame of a stream must not reach the threshold.
+ */
+static void testFirstFrameSpike()
+{
+	const float threshold = 0.5f;
+	const float ema = spikePeak(SmoothMethod::EMA, 0.95f);
+	expect(ema < threshold, "ema after a first frame spike " + std::to_string(ema));
+	const float mean = spikePeak(SmoothMethod::MEAN, 0.95f);
+	expect(mean < threshold, "mean after a first frame spike " + std::to_string(mean));
+}
+
+/**
+ * @brief a spike later in the stream is weighted by the time it stands for, then decays.
+ */
+static void testLaterSpike()
+{
+	ScoreSmoother smoother;
+	smoother.Configure(2, 8, 600000);
+	for (int i = 0; i < 20; ++i) {
+		smoother.Begin();
+		if (i == 10)smoother.Add(1, 0.95f);
+		smoother.Commit(i * INTERVAL_US);
+		expect(smoother.Ema(0) == 0.0f, "clean cell stays at 0");
+		expect(smoother.Ema(1) < 0.5f, "spike at inference " + std::to_string(i) + " below the threshold");
+	}
+	expect(smoother.Ema(1) > 0.0f && smoother.Ema(1) < 0.05f, "spike decayed");
+}
+
+/**
+ * @brief a steady target reaches the threshold after a few inferences.
+ */
+static void testSteadyTarget()
+{
+	ScoreSmoother smoother;
+	smoother.Configure(1, 8, 600000);
+	int reached = -1;
+	for (int i = 0; i < 20 && reached < 0; ++i) {
+		smoother.Begin();
+		smoother.Add(0, 0.9f);
+		smoother.Commit(i * INTERVAL_US);
+		if (smoother.Ema(0) >= 0.5f)reached = i;
+	}
+	expect(reached > 1, "steady target reached the threshold at inference " + std::to_string(reached));
+}
+
+int main(int argc, char **argv)
+{
+	testFirstFrameSpike();
+	testLaterSpike();
+	testSteadyTarget();
+	return testResult();
+}
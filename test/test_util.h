@@ -0,0 +1,40 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+
+namespace helmet
+{
+/**
+ * @brief get the number of failed expectations of the test executable.
+ */
+inline int &testFailures()
+{
+	static int failures = 0;
+	return failures;
+}
+
+/**
+ * @brief report a failed expectation and keep running the other checks.
+ */
+inline void expect(bool ok, const std::string &what)
+{
+	if (ok)return;
+	std::cerr << "FAILED: " << what << std::endl;
+	testFailures()++;
+}
+
+/**
+ * @brief print the summary, the exit code of main().
+ */
+inline int testResult()
+{
+	if (testFailures()) {
+		std::cerr << testFailures() << " check(s) failed." << std::endl;
+		return 1;
+	}
+	std::cout << "All checks passed." << std::endl;
+	return 0;
+}
+
+}
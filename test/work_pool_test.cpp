@@ -0,0 +1,99 @@
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include "work_pool.h"
+#include "test_util.h"
+
+using namespace helmet;
+
+/**
+ * @brief every row of [begin, end) is visited exactly once, by bands within the range.
+ */
+static void checkCoverage(int begin, int end, int min_grain, const std::string &what)
+{
+	const int rows = std::max(0, end - begin);
+	std::vector<std::atomic_int> visits(rows);
+	std::atomic_int bands(0);
+	std::atomic_bool outside(false);
+	std::atomic_bool small(false);
+	WorkPool::Instance().ParallelFor(begin, end, min_grain, [&](int b, int e) {
+		bands++;
+		if (b < begin || e > end || b >= e) {
+			outside = true;
+			return;
+		}
+		///@note only the last band may be shorter than the grain, and only if the range is.
+		if (e - b < min_grain && e != end)small = true;
+		for (int r = b; r < e; ++r) {
+			visits[r - begin]++;
+		}
+	});
+	bool once = true;
+	for (auto &v : visits) {
+		once = once && v.load() == 1;
+	}
+	expect(!outside, what + ": bands within the range");
+	expect(once, what + ": every row visited once");
+	expect(!small, what + ": bands of at least the grain");
+	expect(rows > 0 || bands == 0, what + ": empty range runs nothing");
+}
+
+static void testCoverage()
+{
+	WorkPool::Instance().SetThreads(4);
+	checkCoverage(0, 0, 1, "empty");
+	checkCoverage(5, 3, 1, "reversed");
+	checkCoverage(0, 1, 1, "one row");
+	checkCoverage(0, 7, 1, "fewer rows than bands");
+	checkCoverage(0, 1080, 16, "frame rows");
+	checkCoverage(-13, 1001, 8, "negative begin, odd size");
+	checkCoverage(0, 64, 16, "few bands of the grain");
+	checkCoverage(0, 100, 1000, "grain above the rows");
+}
+
+/**
+ * @brief loops of several streams at once share the pool without losing bands.
+ */
+static void testConcurrentStreams()
+{
+	WorkPool::Instance().SetThreads(4);
+	std::vector<std::thread> streams;
+	for (int s = 0; s < 3; ++s) {
+		streams.emplace_back([s]() {
+			WorkPoolStream stream;
+			for (int i = 0; i < 50; ++i) {
+				checkCoverage(0, 480 + s * 17 + i, 4, "stream " + std::to_string(s));
+			}
+		});
+	}
+	for (auto &t : streams) {
+		t.join();
+	}
+}
+
+/**
+ * @brief the width follows the number of registered streams.
+ */
+static void testWidth()
+{
+	auto &pool = WorkPool::Instance();
+	pool.SetThreads(4);
+	expect(pool.Threads() == 4 && pool.Width() == 4, "one stream gets all threads");
+	{
+		WorkPoolStream a, b;
+		expect(pool.Width() == 2, "two streams share the threads");
+		WorkPoolStream c, d, e;
+		expect(pool.Width() == 1, "more streams than threads run inline");
+	}
+	pool.SetThreads(1);
+	checkCoverage(0, 100, 1, "inline pool");
+}
+
+int main(int argc, char **argv)
+{
+	testCoverage();
+	testConcurrentStreams();
+	testWidth();
+	return testResult();
+}